@@ -0,0 +1,640 @@
+#pragma once
+
+#include "base.hpp"
+#include "complex.hpp"
+#include "decompositions.hpp"
+#include "dynamic.hpp"
+#include "parallel.hpp"
+#include "products.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace math
+{
+
+// Square band matrix of order n with lower subdiagonals and upper superdiagonals, in
+// O(n*(lower + upper)) storage. Row i holds columns i-lower .. i+upper, so the entries of a row
+// are contiguous for the vector kernels; slots before column 0 and past column n-1 hold zero.
+template <typename T>
+class BandMatrix
+{
+    private:
+        int lower_ = 0;
+        int upper_ = 0;
+        DynamicMatrix<T> band_;
+
+    public:
+        BandMatrix() = default;
+
+        BandMatrix(int n, int lower, int upper)
+        : lower_(lower), upper_(upper), band_(zero_initialize, n, lower + upper + 1) {}
+
+        int order() const
+        {
+            return band_.length();
+        }
+
+        int lower() const
+        {
+            return lower_;
+        }
+
+        int upper() const
+        {
+            return upper_;
+        }
+
+        int first_column(int row) const
+        {
+            return std::max(0, row - lower_);
+        }
+
+        int last_column(int row) const
+        {
+            return std::min(order() - 1, row + upper_);
+        }
+
+        // Entry (row, column) in the storage of row, for column within the row's band
+        T* entry(int row, int column)
+        {
+            return band_(row).data() + (column - row + lower_);
+        }
+
+        const T* entry(int row, int column) const
+        {
+            return band_(row).data() + (column - row + lower_);
+        }
+
+        T& operator()(int row, int column)
+        {
+            return *entry(row, column);
+        }
+
+        const T& operator()(int row, int column) const
+        {
+            return *entry(row, column);
+        }
+
+        // Element anywhere in the matrix, zero outside the band
+        T element(int row, int column) const
+        {
+            bool stored = column >= row - lower_ && column <= row + upper_;
+            return stored ? (*this)(row, column) : static_cast<T>(0);
+        }
+};
+
+// Copies the band of a square matrix; entries outside it are not read
+template <typename T>
+BandMatrix<T> pack_band(const DynamicMatrix<T>& A, int lower, int upper)
+{
+    check_square(A);
+    int n = A.length();
+    BandMatrix<T> band(n, lower, upper);
+    for(int row = 0; row < n; ++row)
+    {
+        for(int column = band.first_column(row); column <= band.last_column(row); ++column)
+        {
+            band(row, column) = A(row, column);
+        }
+    }
+    return band;
+}
+
+template <typename T>
+DynamicMatrix<T> unpack(const BandMatrix<T>& A)
+{
+    int n = A.order();
+    DynamicMatrix<T> full(n, n);
+    for(int row = 0; row < n; ++row)
+    {
+        for(int column = 0; column < n; ++column)
+        {
+            full(row, column) = A.element(row, column);
+        }
+    }
+    return full;
+}
+
+// y = alpha*op(A)*x + beta*y into the caller's y; y must not alias x
+template <typename T>
+DynamicVector<T>& gemv(T alpha, const BandMatrix<T>& A, Transpose transpose_A, const DynamicVector<T>& x, T beta, DynamicVector<T>& y)
+{
+    int n = A.order();
+    if(x.length() != n)
+    {
+        throw MismatchedLength(x.length(), n);
+    }
+    if(y.length() != n)
+    {
+        throw MismatchedLength(y.length(), n);
+    }
+    scale(y, beta);
+    if(alpha == static_cast<T>(0))
+    {
+        return y;
+    }
+    int width = A.lower() + A.upper() + 1;
+    if(transpose_A == Transpose::No)
+    {
+        parallel_for(0, n, grain_size(width), [&](int begin, int end)
+        {
+            for(int row = begin; row < end; ++row)
+            {
+                int first = A.first_column(row);
+                y(row) += alpha*dot(A.last_column(row) - first + 1, A.entry(row, first), x.data() + first);
+            }
+        });
+    }
+    else
+    {
+        // Threads take disjoint ranges of y and add the slices of the rows whose band reaches it
+        parallel_for(0, n, grain_size(width), [&](int begin, int end)
+        {
+            int last_row = std::min(n - 1, end - 1 + A.lower());
+            for(int inner = std::max(0, begin - A.upper()); inner <= last_row; ++inner)
+            {
+                int first = std::max(begin, A.first_column(inner));
+                int last = std::min(end - 1, A.last_column(inner));
+                if(first > last)
+                {
+                    continue;
+                }
+                if(transpose_A == Transpose::ConjugateTranspose)
+                {
+                    axpyc(last - first + 1, alpha*x(inner), A.entry(inner, first), y.data() + first);
+                }
+                else
+                {
+                    axpy(last - first + 1, alpha*x(inner), A.entry(inner, first), y.data() + first);
+                }
+            }
+        });
+    }
+    return y;
+}
+
+template <typename T>
+DynamicVector<T> operator*(const BandMatrix<T>& A, const DynamicVector<T>& x)
+{
+    DynamicVector<T> answer(A.order());
+    gemv(static_cast<T>(1), A, Transpose::No, x, static_cast<T>(0), answer);
+    return answer;
+}
+
+// LU with partial pivoting in band storage, as LINPACK's dgbfa: a row swap can move a row up
+// by at most lower, so U has lower + upper superdiagonals. Row i of factors holds columns
+// i-lower .. i+lower+upper, with U from the diagonal on and the multipliers that eliminated
+// row i's subdiagonal entries in the slots left of it. Like DynamicLUDecomposition, a zero
+// column is skipped rather than rejected.
+template <typename T>
+struct BandLUDecomposition
+{
+    int lower = 0;
+    int upper = 0;
+    DynamicMatrix<T> factors;
+    DynamicVectori pivots;
+
+    BandLUDecomposition(const BandMatrix<T>& A)
+    : lower(A.lower()), upper(A.upper()), factors(zero_initialize, A.order(), 2*A.lower() + A.upper() + 1), pivots(A.order())
+    {
+        int n = A.order();
+        for(int row = 0; row < n; ++row)
+        {
+            int first = A.first_column(row);
+            std::copy(A.entry(row, first), A.entry(row, A.last_column(row)) + 1, entry(row, first));
+        }
+        for(int k = 0; k < n; ++k)
+        {
+            int last_row = std::min(n - 1, k + lower);
+            int last_column = std::min(n - 1, k + lower + upper);
+            int pivot = k;
+            real_type<T> max_value = pivot_magnitude(*entry(k, k));
+            for(int row = k + 1; row <= last_row; ++row)
+            {
+                real_type<T> value = pivot_magnitude(*entry(row, k));
+                if(value > max_value)
+                {
+                    pivot = row;
+                    max_value = value;
+                }
+            }
+            pivots(k) = pivot;
+            if(pivot != k)
+            {
+                std::swap_ranges(entry(k, k), entry(k, last_column) + 1, entry(pivot, k));
+            }
+            if(max_value == static_cast<real_type<T>>(0))
+            {
+                continue;
+            }
+            const T* pivot_row = entry(k, k);
+            for(int row = k + 1; row <= last_row; ++row)
+            {
+                T* values = entry(row, k);
+                values[0] /= pivot_row[0];
+                axpy(last_column - k, -values[0], pivot_row + 1, values + 1);
+            }
+        }
+    }
+
+    int order() const
+    {
+        return factors.length();
+    }
+
+    T* entry(int row, int column)
+    {
+        return factors(row).data() + (column - row + lower);
+    }
+
+    const T* entry(int row, int column) const
+    {
+        return factors(row).data() + (column - row + lower);
+    }
+};
+
+// Solves A x = b into x, which may be b itself, replaying the swaps and eliminations of the
+// factorization on x before the banded back substitution
+template <typename T>
+void solve(const BandLUDecomposition<T>& lu_decomp, const DynamicVector<T>& b, DynamicVector<T>& x)
+{
+    int n = lu_decomp.order();
+    if(b.length() != n)
+    {
+        throw MismatchedLength(b.length(), n);
+    }
+    if(&x != &b)
+    {
+        ensure_shape(x, n);
+        x.fill(b);
+    }
+    T* values = x.data();
+    for(int k = 0; k < n; ++k)
+    {
+        std::swap(values[k], values[lu_decomp.pivots(k)]);
+        for(int row = k + 1; row <= std::min(n - 1, k + lu_decomp.lower); ++row)
+        {
+            values[row] -= *lu_decomp.entry(row, k)*values[k];
+        }
+    }
+    for(int index = n - 1; index >= 0; --index)
+    {
+        int last_column = std::min(n - 1, index + lu_decomp.lower + lu_decomp.upper);
+        const T* row = lu_decomp.entry(index, index);
+        values[index] = (values[index] - dot(last_column - index, row + 1, values + index + 1))/row[0];
+    }
+}
+
+template <typename T>
+DynamicVector<T> solve(const BandLUDecomposition<T>& lu_decomp, const DynamicVector<T>& b)
+{
+    DynamicVector<T> x;
+    solve(lu_decomp, b, x);
+    return x;
+}
+
+// Cholesky factor A = U^T U, or U^H U, of a symmetric positive definite band matrix from its
+// diagonal and upper superdiagonals; U keeps that band. Row i of cholesky holds columns
+// i .. i+bandwidth, and each step subtracts the scaled pivot row from the bandwidth rows below it.
+template <typename T>
+struct BandCholeskyDecomposition
+{
+    int bandwidth = 0;
+    DynamicMatrix<T> cholesky;
+
+    BandCholeskyDecomposition(const BandMatrix<T>& A)
+    : bandwidth(A.upper()), cholesky(zero_initialize, A.order(), A.upper() + 1)
+    {
+        int n = A.order();
+        for(int row = 0; row < n; ++row)
+        {
+            std::copy(A.entry(row, row), A.entry(row, last_column(row)) + 1, cholesky(row).data());
+        }
+        for(int i = 0; i < n; ++i)
+        {
+            T* pivot_row = cholesky(i).data();
+            int length = last_column(i) - i + 1;
+            pivot_row[0] = real_part(pivot_row[0]);
+            if(!(real_part(pivot_row[0]) > 0))
+            {
+                throw NotPositiveDefinite(i);
+            }
+            auto sqrt_factor = std::sqrt(real_part(pivot_row[0]));
+            for(int column = 0; column < length; ++column)
+            {
+                pivot_row[column] /= sqrt_factor;
+            }
+            parallel_for(i + 1, i + length, grain_size(length), [&](int begin, int end)
+            {
+                for(int j = begin; j < end; ++j)
+                {
+                    axpy(length - (j - i), -conjugate(pivot_row[j - i]), pivot_row + (j - i), cholesky(j).data());
+                }
+            });
+        }
+    }
+
+    int order() const
+    {
+        return cholesky.length();
+    }
+
+    int last_column(int row) const
+    {
+        return std::min(order() - 1, row + bandwidth);
+    }
+};
+
+// Solves U^T U x = b, or U^H U x = b, into x, which may be b itself
+template <typename T>
+void solve(const BandCholeskyDecomposition<T>& cholesky_decomp, const DynamicVector<T>& b, DynamicVector<T>& x)
+{
+    int n = cholesky_decomp.order();
+    if(b.length() != n)
+    {
+        throw MismatchedLength(b.length(), n);
+    }
+    if(&x != &b)
+    {
+        ensure_shape(x, n);
+        x.fill(b);
+    }
+    T* values = x.data();
+    for(int index = 0; index < n; ++index)
+    {
+        const T* row = cholesky_decomp.cholesky(index).data();
+        values[index] /= conjugate(row[0]);
+        axpyc(cholesky_decomp.last_column(index) - index, -values[index], row + 1, values + index + 1);
+    }
+    for(int index = n - 1; index >= 0; --index)
+    {
+        const T* row = cholesky_decomp.cholesky(index).data();
+        values[index] = (values[index] - dot(cholesky_decomp.last_column(index) - index, row + 1, values + index + 1))/row[0];
+    }
+}
+
+template <typename T>
+DynamicVector<T> solve(const BandCholeskyDecomposition<T>& cholesky_decomp, const DynamicVector<T>& b)
+{
+    DynamicVector<T> x;
+    solve(cholesky_decomp, b, x);
+    return x;
+}
+
+// Tridiagonal matrix of order n as its three diagonals, in LAPACK's layout:
+// lower(i) = A(i+1,i), diagonal(i) = A(i,i) and upper(i) = A(i,i+1)
+template <typename T>
+struct TridiagonalMatrix
+{
+    DynamicVector<T> lower;
+    DynamicVector<T> diagonal;
+    DynamicVector<T> upper;
+
+    TridiagonalMatrix() = default;
+
+    explicit TridiagonalMatrix(int n)
+    : lower(zero_initialize, std::max(n - 1, 0)), diagonal(zero_initialize, n), upper(zero_initialize, std::max(n - 1, 0)) {}
+
+    int order() const
+    {
+        return diagonal.length();
+    }
+};
+
+template <typename T>
+void check_tridiagonal(const TridiagonalMatrix<T>& A, const DynamicVector<T>& b)
+{
+    int n = A.order();
+    int off_diagonal = std::max(n - 1, 0);
+    if(A.lower.length() != off_diagonal || A.upper.length() != off_diagonal)
+    {
+        throw MismatchedLength(off_diagonal, A.lower.length() != off_diagonal ? A.lower.length() : A.upper.length());
+    }
+    if(b.length() != n)
+    {
+        throw MismatchedLength(b.length(), n);
+    }
+}
+
+template <typename T>
+TridiagonalMatrix<T> pack_tridiagonal(const DynamicMatrix<T>& A)
+{
+    check_square(A);
+    int n = A.length();
+    TridiagonalMatrix<T> tridiagonal(n);
+    for(int index = 0; index < n; ++index)
+    {
+        tridiagonal.diagonal(index) = A(index, index);
+        if(index + 1 < n)
+        {
+            tridiagonal.lower(index) = A(index + 1, index);
+            tridiagonal.upper(index) = A(index, index + 1);
+        }
+    }
+    return tridiagonal;
+}
+
+template <typename T>
+DynamicMatrix<T> unpack(const TridiagonalMatrix<T>& A)
+{
+    int n = A.order();
+    DynamicMatrix<T> full(zero_initialize, n, n);
+    for(int index = 0; index < n; ++index)
+    {
+        full(index, index) = A.diagonal(index);
+        if(index + 1 < n)
+        {
+            full(index + 1, index) = A.lower(index);
+            full(index, index + 1) = A.upper(index);
+        }
+    }
+    return full;
+}
+
+// y = alpha*A*x + beta*y into the caller's y; y must not alias x
+template <typename T>
+DynamicVector<T>& gemv(T alpha, const TridiagonalMatrix<T>& A, const DynamicVector<T>& x, T beta, DynamicVector<T>& y)
+{
+    int n = A.order();
+    check_tridiagonal(A, x);
+    if(y.length() != n)
+    {
+        throw MismatchedLength(y.length(), n);
+    }
+    scale(y, beta);
+    if(alpha == static_cast<T>(0))
+    {
+        return y;
+    }
+    parallel_for(0, n, grain_size(3), [&](int begin, int end)
+    {
+        for(int index = begin; index < end; ++index)
+        {
+            T sum = A.diagonal(index)*x(index);
+            if(index > 0)
+            {
+                sum += A.lower(index - 1)*x(index - 1);
+            }
+            if(index + 1 < n)
+            {
+                sum += A.upper(index)*x(index + 1);
+            }
+            y(index) += alpha*sum;
+        }
+    });
+    return y;
+}
+
+template <typename T>
+DynamicVector<T> operator*(const TridiagonalMatrix<T>& A, const DynamicVector<T>& x)
+{
+    DynamicVector<T> answer(A.order());
+    gemv(static_cast<T>(1), A, x, static_cast<T>(0), answer);
+    return answer;
+}
+
+// Thomas algorithm: Gaussian elimination without pivoting in O(n), stable for diagonally
+// dominant or symmetric positive definite A. Solves into x, which may be b itself; throws
+// SingularMatrix on a zero pivot.
+template <typename T>
+void thomas_solve(const TridiagonalMatrix<T>& A, const DynamicVector<T>& b, DynamicVector<T>& x)
+{
+    check_tridiagonal(A, b);
+    int n = A.order();
+    if(&x != &b)
+    {
+        ensure_shape(x, n);
+        x.fill(b);
+    }
+    if(n == 0)
+    {
+        return;
+    }
+    // Superdiagonal of the eliminated system, whose diagonal is one
+    DynamicVector<T> eliminated_upper(std::max(n - 1, 0));
+    T* values = x.data();
+    T pivot = A.diagonal(0);
+    for(int index = 0; index < n; ++index)
+    {
+        if(index > 0)
+        {
+            pivot = A.diagonal(index) - A.lower(index - 1)*eliminated_upper(index - 1);
+            values[index] -= A.lower(index - 1)*values[index - 1];
+        }
+        if(pivot == static_cast<T>(0))
+        {
+            throw SingularMatrix(index);
+        }
+        values[index] /= pivot;
+        if(index + 1 < n)
+        {
+            eliminated_upper(index) = A.upper(index)/pivot;
+        }
+    }
+    for(int index = n - 2; index >= 0; --index)
+    {
+        values[index] -= eliminated_upper(index)*values[index + 1];
+    }
+}
+
+template <typename T>
+DynamicVector<T> thomas_solve(const TridiagonalMatrix<T>& A, const DynamicVector<T>& b)
+{
+    DynamicVector<T> x(b);
+    thomas_solve(A, x, x);
+    return x;
+}
+
+// Cyclic reduction: each level eliminates the odd equations of the current system against
+// their neighbours at distance stride, halving the system, and back substitution walks the
+// levels in reverse. Equations of a level only read equations they do not write, so each level
+// is a parallel loop; about 2.5 times the arithmetic of thomas_solve in log2(n) dependent steps.
+// No pivoting, so A should be diagonally dominant or symmetric positive definite. Solves into x,
+// which may be b itself.
+template <typename T>
+void cyclic_reduction_solve(const TridiagonalMatrix<T>& A, const DynamicVector<T>& b, DynamicVector<T>& x)
+{
+    check_tridiagonal(A, b);
+    int n = A.order();
+    if(n == 0)
+    {
+        ensure_shape(x, 0);
+        return;
+    }
+    // Equation i of the current level: lower(i)*x(i-stride) + diagonal(i)*x(i) + upper(i)*x(i+stride) = rhs(i),
+    // with couplings past either end kept at zero
+    DynamicMatrix<T> system(4, n);
+    T* lower = system(0).data();
+    T* diagonal = system(1).data();
+    T* upper = system(2).data();
+    T* rhs = system(3).data();
+    for(int index = 0; index < n; ++index)
+    {
+        lower[index] = index > 0 ? A.lower(index - 1) : static_cast<T>(0);
+        diagonal[index] = A.diagonal(index);
+        upper[index] = index + 1 < n ? A.upper(index) : static_cast<T>(0);
+        rhs[index] = b(index);
+    }
+
+    int stride = 1;
+    for(; 2*stride - 1 < n; stride *= 2)
+    {
+        int count = n/(2*stride);
+        parallel_for(0, count, grain_size(16), [&, stride](int begin, int end)
+        {
+            for(int equation = begin; equation < end; ++equation)
+            {
+                int i = 2*stride - 1 + equation*2*stride;
+                T alpha = lower[i]/diagonal[i - stride];
+                T gamma = i + stride < n ? upper[i]/diagonal[i + stride] : static_cast<T>(0);
+                diagonal[i] -= alpha*upper[i - stride];
+                rhs[i] -= alpha*rhs[i - stride];
+                lower[i] = -alpha*lower[i - stride];
+                if(i + stride < n)
+                {
+                    diagonal[i] -= gamma*lower[i + stride];
+                    rhs[i] -= gamma*rhs[i + stride];
+                    upper[i] = -gamma*upper[i + stride];
+                }
+            }
+        });
+    }
+
+    ensure_shape(x, n);
+    T* values = x.data();
+    // One equation is left, coupled to nothing
+    values[stride - 1] = rhs[stride - 1]/diagonal[stride - 1];
+    for(stride /= 2; stride >= 1; stride /= 2)
+    {
+        int count = (n + stride)/(2*stride);
+        parallel_for(0, count, grain_size(8), [&, stride](int begin, int end)
+        {
+            for(int equation = begin; equation < end; ++equation)
+            {
+                int i = stride - 1 + equation*2*stride;
+                T value = rhs[i];
+                if(i - stride >= 0)
+                {
+                    value -= lower[i]*values[i - stride];
+                }
+                if(i + stride < n)
+                {
+                    value -= upper[i]*values[i + stride];
+                }
+                values[i] = value/diagonal[i];
+            }
+        });
+    }
+}
+
+template <typename T>
+DynamicVector<T> cyclic_reduction_solve(const TridiagonalMatrix<T>& A, const DynamicVector<T>& b)
+{
+    DynamicVector<T> x;
+    cyclic_reduction_solve(A, b, x);
+    return x;
+}
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <complex>
+#include <cstddef>
 #include <exception>
+#include <type_traits>
 
 namespace math
 {
@@ -18,6 +21,46 @@ struct is_same<T, T>
 
 template <typename T, bool IsStatic, int ... Shape> class Array;
 
+template <typename ArrayType>
+struct array_rank;
+
+template <typename T, int NumDims>
+struct array_rank<Array<T, false, NumDims>>
+{
+    static const int value = NumDims;
+};
+
+template <typename T, int ... Shape>
+struct array_rank<Array<T, true, Shape ... >>
+{
+    static const int value = sizeof...(Shape);
+};
+
+template <typename T>
+struct real_type_of
+{
+    using type = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+};
+
+template <typename T>
+struct real_type_of<std::complex<T>>
+{
+    using type = T;
+};
+
+template <typename T>
+using real_type = typename real_type_of<T>::type;
+
+// Type that sums and products of T elements accumulate in
+template <typename T>
+struct accumulator_type_of
+{
+    using type = T;
+};
+
+template <typename T>
+using accumulator_type = typename accumulator_type_of<T>::type;
+
 template <bool IsStatic, int ... Shape>
 using Arrayi = Array<int, IsStatic, Shape ... >;
 
@@ -44,4 +87,181 @@ class OutOfRange: public std::exception
             return "index invalid for size";
         }
 };
+
+class MismatchedLength: public std::exception
+{
+    private:
+        int left_length_;
+        int right_length_;
+
+    public:
+        MismatchedLength(int left_length, int right_length)
+        : left_length_(left_length), right_length_(right_length) {}
+
+        ~MismatchedLength() override {};
+
+        const char* what() const noexcept override
+        {
+            return "mismatched lengths";
+        }
+};
+
+class InvalidAxis: public std::exception
+{
+    private:
+        int axis_;
+        int num_dims_;
+
+    public:
+        InvalidAxis(int axis, int num_dims)
+        : axis_(axis), num_dims_(num_dims) {}
+
+        ~InvalidAxis() override {};
+
+        const char* what() const noexcept override
+        {
+            return "axis invalid for number of dimensions";
+        }
+};
+
+class NotPositiveDefinite: public std::exception
+{
+    private:
+        int pivot_;
+
+    public:
+        NotPositiveDefinite(int pivot)
+        : pivot_(pivot) {}
+
+        ~NotPositiveDefinite() override {};
+
+        const char* what() const noexcept override
+        {
+            return "matrix is not positive definite";
+        }
+};
+
+class SingularMatrix: public std::exception
+{
+    private:
+        int pivot_;
+
+    public:
+        SingularMatrix(int pivot)
+        : pivot_(pivot) {}
+
+        ~SingularMatrix() override {};
+
+        const char* what() const noexcept override
+        {
+            return "matrix is singular";
+        }
+};
+
+// Raised after a batched Cholesky factorization for the first matrix of the batch that is
+// not positive definite; every other matrix of the batch is factored
+class BatchNotPositiveDefinite: public std::exception
+{
+    private:
+        int matrix_;
+        int pivot_;
+
+    public:
+        BatchNotPositiveDefinite(int matrix, int pivot)
+        : matrix_(matrix), pivot_(pivot) {}
+
+        ~BatchNotPositiveDefinite() override {};
+
+        int matrix() const
+        {
+            return matrix_;
+        }
+
+        int pivot() const
+        {
+            return pivot_;
+        }
+
+        const char* what() const noexcept override
+        {
+            return "matrix of batch is not positive definite";
+        }
+};
+
+class FileError: public std::exception
+{
+    private:
+        int error_number_;
+
+    public:
+        FileError(int error_number)
+        : error_number_(error_number) {}
+
+        ~FileError() override {};
+
+        int error_number() const
+        {
+            return error_number_;
+        }
+
+        const char* what() const noexcept override
+        {
+            return "file operation failed";
+        }
+};
+
+class InsufficientMemory: public std::exception
+{
+    private:
+        std::size_t required_bytes_;
+        std::size_t budget_bytes_;
+
+    public:
+        InsufficientMemory(std::size_t required_bytes, std::size_t budget_bytes)
+        : required_bytes_(required_bytes), budget_bytes_(budget_bytes) {}
+
+        ~InsufficientMemory() override {};
+
+        const char* what() const noexcept override
+        {
+            return "memory budget too small";
+        }
+};
+
+inline void check_axis(int axis, int num_dims)
+{
+    if(axis < 0 || axis >= num_dims)
+    {
+        throw InvalidAxis(axis, num_dims);
+    }
+}
+
+// Calls function on each innermost vector of arrays that share a shape, walking them in lockstep
+template <typename Function, typename First, typename ... Others>
+void for_each_leaf(Function&& function, First&& first, Others&& ... others)
+{
+    ((others.length() != first.length() ? throw MismatchedLength(first.length(), others.length()) : void()), ...);
+    if constexpr(array_rank<std::remove_cvref_t<First>>::value == 1)
+    {
+        function(first, others...);
+    }
+    else
+    {
+        for(int index = 0; index < first.length(); ++index)
+        {
+            for_each_leaf(function, first(index), others(index)...);
+        }
+    }
+}
+
+template <typename T, bool IsStatic, int ... Shape>
+int size(const Array<T, IsStatic, Shape...>& array)
+{
+    int total = 0;
+    for_each_leaf([&](const auto& vector)
+    {
+        total += vector.length();
+    }, array);
+    return total;
+}
 }
\ No newline at end of file
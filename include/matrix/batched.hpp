@@ -0,0 +1,447 @@
+#pragma once
+
+#include "base.hpp"
+#include "dynamic.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace math
+{
+
+// Batched kernels work on a stack of same-size square matrices, matrices(b) being the b-th.
+// Groups of batch_lanes<T> matrices are interleaved so that entry (row, column) of lane l sits
+// at block[(row*n + column)*lanes + l]: every step of a factorization then runs on one cache
+// line of lanes at a time, which the compiler turns into vector instructions across the
+// batch. Groups are spread over the current executor.
+
+template <typename T>
+constexpr int batch_lanes = sizeof(T) < 64 ? 64/sizeof(T) : 1;
+
+// Lanes past count hold the identity, so they factor and solve without failing
+template <typename T>
+void interleave(const DynamicArray<T, 3>& matrices, int first, int count, T* block)
+{
+    constexpr int lanes = batch_lanes<T>;
+    int n = matrices(0).length();
+    for(int lane = 0; lane < lanes; ++lane)
+    {
+        for(int row = 0; row < n; ++row)
+        {
+            const T* source = lane < count ? matrices(first + lane)(row).data() : nullptr;
+            for(int column = 0; column < n; ++column)
+            {
+                block[(row*n + column)*lanes + lane] = source ? source[column] : static_cast<T>(row == column ? 1 : 0);
+            }
+        }
+    }
+}
+
+template <typename T>
+void deinterleave(const T* block, int first, int count, DynamicArray<T, 3>& matrices)
+{
+    constexpr int lanes = batch_lanes<T>;
+    int n = matrices(0).length();
+    for(int lane = 0; lane < count; ++lane)
+    {
+        for(int row = 0; row < n; ++row)
+        {
+            T* target = matrices(first + lane)(row).data();
+            for(int column = 0; column < n; ++column)
+            {
+                target[column] = block[(row*n + column)*lanes + lane];
+            }
+        }
+    }
+}
+
+template <typename T>
+void interleave_vectors(const DynamicMatrix<T>& vectors, int first, int count, T* block)
+{
+    constexpr int lanes = batch_lanes<T>;
+    int n = vectors(0).length();
+    for(int lane = 0; lane < lanes; ++lane)
+    {
+        const T* source = lane < count ? vectors(first + lane).data() : nullptr;
+        for(int index = 0; index < n; ++index)
+        {
+            block[index*lanes + lane] = source ? source[index] : static_cast<T>(0);
+        }
+    }
+}
+
+template <typename T>
+void deinterleave_vectors(const T* block, int first, int count, DynamicMatrix<T>& vectors)
+{
+    constexpr int lanes = batch_lanes<T>;
+    int n = vectors(0).length();
+    for(int lane = 0; lane < count; ++lane)
+    {
+        T* target = vectors(first + lane).data();
+        for(int index = 0; index < n; ++index)
+        {
+            target[index] = block[index*lanes + lane];
+        }
+    }
+}
+
+// Upper Cholesky factors of an interleaved group, lower triangles zeroed. failed[l] is the
+// first pivot at which lane l was not positive definite, or -1; such a lane carries on with
+// a unit pivot so that the others are unaffected.
+template <typename T>
+void cholesky_lanes(T* block, int n, int* failed)
+{
+    constexpr int lanes = batch_lanes<T>;
+    std::fill(failed, failed + lanes, -1);
+    T inverse_sqrt[lanes];
+    for(int i = 0; i < n; ++i)
+    {
+        T* pivot = block + (i*n + i)*lanes;
+        for(int lane = 0; lane < lanes; ++lane)
+        {
+            if(!(pivot[lane] > 0))
+            {
+                failed[lane] = failed[lane] < 0 ? i : failed[lane];
+                pivot[lane] = static_cast<T>(1);
+            }
+            inverse_sqrt[lane] = 1/std::sqrt(pivot[lane]);
+        }
+        for(int column = i; column < n; ++column)
+        {
+            T* values = block + (i*n + column)*lanes;
+            for(int lane = 0; lane < lanes; ++lane)
+            {
+                values[lane] *= inverse_sqrt[lane];
+            }
+        }
+        for(int j = i+1; j < n; ++j)
+        {
+            const T* factor = block + (i*n + j)*lanes;
+            for(int k = j; k < n; ++k)
+            {
+                const T* source = block + (i*n + k)*lanes;
+                T* target = block + (j*n + k)*lanes;
+                for(int lane = 0; lane < lanes; ++lane)
+                {
+                    target[lane] -= factor[lane]*source[lane];
+                }
+            }
+        }
+        for(int column = 0; column < i; ++column)
+        {
+            std::fill(block + (i*n + column)*lanes, block + (i*n + column + 1)*lanes, static_cast<T>(0));
+        }
+    }
+}
+
+// Solves U^T U x = b in place for the interleaved right-hand sides x
+template <typename T>
+void cholesky_solve_lanes(const T* block, int n, T* x)
+{
+    constexpr int lanes = batch_lanes<T>;
+    for(int i = 0; i < n; ++i)
+    {
+        const T* pivot = block + (i*n + i)*lanes;
+        T* x_i = x + i*lanes;
+        for(int lane = 0; lane < lanes; ++lane)
+        {
+            x_i[lane] /= pivot[lane];
+        }
+        for(int j = i+1; j < n; ++j)
+        {
+            const T* u = block + (i*n + j)*lanes;
+            T* x_j = x + j*lanes;
+            for(int lane = 0; lane < lanes; ++lane)
+            {
+                x_j[lane] -= u[lane]*x_i[lane];
+            }
+        }
+    }
+    for(int i = n-1; i >= 0; --i)
+    {
+        T* x_i = x + i*lanes;
+        for(int j = i+1; j < n; ++j)
+        {
+            const T* u = block + (i*n + j)*lanes;
+            const T* x_j = x + j*lanes;
+            for(int lane = 0; lane < lanes; ++lane)
+            {
+                x_i[lane] -= u[lane]*x_j[lane];
+            }
+        }
+        const T* pivot = block + (i*n + i)*lanes;
+        for(int lane = 0; lane < lanes; ++lane)
+        {
+            x_i[lane] /= pivot[lane];
+        }
+    }
+}
+
+// Partial pivoting LU of an interleaved group, packed like getrf: unit lower L below the
+// diagonal and U on and above it. ipiv[k*lanes + l] is the row lane l swapped with row k.
+// A lane whose column is already zero skips its elimination, as DynamicLUDecomposition does.
+template <typename T>
+void lu_lanes(T* block, int n, int* ipiv)
+{
+    constexpr int lanes = batch_lanes<T>;
+    int pivot_row[lanes];
+    T largest[lanes];
+    T inverse[lanes];
+    for(int k = 0; k < n; ++k)
+    {
+        const T* column_k = block + (k*n + k)*lanes;
+        for(int lane = 0; lane < lanes; ++lane)
+        {
+            pivot_row[lane] = k;
+            largest[lane] = std::abs(column_k[lane]);
+        }
+        for(int i = k+1; i < n; ++i)
+        {
+            const T* values = block + (i*n + k)*lanes;
+            for(int lane = 0; lane < lanes; ++lane)
+            {
+                T value = std::abs(values[lane]);
+                bool larger = value > largest[lane];
+                largest[lane] = larger ? value : largest[lane];
+                pivot_row[lane] = larger ? i : pivot_row[lane];
+            }
+        }
+        for(int lane = 0; lane < lanes; ++lane)
+        {
+            ipiv[k*lanes + lane] = pivot_row[lane];
+            if(pivot_row[lane] != k)
+            {
+                for(int column = 0; column < n; ++column)
+                {
+                    std::swap(block[(k*n + column)*lanes + lane], block[(pivot_row[lane]*n + column)*lanes + lane]);
+                }
+            }
+            T pivot = block[(k*n + k)*lanes + lane];
+            inverse[lane] = pivot == static_cast<T>(0) ? static_cast<T>(0) : 1/pivot;
+        }
+        for(int i = k+1; i < n; ++i)
+        {
+            T* multiplier = block + (i*n + k)*lanes;
+            for(int lane = 0; lane < lanes; ++lane)
+            {
+                multiplier[lane] *= inverse[lane];
+            }
+            for(int j = k+1; j < n; ++j)
+            {
+                const T* source = block + (k*n + j)*lanes;
+                T* target = block + (i*n + j)*lanes;
+                for(int lane = 0; lane < lanes; ++lane)
+                {
+                    target[lane] -= multiplier[lane]*source[lane];
+                }
+            }
+        }
+    }
+}
+
+// Solves P^T L U x = b in place for the interleaved right-hand sides x
+template <typename T>
+void lu_solve_lanes(const T* block, const int* ipiv, int n, T* x)
+{
+    constexpr int lanes = batch_lanes<T>;
+    for(int k = 0; k < n; ++k)
+    {
+        for(int lane = 0; lane < lanes; ++lane)
+        {
+            std::swap(x[k*lanes + lane], x[ipiv[k*lanes + lane]*lanes + lane]);
+        }
+    }
+    for(int i = 0; i < n; ++i)
+    {
+        const T* x_i = x + i*lanes;
+        for(int j = i+1; j < n; ++j)
+        {
+            const T* l = block + (j*n + i)*lanes;
+            T* x_j = x + j*lanes;
+            for(int lane = 0; lane < lanes; ++lane)
+            {
+                x_j[lane] -= l[lane]*x_i[lane];
+            }
+        }
+    }
+    for(int i = n-1; i >= 0; --i)
+    {
+        T* x_i = x + i*lanes;
+        for(int j = i+1; j < n; ++j)
+        {
+            const T* u = block + (i*n + j)*lanes;
+            const T* x_j = x + j*lanes;
+            for(int lane = 0; lane < lanes; ++lane)
+            {
+                x_i[lane] -= u[lane]*x_j[lane];
+            }
+        }
+        const T* pivot = block + (i*n + i)*lanes;
+        for(int lane = 0; lane < lanes; ++lane)
+        {
+            x_i[lane] /= pivot[lane];
+        }
+    }
+}
+
+// Number of matrices in a stack of square n by n matrices; throws unless they are square
+template <typename T>
+int check_batch(const DynamicArray<T, 3>& matrices)
+{
+    if(matrices.length() > 0 && matrices(0).length() > 0 && matrices(0)(0).length() != matrices(0).length())
+    {
+        throw MismatchedLength(matrices(0).length(), matrices(0)(0).length());
+    }
+    return matrices.length();
+}
+
+template <typename T>
+void check_batch_vectors(const DynamicArray<T, 3>& matrices, const DynamicMatrix<T>& vectors)
+{
+    if(vectors.length() != matrices.length())
+    {
+        throw MismatchedLength(matrices.length(), vectors.length());
+    }
+    if(matrices.length() > 0 && vectors(0).length() != matrices(0).length())
+    {
+        throw MismatchedLength(matrices(0).length(), vectors(0).length());
+    }
+}
+
+// Calls group(first, count, block, vector_block) for consecutive groups of batch_lanes<T>
+// matrices of size n, in parallel, each thread reusing its own interleaved workspace
+template <typename T, typename Group>
+void for_each_batch_group(int num_matrices, int n, Group&& group)
+{
+    constexpr int lanes = batch_lanes<T>;
+    int num_groups = (num_matrices + lanes - 1)/lanes;
+    long long work_per_group = static_cast<long long>(lanes)*n*n*(n + 3)/3;
+    parallel_for(0, num_groups, grain_size(work_per_group), [&](int begin, int end)
+    {
+        std::vector<T> block(static_cast<std::size_t>(n)*n*lanes);
+        std::vector<T> vector_block(static_cast<std::size_t>(n)*lanes);
+        for(int index = begin; index < end; ++index)
+        {
+            int first = index*lanes;
+            group(first, std::min(lanes, num_matrices - first), block.data(), vector_block.data());
+        }
+    });
+}
+
+// Factors every matrix of the stack in place into the upper triangular U with A = U^T U, like
+// DynamicCholeskyDecomposition. Throws BatchNotPositiveDefinite for the first matrix that
+// fails, after factoring all the others; the failed matrices are left unspecified.
+template <typename T>
+void batched_cholesky(DynamicArray<T, 3>& matrices)
+{
+    int num_matrices = check_batch(matrices);
+    if(num_matrices == 0 || matrices(0).length() == 0)
+    {
+        return;
+    }
+    int n = matrices(0).length();
+    std::vector<int> failures(num_matrices, -1);
+    for_each_batch_group<T>(num_matrices, n, [&](int first, int count, T* block, T*)
+    {
+        int failed[batch_lanes<T>];
+        interleave(matrices, first, count, block);
+        cholesky_lanes(block, n, failed);
+        deinterleave(block, first, count, matrices);
+        std::copy(failed, failed + count, failures.begin() + first);
+    });
+    for(int index = 0; index < num_matrices; ++index)
+    {
+        if(failures[index] >= 0)
+        {
+            throw BatchNotPositiveDefinite(index, failures[index]);
+        }
+    }
+}
+
+// Overwrites each row of B with the solution of U^T U x = B(b), U being factors(b) from batched_cholesky
+template <typename T>
+void batched_cholesky_solve(const DynamicArray<T, 3>& factors, DynamicMatrix<T>& B)
+{
+    int num_matrices = check_batch(factors);
+    check_batch_vectors(factors, B);
+    if(num_matrices == 0 || factors(0).length() == 0)
+    {
+        return;
+    }
+    int n = factors(0).length();
+    for_each_batch_group<T>(num_matrices, n, [&](int first, int count, T* block, T* x)
+    {
+        interleave(factors, first, count, block);
+        interleave_vectors(B, first, count, x);
+        cholesky_solve_lanes(block, n, x);
+        deinterleave_vectors(x, first, count, B);
+    });
+}
+
+// Factors every matrix of the stack in place with partial pivoting, packed like getrf: the
+// unit lower L below the diagonal and U on and above it. Row k of each matrix was swapped
+// with row pivots(b, k) at step k.
+template <typename T>
+DynamicMatrixi batched_lu(DynamicArray<T, 3>& matrices)
+{
+    int num_matrices = check_batch(matrices);
+    int n = num_matrices == 0 ? 0 : matrices(0).length();
+    DynamicMatrixi pivots(num_matrices, n);
+    if(num_matrices == 0 || n == 0)
+    {
+        return pivots;
+    }
+    for_each_batch_group<T>(num_matrices, n, [&](int first, int count, T* block, T*)
+    {
+        constexpr int lanes = batch_lanes<T>;
+        std::vector<int> ipiv(static_cast<std::size_t>(n)*lanes);
+        interleave(matrices, first, count, block);
+        lu_lanes(block, n, ipiv.data());
+        deinterleave(block, first, count, matrices);
+        for(int lane = 0; lane < count; ++lane)
+        {
+            for(int k = 0; k < n; ++k)
+            {
+                pivots(first + lane, k) = ipiv[k*lanes + lane];
+            }
+        }
+    });
+    return pivots;
+}
+
+// Overwrites each row of B with the solution of A x = B(b), given factors and pivots from batched_lu
+template <typename T>
+void batched_lu_solve(const DynamicArray<T, 3>& factors, const DynamicMatrixi& pivots, DynamicMatrix<T>& B)
+{
+    int num_matrices = check_batch(factors);
+    check_batch_vectors(factors, B);
+    if(pivots.length() != num_matrices)
+    {
+        throw MismatchedLength(num_matrices, pivots.length());
+    }
+    if(num_matrices == 0 || factors(0).length() == 0)
+    {
+        return;
+    }
+    int n = factors(0).length();
+    for_each_batch_group<T>(num_matrices, n, [&](int first, int count, T* block, T* x)
+    {
+        constexpr int lanes = batch_lanes<T>;
+        std::vector<int> ipiv(static_cast<std::size_t>(n)*lanes);
+        for(int lane = 0; lane < lanes; ++lane)
+        {
+            for(int k = 0; k < n; ++k)
+            {
+                ipiv[k*lanes + lane] = lane < count ? pivots(first + lane, k) : k;
+            }
+        }
+        interleave(factors, first, count, block);
+        interleave_vectors(B, first, count, x);
+        lu_solve_lanes(block, ipiv.data(), n, x);
+        deinterleave_vectors(x, first, count, B);
+    });
+}
+
+}
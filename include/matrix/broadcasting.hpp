@@ -0,0 +1,242 @@
+#pragma once
+
+#include "base.hpp"
+#include "static.hpp"
+#include "dynamic.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+namespace math
+{
+
+// Broadcast length of one dimension, or -1 when the lengths are incompatible
+constexpr int broadcast_length(int left, int right)
+{
+    return (left == right || right == 1) ? left : (left == 1 ? right : -1);
+}
+
+// Dimensions are aligned from the right; the shorter shape is padded with leading 1s
+template <std::size_t LeftRank, std::size_t RightRank>
+constexpr int broadcast_dimension(const std::array<int, LeftRank>& left, const std::array<int, RightRank>& right, int dimension)
+{
+    int rank = LeftRank > RightRank ? LeftRank : RightRank;
+    int left_dimension = dimension - (rank - static_cast<int>(LeftRank));
+    int right_dimension = dimension - (rank - static_cast<int>(RightRank));
+    int left_length = left_dimension >= 0 ? left[left_dimension] : 1;
+    int right_length = right_dimension >= 0 ? right[right_dimension] : 1;
+    return broadcast_length(left_length, right_length);
+}
+
+template <typename V, typename Left, typename Right>
+struct broadcast_result;
+
+template <typename V, typename T, typename U, int LeftDims, int RightDims>
+struct broadcast_result<V, Array<T, false, LeftDims>, Array<U, false, RightDims>>
+{
+    static const bool is_static = false;
+    using type = Array<V, false, (LeftDims > RightDims ? LeftDims : RightDims)>;
+};
+
+template <typename V, typename LeftShape, typename RightShape, typename Dimensions>
+struct static_broadcast_shape;
+
+template <typename V, int ... LeftShape, int ... RightShape, std::size_t ... Dimensions>
+struct static_broadcast_shape<V, std::integer_sequence<int, LeftShape...>, std::integer_sequence<int, RightShape...>, std::index_sequence<Dimensions...>>
+{
+    static constexpr std::array<int, sizeof...(LeftShape)> left{LeftShape...};
+    static constexpr std::array<int, sizeof...(RightShape)> right{RightShape...};
+    static_assert(((broadcast_dimension(left, right, Dimensions) > 0) && ...), "shapes cannot be broadcast together");
+    using type = Array<V, true, broadcast_dimension(left, right, Dimensions)...>;
+};
+
+template <typename V, typename T, typename U, int ... LeftShape, int ... RightShape>
+struct broadcast_result<V, Array<T, true, LeftShape...>, Array<U, true, RightShape...>>
+{
+    static const bool is_static = true;
+    using type = typename static_broadcast_shape<V,
+        std::integer_sequence<int, LeftShape...>,
+        std::integer_sequence<int, RightShape...>,
+        std::make_index_sequence<(sizeof...(LeftShape) > sizeof...(RightShape) ? sizeof...(LeftShape) : sizeof...(RightShape))>>::type;
+};
+
+template <typename T, typename U, int LeftDims, int RightDims>
+auto broadcast_shape(const DynamicArray<T, LeftDims>& left, const DynamicArray<U, RightDims>& right)
+{
+    constexpr int rank = LeftDims > RightDims ? LeftDims : RightDims;
+    auto left_shape = shape(left);
+    auto right_shape = shape(right);
+    std::array<int, rank> lengths;
+    for(int dimension = 0; dimension < rank; ++dimension)
+    {
+        lengths[dimension] = broadcast_dimension(left_shape, right_shape, dimension);
+        if(lengths[dimension] < 0)
+        {
+            int left_dimension = dimension - (rank - LeftDims);
+            int right_dimension = dimension - (rank - RightDims);
+            throw MismatchedLength(left_shape[left_dimension], right_shape[right_dimension]);
+        }
+    }
+    return lengths;
+}
+
+// Writes operation(left, right) into result, whose shape is already the broadcast shape.
+// A length-1 dimension is read repeatedly rather than copied out to full length.
+template <typename Result, typename Left, typename Right, typename Operation>
+void broadcast_into(Result& result, const Left& left, const Right& right, Operation operation)
+{
+    constexpr int left_rank = array_rank<Left>::value;
+    constexpr int right_rank = array_rank<Right>::value;
+    if constexpr(left_rank == 1 && right_rank == 1)
+    {
+        auto* output = result.data();
+        const auto* left_values = left.data();
+        const auto* right_values = right.data();
+        bool repeat_left = left.length() == 1 && right.length() != 1;
+        bool repeat_right = right.length() == 1 && left.length() != 1;
+        parallel_for(0, result.length(), parallel_grain, [&](int begin, int end)
+        {
+            if(repeat_left)
+            {
+                auto left_value = left_values[0];
+                for(int index = begin; index < end; ++index)
+                {
+                    output[index] = operation(left_value, right_values[index]);
+                }
+            }
+            else if(repeat_right)
+            {
+                auto right_value = right_values[0];
+                for(int index = begin; index < end; ++index)
+                {
+                    output[index] = operation(left_values[index], right_value);
+                }
+            }
+            else
+            {
+                for(int index = begin; index < end; ++index)
+                {
+                    output[index] = operation(left_values[index], right_values[index]);
+                }
+            }
+        });
+    }
+    else
+    {
+        // Rows of the result are independent, so blocks of them go to different threads
+        bool repeat_left = left_rank >= right_rank && left.length() == 1;
+        bool repeat_right = right_rank >= left_rank && right.length() == 1;
+        int grain = result.length() == 0 ? 1 : grain_size(size(result(0)));
+        parallel_for(0, result.length(), grain, [&](int begin, int end)
+        {
+            for(int index = begin; index < end; ++index)
+            {
+                if constexpr(left_rank > right_rank)
+                {
+                    broadcast_into(result(index), left(repeat_left ? 0 : index), right, operation);
+                }
+                else if constexpr(left_rank < right_rank)
+                {
+                    broadcast_into(result(index), left, right(repeat_right ? 0 : index), operation);
+                }
+                else
+                {
+                    broadcast_into(result(index), left(repeat_left ? 0 : index), right(repeat_right ? 0 : index), operation);
+                }
+            }
+        });
+    }
+}
+
+template <typename V, typename Left, typename Right, typename Operation>
+typename broadcast_result<V, Left, Right>::type broadcast(const Left& left, const Right& right, Operation operation)
+{
+    typename broadcast_result<V, Left, Right>::type result;
+    if constexpr(!broadcast_result<V, Left, Right>::is_static)
+    {
+        auto lengths = broadcast_shape(left, right);
+        std::apply([&](auto ... length)
+        {
+            result.allocate(length...);
+        }, lengths);
+    }
+    broadcast_into(result, left, right, operation);
+    return result;
+}
+
+// Whether operand might read elements that result writes. The address ranges spanned by the
+// innermost vectors are compared, so a false positive only costs a copy. An operand that is
+// result itself reads each element just before it is overwritten and does not count.
+template <typename Result, typename Operand>
+bool overlaps(const Result& result, const Operand& operand)
+{
+    if constexpr(is_same<Result, Operand>::value)
+    {
+        if(&result == &operand)
+        {
+            return false;
+        }
+    }
+    auto span = [](const auto& array)
+    {
+        std::uintptr_t first = UINTPTR_MAX;
+        std::uintptr_t last = 0;
+        for_each_leaf([&](const auto& vector)
+        {
+            if(vector.length() > 0)
+            {
+                auto address = reinterpret_cast<std::uintptr_t>(vector.data());
+                first = std::min(first, address);
+                last = std::max(last, address + vector.length()*sizeof(*vector.data()));
+            }
+        }, array);
+        return std::pair{first, last};
+    };
+    auto [result_first, result_last] = span(result);
+    auto [operand_first, operand_last] = span(operand);
+    return operand_first < result_last && result_first < operand_last;
+}
+
+// Writes operation(left, right) into an existing result of the broadcast shape without allocating;
+// result may be left itself, which makes this an in-place update. An operand that shares
+// elements with result in any other way, such as a row of it, is copied first, since rows are
+// written in parallel while a broadcast operand is still being read.
+template <typename Result, typename Left, typename Right, typename Operation>
+Result& broadcast_assign(Result& result, const Left& left, const Right& right, Operation operation)
+{
+    using Broadcast = broadcast_result<typename Result::ValueType, Left, Right>;
+    if constexpr(Broadcast::is_static)
+    {
+        static_assert(is_same<typename Broadcast::type, Result>::value, "result does not have the broadcast shape");
+    }
+    else
+    {
+        static_assert(array_rank<typename Broadcast::type>::value == array_rank<Result>::value, "result does not have the broadcast rank");
+        auto lengths = broadcast_shape(left, right);
+        auto result_lengths = shape(result);
+        for(int dimension = 0; dimension < array_rank<Result>::value; ++dimension)
+        {
+            if(lengths[dimension] != result_lengths[dimension])
+            {
+                throw MismatchedLength(result_lengths[dimension], lengths[dimension]);
+            }
+        }
+    }
+    if(overlaps(result, right))
+    {
+        Right copy(right);
+        return broadcast_assign(result, left, copy, operation);
+    }
+    if(overlaps(result, left))
+    {
+        Left copy(left);
+        return broadcast_assign(result, copy, right, operation);
+    }
+    broadcast_into(result, left, right, operation);
+    return result;
+}
+
+}
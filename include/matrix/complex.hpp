@@ -0,0 +1,192 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <cmath>
+#include <complex>
+#include <type_traits>
+
+namespace math
+{
+
+template <typename T>
+struct is_complex: std::false_type {};
+
+template <typename T>
+struct is_complex<std::complex<T>>: std::true_type {};
+
+template <typename T>
+constexpr bool is_complex_v = is_complex<T>::value;
+
+// Element-wise helpers that reduce to the identity or to std::abs for real types
+
+template <typename T>
+T conjugate(const T& value)
+{
+    if constexpr(is_complex_v<T>)
+    {
+        return std::conj(value);
+    }
+    else
+    {
+        return value;
+    }
+}
+
+template <typename T>
+real_type<T> real_part(const T& value)
+{
+    if constexpr(is_complex_v<T>)
+    {
+        return value.real();
+    }
+    else
+    {
+        return value;
+    }
+}
+
+// |value|^2 without the square root
+template <typename T>
+real_type<T> squared_magnitude(const T& value)
+{
+    if constexpr(is_complex_v<T>)
+    {
+        return value.real()*value.real() + value.imag()*value.imag();
+    }
+    else
+    {
+        return static_cast<real_type<T>>(value)*static_cast<real_type<T>>(value);
+    }
+}
+
+// Magnitude for pivot searches: |re| + |im| for complex values, as LAPACK does, which ranks
+// pivots as well as the modulus without a hypot per element
+template <typename T>
+real_type<T> pivot_magnitude(const T& value)
+{
+    if constexpr(is_complex_v<T>)
+    {
+        return std::abs(value.real()) + std::abs(value.imag());
+    }
+    else
+    {
+        return std::abs(value);
+    }
+}
+
+// accumulator + left*right. For complex values this is the textbook formula on the parts:
+// operator* checks for infinities and NaNs element by element, which keeps compilers from
+// vectorizing loops over it.
+template <typename T>
+T multiply_add(const T& accumulator, const T& left, const T& right)
+{
+    if constexpr(is_complex_v<T>)
+    {
+        return T(accumulator.real() + left.real()*right.real() - left.imag()*right.imag(),
+            accumulator.imag() + left.real()*right.imag() + left.imag()*right.real());
+    }
+    else
+    {
+        return accumulator + left*right;
+    }
+}
+
+// left*right by the same formula; named apart from the elementwise multiply of arrays
+template <typename T>
+T scalar_multiply(const T& left, const T& right)
+{
+    return multiply_add(static_cast<T>(0), left, right);
+}
+
+// Complex vectors are read as interleaved real and imaginary parts, which std::complex
+// guarantees, and the four real products of each complex product are kept in separate
+// accumulators that the compiler turns into fused multiply-adds over whole vectors.
+
+// y += alpha*op(x), with op conjugating when Conjugated is set
+template <bool Conjugated, typename R>
+void complex_axpy(int length, std::complex<R> alpha, const std::complex<R>* x, std::complex<R>* y)
+{
+    const R* xs = reinterpret_cast<const R*>(x);
+    R* ys = reinterpret_cast<R*>(y);
+    R alpha_real = alpha.real();
+    R alpha_imag = alpha.imag();
+    for(int index = 0; index < length; ++index)
+    {
+        R x_real = xs[2*index];
+        R x_imag = Conjugated ? -xs[2*index+1] : xs[2*index+1];
+        ys[2*index] += alpha_real*x_real - alpha_imag*x_imag;
+        ys[2*index+1] += alpha_real*x_imag + alpha_imag*x_real;
+    }
+}
+
+template <typename R>
+void axpy(int length, std::complex<R> alpha, const std::complex<R>* x, std::complex<R>* y)
+{
+    complex_axpy<false>(length, alpha, x, y);
+}
+
+template <typename R>
+void axpyc(int length, std::complex<R> alpha, const std::complex<R>* x, std::complex<R>* y)
+{
+    complex_axpy<true>(length, alpha, x, y);
+}
+
+// sum of op(x[i])*y[i], with op conjugating when Conjugated is set
+template <bool Conjugated, typename R>
+std::complex<R> complex_dot(int length, const std::complex<R>* x, const std::complex<R>* y)
+{
+    const R* xs = reinterpret_cast<const R*>(x);
+    const R* ys = reinterpret_cast<const R*>(y);
+    constexpr int lanes = 4;
+    R real_real[lanes] = {};
+    R imag_imag[lanes] = {};
+    R real_imag[lanes] = {};
+    R imag_real[lanes] = {};
+    int index = 0;
+    for(; index + lanes <= length; index += lanes)
+    {
+        for(int lane = 0; lane < lanes; ++lane)
+        {
+            int position = 2*(index + lane);
+            real_real[lane] += xs[position]*ys[position];
+            imag_imag[lane] += xs[position+1]*ys[position+1];
+            real_imag[lane] += xs[position]*ys[position+1];
+            imag_real[lane] += xs[position+1]*ys[position];
+        }
+    }
+    for(; index < length; ++index)
+    {
+        real_real[0] += xs[2*index]*ys[2*index];
+        imag_imag[0] += xs[2*index+1]*ys[2*index+1];
+        real_imag[0] += xs[2*index]*ys[2*index+1];
+        imag_real[0] += xs[2*index+1]*ys[2*index];
+    }
+    auto total = [](const R* values)
+    {
+        return (values[0] + values[1]) + (values[2] + values[3]);
+    };
+    if constexpr(Conjugated)
+    {
+        return {total(real_real) + total(imag_imag), total(real_imag) - total(imag_real)};
+    }
+    else
+    {
+        return {total(real_real) - total(imag_imag), total(real_imag) + total(imag_real)};
+    }
+}
+
+template <typename R>
+std::complex<R> dot(int length, const std::complex<R>* x, const std::complex<R>* y)
+{
+    return complex_dot<false>(length, x, y);
+}
+
+// sum of conj(x[i])*y[i], the inner product of complex vectors
+template <typename R>
+std::complex<R> dotc(int length, const std::complex<R>* x, const std::complex<R>* y)
+{
+    return complex_dot<true>(length, x, y);
+}
+
+}
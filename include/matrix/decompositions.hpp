@@ -9,7 +9,9 @@
 
 #include <iostream>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace math
 {
@@ -21,32 +23,228 @@ namespace math
         b = temp;
     }
 
+    // Euclidean norm of a workspace range, scaled against overflow like norm()
+    template <typename T>
+    T scaled_norm(const T* values, int length)
+    {
+        T scale = static_cast<T>(0);
+        for(int index = 0; index < length; ++index)
+        {
+            scale = std::max(scale, std::abs(values[index]));
+        }
+        if(scale == static_cast<T>(0))
+        {
+            return scale;
+        }
+        T sum = static_cast<T>(0);
+        for(int index = 0; index < length; ++index)
+        {
+            T scaled = values[index]/scale;
+            sum += scaled*scaled;
+        }
+        return scale*std::sqrt(sum);
+    }
+
+    // Factors the upper triangle of U in place into the upper triangular U with A = U^T U, or
+    // A = U^H U for a complex Hermitian A, whose diagonal is real
+    template <typename Matrix>
+    void cholesky_factor(Matrix& U, int N)
+    {
+        for(int i = 0; i < N; ++i)
+        {
+            U(i,i) = real_part(U(i,i));
+            if(!(real_part(U(i,i)) > 0))
+            {
+                throw NotPositiveDefinite(i);
+            }
+            for(int j = i+1; j < N; ++j)
+            {
+                auto factor = conjugate(U(i,j))/U(i,i);
+                for(int k = j; k < N; ++k)
+                {
+                    U(j,k) -= U(i,k)*factor;
+                }
+            }
+            auto sqrt_factor = std::sqrt(real_part(U(i,i)));
+            for(int r = i; r < N; ++r)
+            {
+                U(i,r) /= sqrt_factor;
+            }
+        }
+    }
+
+    // Solves U^T y = b, or U^H y = b for complex U, in place for upper triangular U
+    template <typename Matrix, typename T>
+    void transposed_forward_substitution(const Matrix& U, T* x, int N)
+    {
+        for(int index = 0; index < N; ++index)
+        {
+            for(int row = 0; row < index; ++row)
+            {
+                x[index] -= conjugate(U(row,index))*x[row];
+            }
+            x[index] /= conjugate(U(index,index));
+        }
+    }
+
+    // Solves U x = b in place for the leading N x N upper triangle of U
+    template <typename Matrix, typename T>
+    void backward_substitution(const Matrix& U, T* x, int N)
+    {
+        for(int index = N-1; index >= 0; --index)
+        {
+            const T* row = U(index).data();
+            for(int column = index+1; column < N; ++column)
+            {
+                x[index] -= row[column]*x[column];
+            }
+            x[index] /= row[index];
+        }
+    }
+
+    // Turns the factor U of A into the factor of A + xx^T in O(N^2) with one Givens rotation
+    // per row. Zero rows of U are allowed, so U may start from zero. x is overwritten.
+    template <typename Matrix, typename T>
+    void cholesky_update(Matrix& U, T* x, int N)
+    {
+        for(int k = 0; k < N; ++k)
+        {
+            T* row = U(k).data();
+            T r = std::hypot(row[k], x[k]);
+            if(r == static_cast<T>(0))
+            {
+                continue;
+            }
+            T c = row[k]/r;
+            T s = x[k]/r;
+            row[k] = r;
+            for(int j = k+1; j < N; ++j)
+            {
+                T rotated = c*row[j] + s*x[j];
+                x[j] = c*x[j] - s*row[j];
+                row[j] = rotated;
+            }
+        }
+    }
+
+    // Turns the factor U of A into the factor of A - xx^T, following LINPACK's dchdd: solve
+    // U^T p = x, reject the downdate unless |p| < 1, then apply the rotations that zero p.
+    // Throws NotPositiveDefinite with U unchanged. x and the workspace of 2N are overwritten.
+    template <typename Matrix, typename T>
+    void cholesky_downdate(Matrix& U, T* x, T* workspace, int N)
+    {
+        T* p = x;
+        transposed_forward_substitution(U, p, N);
+        T norm_p = scaled_norm(p, N);
+        if(!(norm_p < 1))
+        {
+            throw NotPositiveDefinite(N-1);
+        }
+        T alpha = std::sqrt((1 - norm_p)*(1 + norm_p));
+
+        T* c = workspace;
+        T* s = p;
+        for(int i = N-1; i >= 0; --i)
+        {
+            T scale = alpha + std::abs(p[i]);
+            T a = alpha/scale;
+            T b = p[i]/scale;
+            T norm_ab = std::sqrt(a*a + b*b);
+            c[i] = a/norm_ab;
+            s[i] = b/norm_ab;
+            alpha = scale*norm_ab;
+        }
+
+        T* carry = workspace + N;
+        std::fill(carry, carry + N, static_cast<T>(0));
+        for(int i = N-1; i >= 0; --i)
+        {
+            T* row = U(i).data();
+            for(int j = i; j < N; ++j)
+            {
+                T t = c[i]*carry[j] + s[i]*row[j];
+                row[j] = c[i]*row[j] - s[i]*carry[j];
+                carry[j] = t;
+            }
+        }
+    }
+
+    // Factors and solves reuse the storage of the decomposition and of the solution, so
+    // refactoring matrices of an unchanged size performs no allocations.
     template <typename T>
     struct DynamicCholeskyDecomposition
     {
         DynamicMatrix<T> cholesky;
+        DynamicVector<T> workspace;
+
+        DynamicCholeskyDecomposition() = default;
 
         DynamicCholeskyDecomposition(const DynamicMatrix<T>& A)
-        : cholesky(triu(A))
+        {
+            refactor(A);
+        }
+
+        void refactor(const DynamicMatrix<T>& A)
         {
             int N = A.length();
-            for(int i = 0; i < N; ++i)
+            ensure_shape(cholesky, N, N);
+            for(int row = 0; row < N; ++row)
             {
-                for(int j = i+1; j < N; ++j)
+                for(int column = 0; column < N; ++column)
                 {
-                    T factor = cholesky(i,j)/cholesky(i,i);
-                    for(int k = j; k < N; ++k)
-                    {
-                        cholesky(j,k) -= cholesky(i,k)*factor;
-                    }
+                    cholesky(row,column) = column >= row ? A(row,column) : static_cast<T>(0);
+                }
+            }
+            cholesky_factor(cholesky, N);
+        }
+
+        // Refactors A + vv^T
+        void update(const DynamicVector<T>& v)
+        {
+            T* x = load_workspace(v);
+            cholesky_update(cholesky, x, cholesky.length());
+        }
+
+        // Refactors A - vv^T; throws NotPositiveDefinite and keeps the factor if that is not positive definite
+        void downdate(const DynamicVector<T>& v)
+        {
+            T* x = load_workspace(v);
+            cholesky_downdate(cholesky, x, x + v.length(), cholesky.length());
+        }
+
+        // Refactors A + V^T V, one rank-1 update per row of V
+        void update(const DynamicMatrix<T>& V)
+        {
+            for(int row = 0; row < V.length(); ++row)
+            {
+                update(V(row));
+            }
+        }
+
+        // Refactors A - V^T V. When a row fails, the rows before it remain applied.
+        void downdate(const DynamicMatrix<T>& V)
+        {
+            for(int row = 0; row < V.length(); ++row)
+            {
+                downdate(V(row));
+            }
+        }
+
+        private:
+            T* load_workspace(const DynamicVector<T>& v)
+            {
+                int N = cholesky.length();
+                if(v.length() != N)
+                {
+                    throw MismatchedLength(N, v.length());
                 }
-                T sqrt_factor = sqrt(cholesky(i,i));
-                for(int r = i; r < N; ++r)
+                if(workspace.length() < 3*N)
                 {
-                    cholesky(i,i) /= sqrt_factor;
+                    workspace.allocate(3*N);
                 }
+                std::copy(v.data(), v.data() + N, workspace.data());
+                return workspace.data();
             }
-        }
     };
 
     template <typename T, int N>
@@ -57,24 +255,48 @@ namespace math
         CholeskyDecomposition(const Array<T, true, N, N>& A)
         : cholesky(triu(A))
         {
-            for(int i = 0; i < N; ++i)
+            cholesky_factor(cholesky, N);
+        }
+
+        void update(StaticVector<T, N> v)
+        {
+            cholesky_update(cholesky, v.data(), N);
+        }
+
+        void downdate(StaticVector<T, N> v)
+        {
+            StaticVector<T, 2*N> workspace;
+            cholesky_downdate(cholesky, v.data(), workspace.data(), N);
+        }
+    };
+
+    // Bennett's algorithm: turns LU into the factors of LU + xy^T in O(N^2) without pivoting, so
+    // it can be unstable when a pivot shrinks. x and y are overwritten. Throws SingularMatrix
+    // when a pivot becomes zero, leaving the factors partly updated.
+    template <typename LMatrix, typename UMatrix, typename T>
+    void lu_update(LMatrix& L, UMatrix& U, T* x, T* y, int N)
+    {
+        for(int k = 0; k < N; ++k)
+        {
+            T* pivot_row = U(k).data();
+            pivot_row[k] += x[k]*y[k];
+            if(pivot_row[k] == static_cast<T>(0))
             {
-                for(int j = i+1; j < N; ++j)
-                {
-                    T factor = cholesky(i,j)/cholesky(i,i);
-                    for(int k = j; k < N; ++k)
-                    {
-                        cholesky(j,k) -= cholesky(i,k)*factor;
-                    }
-                }
-                T sqrt_factor = sqrt(cholesky(i,i));
-                for(int r = i; r < N; ++r)
-                {
-                    cholesky(i,i) /= sqrt_factor;
-                }
+                throw SingularMatrix(k);
+            }
+            y[k] /= pivot_row[k];
+            for(int j = k+1; j < N; ++j)
+            {
+                pivot_row[j] += x[k]*y[j];
+                y[j] -= y[k]*pivot_row[j];
+            }
+            for(int i = k+1; i < N; ++i)
+            {
+                x[i] -= x[k]*L(i,k);
+                L(i,k) += y[k]*x[i];
             }
         }
-    };
+    }
 
     template <typename T>
     struct DynamicLUDecomposition
@@ -82,20 +304,39 @@ namespace math
         DynamicMatrix<T> L;
         DynamicMatrix<T> U;
         DynamicVectori P;
+        DynamicVector<T> workspace;
+        // +1 or -1 for an even or odd number of row swaps in P
+        int permutation_sign = 1;
+
+        DynamicLUDecomposition() = default;
 
         DynamicLUDecomposition(const DynamicMatrix<T>& A)
-        : U(A), L(Identity<T>(A.length())), P(ARange(A(0).length()))
+        {
+            refactor(A);
+        }
+
+        void refactor(const DynamicMatrix<T>& A)
         {
             int M = A.length();
             int N = A(0).length();
-            for(int k = 0; k < N; ++k)
+            ensure_shape(U, M, N);
+            U.fill(A);
+            ensure_shape(L, M, M);
+            fill_identity(L);
+            ensure_shape(P, M);
+            for(int index = 0; index < M; ++index)
+            {
+                P(index) = index;
+            }
+            permutation_sign = 1;
+            for(int k = 0; k < std::min(M, N); ++k)
             {
                 // Select index i>=k that maximizes abs(U(i,k))
                 int i = k;
-                T max_value = abs(U(i,k));
+                real_type<T> max_value = pivot_magnitude(U(i,k));
                 for(int dummy_i = k; dummy_i < M; ++dummy_i)
                 {
-                    T value = abs(U(dummy_i,k));
+                    real_type<T> value = pivot_magnitude(U(dummy_i,k));
                     if(value > max_value)
                     {
                         i = dummy_i;
@@ -104,24 +345,59 @@ namespace math
                 }
                 for(int j = k; j < N; ++j)
                 {
-                    swap(U(k,j), U(i,j));
+                    math::swap(U(k,j), U(i,j));
                 }
                 for(int j = 0; j < k; ++j)
                 {
-                    swap(L(k,j), L(i,j));
+                    math::swap(L(k,j), L(i,j));
                 }
                 swap(P(k), P(i));
+                if(i != k)
+                {
+                    permutation_sign = -permutation_sign;
+                }
 
+                // A zero column is already eliminated
+                if(max_value == static_cast<real_type<T>>(0))
+                {
+                    continue;
+                }
+                const T* pivot_row = U(k).data();
                 for(int row = k+1; row < M; ++row)
                 {
-                    L(row,k) = U(row,k)/U(k,k);
-                    for(int column = k; column < N; ++column)
-                    {
-                        U(row,column) -= L(row,k)*U(k,column);
-                    }
+                    T* values = U(row).data();
+                    T factor = values[k]/pivot_row[k];
+                    L(row,k) = factor;
+                    axpy(N - k, -factor, pivot_row + k, values + k);
                 }
             }
         }
+
+        // Refactors A + xy^T for square A, keeping the row permutation
+        void update(const DynamicVector<T>& x, const DynamicVector<T>& y)
+        {
+            int N = U.length();
+            if(U(0).length() != N)
+            {
+                throw MismatchedLength(N, U(0).length());
+            }
+            if(x.length() != N || y.length() != N)
+            {
+                throw MismatchedLength(N, x.length() != N ? x.length() : y.length());
+            }
+            if(workspace.length() < 2*N)
+            {
+                workspace.allocate(2*N);
+            }
+            T* permuted_x = workspace.data();
+            T* y_copy = permuted_x + N;
+            for(int index = 0; index < N; ++index)
+            {
+                permuted_x[index] = x(P(index));
+                y_copy[index] = y(index);
+            }
+            lu_update(L, U, permuted_x, y_copy, N);
+        }
     };
 
     template <typename T, int M, int N>
@@ -129,19 +405,20 @@ namespace math
     {
         Array<T, true, M, M> L;
         Array<T, true, M, N> U;
-        StaticVectori<N> P;
+        StaticVectori<M> P;
+        int permutation_sign;
 
         LUDecomposition(const Array<T, true, M, N>& A)
-        : U(A), L(Identity<T, M>()), P(ARange<N>())
+        : U(A), L(Identity<T, M>()), P(ARange<M>()), permutation_sign(1)
         {
-            for(int k = 0; k < N; ++k)
+            for(int k = 0; k < std::min(M, N); ++k)
             {
                 // Select index i>=k that maximizes abs(U(i,k))
                 int i = k;
-                T max_value = abs(U(i,k));
+                real_type<T> max_value = pivot_magnitude(U(i,k));
                 for(int dummy_i = k; dummy_i < M; ++dummy_i)
                 {
-                    T value = abs(U(dummy_i,k));
+                    real_type<T> value = pivot_magnitude(U(dummy_i,k));
                     if(value > max_value)
                     {
                         i = dummy_i;
@@ -150,14 +427,22 @@ namespace math
                 }
                 for(int j = k; j < N; ++j)
                 {
-                    swap(U(k,j), U(i,j));
+                    math::swap(U(k,j), U(i,j));
                 }
                 for(int j = 0; j < k; ++j)
                 {
-                    swap(L(k,j), L(i,j));
+                    math::swap(L(k,j), L(i,j));
                 }
                 swap(P(k), P(i));
+                if(i != k)
+                {
+                    permutation_sign = -permutation_sign;
+                }
 
+                if(max_value == static_cast<real_type<T>>(0))
+                {
+                    continue;
+                }
                 for(int row = k+1; row < M; ++row)
                 {
                     L(row,k) = U(row,k)/U(k,k);
@@ -168,109 +453,300 @@ namespace math
                 }
             }
         }
+
+        void update(const StaticVector<T, M>& x, StaticVector<T, N> y)
+        {
+            static_assert(M == N, "update requires a square matrix");
+            StaticVector<T, M> permuted_x = x(P);
+            lu_update(L, U, permuted_x.data(), y.data(), N);
+        }
     };
 
-    template <typename T, int M, int N>
-    struct QRDecomposition
+    // Turns x, held in u, into the unit vector u of the reflector I - 2uu^T that maps x onto
+    // a multiple of the first unit vector. Returns false when x is zero and no reflection is needed.
+    template <typename T>
+    bool householder_vector(T* u, int length)
     {
-        StaticArray<T,M,N> R;
-        StaticArray<T,M,M> Q;
+        T norm_x = scaled_norm(u, length);
+        if(norm_x == static_cast<T>(0))
+        {
+            return false;
+        }
+        u[0] += norm_x*(u[0] < 0 ? static_cast<T>(-1) : static_cast<T>(1));
+        T norm_u = scaled_norm(u, length);
+        for(int index = 0; index < length; ++index)
+        {
+            u[index] /= norm_u;
+        }
+        return true;
+    }
 
-        QRDecomposition(const StaticArray<T,M,N>& A)
-        : R(A), Q(Identity<T,M>())
+    // Applies I - 2uu^T to rows k.. of B, a vector or a matrix, as B -= 2u(u^T B). A matrix
+    // needs w to hold one entry per column.
+    template <typename Values, typename T>
+    void reflect_rows(Values& B, const T* u, T* w, int k, int length)
+    {
+        if constexpr(array_rank<Values>::value == 1)
+        {
+            T* values = B.data() + k;
+            T sum = static_cast<T>(0);
+            for(int i = 0; i < length; ++i)
+            {
+                sum += u[i]*values[i];
+            }
+            sum *= 2;
+            for(int i = 0; i < length; ++i)
+            {
+                values[i] -= sum*u[i];
+            }
+        }
+        else
         {
-            for(int k = 0; k < N; ++k)
+            int columns = B(0).length();
+            std::fill(w, w + columns, static_cast<T>(0));
+            for(int i = 0; i < length; ++i)
             {
-                DynamicVector<T> u(M-k);
-                for(int i = k; i < R.length(); ++i)
+                const T* row = B(k+i).data();
+                for(int j = 0; j < columns; ++j)
                 {
-                    u(i-k) = R(i,k);
+                    w[j] += u[i]*row[j];
                 }
-                T norm_u = norm(u);
-                u(0) += norm_u*(u(0) < 0 ? static_cast<T>(-1) : static_cast<T>(1));
-                u /= norm(u);
-
-                DynamicMatrix<T> U = outer(u, u);
-
-                for(int i = k; i < M; ++i)
+            }
+            for(int i = 0; i < length; ++i)
+            {
+                T* row = B(k+i).data();
+                T factor = 2*u[i];
+                for(int j = 0; j < columns; ++j)
                 {
-                    for(int j = k; j < N; ++j)
-                    {
-                        for(int s = 0; s < U.length(); ++s)
-                        {
-                            R(i,j) -= 2.0*U(i-k,s)*R(s+k,j);
-                        }
-                    }
+                    row[j] -= factor*w[j];
                 }
+            }
+        }
+    }
 
-                for(int i = k; i < M; ++i)
-                {
-                    for(int j = 0; j < M; ++j)
-                    {
-                        for(int s = 0; s < U.length(); ++s)
-                        {
-                            Q(i,j) -= 2.0*U(i-k,s)*Q(s+k,j);
-                        }
-                    }
-                }
+    // Reflects column k of R onto the diagonal, R -= 2u(u^T R), and accumulates Q -= 2(Qu)u^T
+    // unless Q is null. u receives the m-k entries of the reflector and w needs max(m, n).
+    template <typename RMatrix, typename QMatrix, typename T>
+    void householder_step(RMatrix& R, QMatrix* Q, T* u, T* w, int k, int m, int n)
+    {
+        int length = m-k;
+        for(int i = 0; i < length; ++i)
+        {
+            u[i] = R(k+i,k);
+        }
+        if(!householder_vector(u, length))
+        {
+            return;
+        }
+
+        std::fill(w + k, w + n, static_cast<T>(0));
+        for(int i = 0; i < length; ++i)
+        {
+            const T* row = R(k+i).data();
+            for(int j = k; j < n; ++j)
+            {
+                w[j] += u[i]*row[j];
             }
         }
-    };
+        for(int i = 0; i < length; ++i)
+        {
+            T* row = R(k+i).data();
+            T factor = 2*u[i];
+            for(int j = k; j < n; ++j)
+            {
+                row[j] -= factor*w[j];
+            }
+        }
+
+        if(Q == nullptr)
+        {
+            return;
+        }
+        for(int r = 0; r < m; ++r)
+        {
+            const T* row = (*Q)(r).data() + k;
+            T sum = static_cast<T>(0);
+            for(int i = 0; i < length; ++i)
+            {
+                sum += row[i]*u[i];
+            }
+            w[r] = 2*sum;
+        }
+        for(int r = 0; r < m; ++r)
+        {
+            T* row = (*Q)(r).data() + k;
+            for(int i = 0; i < length; ++i)
+            {
+                row[i] -= w[r]*u[i];
+            }
+        }
+    }
+
+    // Overwrites B, a vector or a matrix of right-hand side columns, with Q^T B = H_last...H_0 B.
+    // A matrix needs w to hold one entry per column. Only the first min(rows, m) rows of
+    // reflectors are reflections; a wide matrix leaves the rest of A^T behind them.
+    template <typename Reflectors, typename Values, typename T>
+    void apply_transposed_q(const Reflectors& reflectors, Values& B, T* w)
+    {
+        int m = reflectors(0).length();
+        int num_reflectors = std::min(reflectors.length(), m);
+        for(int k = 0; k < num_reflectors; ++k)
+        {
+            reflect_rows(B, reflectors(k).data() + k, w, k, m-k);
+        }
+    }
+
+    // Overwrites B with Q B = H_0...H_last B
+    template <typename Reflectors, typename Values, typename T>
+    void apply_q(const Reflectors& reflectors, Values& B, T* w)
+    {
+        int m = reflectors(0).length();
+        int num_reflectors = std::min(reflectors.length(), m);
+        for(int k = num_reflectors-1; k >= 0; --k)
+        {
+            reflect_rows(B, reflectors(k).data() + k, w, k, m-k);
+        }
+    }
+
+    enum class FormQ {No, Yes};
 
+    // A = QR by Householder reflections, with R the upper trapezoidal min(m, n) x n factor.
+    // reflectors holds A^T while it is factored, so every reflection reads and updates whole
+    // rows; afterwards row k holds, from column k on, the unit vector of the k-th reflection,
+    // in the place of the column of A it zeroed. Products with Q or Q^T only need these vectors.
+    // FormQ::Yes also forms the m x min(m, n) Q with orthonormal columns; with FormQ::No
+    // storage is A's size plus R, about 400 MB for a 1M x 50 matrix of doubles.
     template <typename T>
     struct DynamicQRDecomposition
     {
         DynamicMatrix<T> R;
         DynamicMatrix<T> Q;
+        DynamicMatrix<T> reflectors;
+        DynamicVector<T> workspace;
+
+        DynamicQRDecomposition() = default;
+
+        DynamicQRDecomposition(const DynamicMatrix<T>& A, FormQ form_q = FormQ::Yes)
+        {
+            refactor(A, form_q);
+        }
 
-        DynamicQRDecomposition(const DynamicMatrix<T>& A)
-        : R(A), Q(Identity<T>(A.length()))
+        DynamicQRDecomposition(const DynamicMatrix<T>& A, DynamicVector<T>& external_workspace, FormQ form_q = FormQ::Yes)
+        {
+            refactor(A, external_workspace, form_q);
+        }
+
+        // Length of the workspace needed to factor an m x n matrix
+        static int workspace_size(int m, int n)
+        {
+            return std::max(m, n);
+        }
+
+        // Uses the decomposition's own workspace, grown only when A is larger than before
+        void refactor(const DynamicMatrix<T>& A, FormQ form_q = FormQ::Yes)
+        {
+            int size = workspace_size(A.length(), A(0).length());
+            if(workspace.length() < size)
+            {
+                workspace.allocate(size);
+            }
+            refactor(A, workspace, form_q);
+        }
+
+        void refactor(const DynamicMatrix<T>& A, DynamicVector<T>& external_workspace, FormQ form_q = FormQ::Yes)
         {
             int m = A.length();
             int n = A(0).length();
-            for(int k = 0; k < n; ++k)
+            int size = workspace_size(m, n);
+            if(external_workspace.length() < size)
+            {
+                throw MismatchedLength(external_workspace.length(), size);
+            }
+            int num_reflectors = std::min(m, n);
+            ensure_shape(reflectors, n, m);
+            for(int row = 0; row < m; ++row)
             {
-                DynamicVector<T> u(m-k);
-                for(int i = k; i < R.length(); ++i)
+                const T* values = A(row).data();
+                for(int column = 0; column < n; ++column)
                 {
-                    u(i-k) = R(i,k);
+                    reflectors(column).data()[row] = values[column];
                 }
-                T norm_u = norm(u);
-                u(0) += norm_u*(u(0) < 0 ? static_cast<T>(-1) : static_cast<T>(1));
-                u /= norm(u);
-
-                DynamicMatrix<T> U = outer(u, u);
+            }
+            ensure_shape(R, num_reflectors, n);
+            R.fill(static_cast<T>(0));
 
-                for(int i = k; i < m; ++i)
+            T* u = external_workspace.data();
+            for(int k = 0; k < num_reflectors; ++k)
+            {
+                int length = m-k;
+                std::copy(reflectors(k).data() + k, reflectors(k).data() + m, u);
+                bool reflected = householder_vector(u, length);
+                for(int column = k; column < n; ++column)
                 {
-                    for(int j = k; j < n; ++j)
+                    T* values = reflectors(column).data() + k;
+                    if(reflected)
                     {
-                        for(int s = 0; s < U.length(); ++s)
+                        T sum = static_cast<T>(0);
+                        for(int i = 0; i < length; ++i)
                         {
-                            R(i,j) -= 2.0*U(i-k,s)*R(s+k,j);
+                            sum += u[i]*values[i];
+                        }
+                        sum *= 2;
+                        for(int i = 0; i < length; ++i)
+                        {
+                            values[i] -= sum*u[i];
                         }
                     }
+                    R(k, column) = values[0];
                 }
+                // An unreflected column is zero, which leaves a reflector that changes nothing
+                std::copy(u, u + length, reflectors(k).data() + k);
+            }
 
-                for(int i = k; i < m; ++i)
+            if(form_q == FormQ::Yes)
+            {
+                ensure_shape(Q, m, num_reflectors);
+                Q.fill(static_cast<T>(0));
+                for(int index = 0; index < num_reflectors; ++index)
                 {
-                    for(int j = 0; j < m; ++j)
-                    {
-                        for(int s = 0; s < U.length(); ++s)
-                        {
-                            Q(i,j) -= 2.0*U(i-k,s)*Q(s+k,j);
-                        }
-                    }
+                    Q(index, index) = static_cast<T>(1);
                 }
+                apply_q(reflectors, Q, u);
+            }
+            else
+            {
+                Q.clear();
             }
         }
     };
 
-    template <typename T, int N>
-    StaticVector<T, N> forward_substitution_solve(const Array<T, true, N, N>& A, const StaticVector<T, N>& b)
+    // Allocation-free: R, Q and the reflectors are fixed-size members and the workspace of
+    // each reflection is a fixed-size local
+    template <typename T, int M, int N>
+    struct QRDecomposition
     {
-        StaticVector<T, N> x(b);
-        for(int index = 0; index < N; ++index)
+        static constexpr int num_reflectors = M < N ? M : N;
+
+        StaticArray<T,M,N> R;
+        StaticArray<T,M,M> Q;
+        StaticArray<T,num_reflectors,M> reflectors;
+
+        QRDecomposition(const StaticArray<T,M,N>& A)
+        : R(A), Q(Identity<T,M>())
+        {
+            StaticVector<T, (M > N ? M : N)> w;
+            for(int k = 0; k < num_reflectors; ++k)
+            {
+                householder_step(R, &Q, reflectors(k).data() + k, w.data(), k, M, N);
+            }
+        }
+    };
+
+    template <typename T, int N>
+    StaticVector<T, N> forward_substitution_solve(const Array<T, true, N, N>& A, const StaticVector<T, N>& b)
+    {
+        StaticVector<T, N> x(b);
+        for(int index = 0; index < N; ++index)
         {
             for(int column = 0; column < index; ++column)
             {
@@ -281,19 +757,33 @@ namespace math
         return x;
     }
 
+    // Solves into x, which may be b itself
     template <typename T>
-    DynamicVector<T> forward_substitution_solve(const DynamicMatrix<T>& A, const DynamicVector<T>& b)
+    void forward_substitution_solve(const DynamicMatrix<T>& A, const DynamicVector<T>& b, DynamicVector<T>& x)
     {
-        DynamicVector<T> x(b);
         int N = A.length();
+        if(&x != &b)
+        {
+            ensure_shape(x, b.length());
+            x.fill(b);
+        }
+        T* values = x.data();
         for(int index = 0; index < N; ++index)
         {
+            const T* row = A(index).data();
             for(int column = 0; column < index; ++column)
             {
-                x(index) -= A(index,column)*x(column);
+                values[index] -= row[column]*values[column];
             }
-            x(index) /= A(index,index);
+            values[index] /= row[index];
         }
+    }
+
+    template <typename T>
+    DynamicVector<T> forward_substitution_solve(const DynamicMatrix<T>& A, const DynamicVector<T>& b)
+    {
+        DynamicVector<T> x(b);
+        forward_substitution_solve(A, x, x);
         return x;
     }
 
@@ -312,44 +802,120 @@ namespace math
         return x;
     }
 
+    // Solves into x, which may be b itself
     template <typename T>
-    DynamicVector<T> backward_substitution_solve(const DynamicMatrix<T>& A, const DynamicVector<T>&b)
+    void backward_substitution_solve(const DynamicMatrix<T>& A, const DynamicVector<T>& b, DynamicVector<T>& x)
     {
-        DynamicVector<T> x(b);
         int N = b.length();
+        if(&x != &b)
+        {
+            ensure_shape(x, N);
+            x.fill(b);
+        }
+        T* values = x.data();
         for(int index = N-1; index >= 0; --index)
         {
+            const T* row = A(index).data();
             for(int column = index+1; column < N; ++column)
             {
-                x(index) -= A(index,column)*x(column);
+                values[index] -= row[column]*values[column];
             }
-            x(index) /= A(index,index);
+            values[index] /= row[index];
         }
+    }
+
+    template <typename T>
+    DynamicVector<T> backward_substitution_solve(const DynamicMatrix<T>& A, const DynamicVector<T>&b)
+    {
+        DynamicVector<T> x(b);
+        backward_substitution_solve(A, x, x);
         return x;
     }
 
+    // Solves U^T U x = b, or U^H U x = b, into x, which may be b itself
+    template <typename T>
+    void solve(const DynamicCholeskyDecomposition<T>& cholesky_decomp, const DynamicVector<T>& b, DynamicVector<T>& x)
+    {
+        int N = b.length();
+        if(&x != &b)
+        {
+            ensure_shape(x, N);
+            x.fill(b);
+        }
+        transposed_forward_substitution(cholesky_decomp.cholesky, x.data(), N);
+        backward_substitution_solve(cholesky_decomp.cholesky, x, x);
+    }
+
     template <typename T>
     DynamicVector<T> solve(const DynamicCholeskyDecomposition<T>& cholesky_decomp, const DynamicVector<T>& b)
     {
-        DynamicVector<T> y = forward_substitution_solve(cholesky_decomp.cholesky, b);
-        DynamicVector<T> x = backward_substitution_solve(cholesky_decomp.cholesky, y);
+        DynamicVector<T> x;
+        solve(cholesky_decomp, b, x);
         return x;
     }
 
     template <typename T, int N>
     StaticVector<T, N> solve(const CholeskyDecomposition<T, N>& cholesky_decomp, const StaticVector<T, N>& b)
     {
-        StaticVector<T, N> y = forward_substitution_solve(cholesky_decomp.cholesky, b);
-        StaticVector<T, N> x = backward_substitution_solve(cholesky_decomp.cholesky, y);
-        return x;
+        StaticVector<T, N> y(b);
+        transposed_forward_substitution(cholesky_decomp.cholesky, y.data(), N);
+        return backward_substitution_solve(cholesky_decomp.cholesky, y);
+    }
+
+    // x(index) = x(P(index)) without a second vector: each cycle of P is rotated once, starting
+    // from its smallest index. Finding the cycle leaders costs O(N^2) at worst, no more than
+    // the triangular solves that follow.
+    template <typename T>
+    void permute_in_place(const DynamicVectori& P, DynamicVector<T>& x)
+    {
+        for(int start = 0; start < P.length(); ++start)
+        {
+            int index = P(start);
+            while(index > start)
+            {
+                index = P(index);
+            }
+            if(index < start)
+            {
+                continue;
+            }
+            T first = x(start);
+            int current = start;
+            while(P(current) != start)
+            {
+                x(current) = x(P(current));
+                current = P(current);
+            }
+            x(current) = first;
+        }
+    }
+
+    // Solves A x = b into x, which may be b itself
+    template <typename T>
+    void solve(const DynamicLUDecomposition<T>& lu_decomp, const DynamicVector<T>& b, DynamicVector<T>& x)
+    {
+        int N = b.length();
+        if(&x == &b)
+        {
+            permute_in_place(lu_decomp.P, x);
+        }
+        else
+        {
+            ensure_shape(x, N);
+            for(int index = 0; index < N; ++index)
+            {
+                x(index) = b(lu_decomp.P(index));
+            }
+        }
+        forward_substitution_solve(lu_decomp.L, x, x);
+        backward_substitution_solve(lu_decomp.U, x, x);
     }
 
     template <typename T>
     DynamicVector<T> solve(const DynamicLUDecomposition<T>& lu_decomp, const DynamicVector<T>& b)
     {
-        DynamicVector<T> Pb = b(lu_decomp.P);
-        DynamicVector<T> y = forward_substitution_solve(lu_decomp.L, Pb);
-        DynamicVector<T> x = backward_substitution_solve(lu_decomp.U, y);
+        DynamicVector<T> x;
+        solve(lu_decomp, b, x);
         return x;
     }
 
@@ -361,4 +927,611 @@ namespace math
         StaticVector<T, N> x = backward_substitution_solve(lu_decomp.U, y);
         return x;
     }
+
+    // Least squares solution of min |Ax - b| for A = QR with m >= n and full column rank,
+    // from R x = (Q^T b)[0:n]. Q itself is never used.
+    template <typename T>
+    DynamicVector<T> lstsq(const DynamicQRDecomposition<T>& qr, const DynamicVector<T>& b)
+    {
+        int m = qr.reflectors(0).length();
+        int n = qr.R(0).length();
+        if(b.length() != m)
+        {
+            throw MismatchedLength(m, b.length());
+        }
+        if(m < n)
+        {
+            throw MismatchedLength(m, n);
+        }
+        DynamicVector<T> y(b);
+        apply_transposed_q(qr.reflectors, y, static_cast<T*>(nullptr));
+        DynamicVector<T> x(n);
+        std::copy(y.data(), y.data() + n, x.data());
+        backward_substitution(qr.R, x.data(), n);
+        return x;
+    }
+
+    // One least squares solution per column of B
+    template <typename T>
+    DynamicMatrix<T> lstsq(const DynamicQRDecomposition<T>& qr, const DynamicMatrix<T>& B)
+    {
+        int m = qr.reflectors(0).length();
+        int n = qr.R(0).length();
+        if(B.length() != m)
+        {
+            throw MismatchedLength(m, B.length());
+        }
+        if(m < n)
+        {
+            throw MismatchedLength(m, n);
+        }
+        int num_rhs = B(0).length();
+        DynamicMatrix<T> Y(B);
+        DynamicVector<T> w(num_rhs);
+        apply_transposed_q(qr.reflectors, Y, w.data());
+
+        DynamicMatrix<T> X(n, num_rhs);
+        for(int index = n-1; index >= 0; --index)
+        {
+            T* x = X(index).data();
+            std::copy(Y(index).data(), Y(index).data() + num_rhs, x);
+            const T* row = qr.R(index).data();
+            for(int column = index+1; column < n; ++column)
+            {
+                const T* solved = X(column).data();
+                for(int rhs = 0; rhs < num_rhs; ++rhs)
+                {
+                    x[rhs] -= row[column]*solved[rhs];
+                }
+            }
+            for(int rhs = 0; rhs < num_rhs; ++rhs)
+            {
+                x[rhs] /= row[index];
+            }
+        }
+        return X;
+    }
+
+    template <typename T>
+    DynamicVector<T> solve(const DynamicQRDecomposition<T>& qr, const DynamicVector<T>& b)
+    {
+        return lstsq(qr, b);
+    }
+
+    template <typename T, int M, int N>
+    StaticVector<T, N> lstsq(const QRDecomposition<T, M, N>& qr, StaticVector<T, M> b)
+    {
+        static_assert(M >= N, "lstsq needs at least as many rows as columns");
+        apply_transposed_q(qr.reflectors, b, static_cast<T*>(nullptr));
+        StaticVector<T, N> x;
+        std::copy(b.data(), b.data() + N, x.data());
+        backward_substitution(qr.R, x.data(), N);
+        return x;
+    }
+
+    template <typename T, int N>
+    StaticVector<T, N> solve(const QRDecomposition<T, N, N>& qr, const StaticVector<T, N>& b)
+    {
+        return lstsq(qr, b);
+    }
+
+    // Minimum norm solution of the underdetermined A x = b (m < n, full row rank) from the
+    // QR decomposition of A^T: with A = R^T Q^T, x = Q [R^-T b; 0].
+    template <typename T>
+    DynamicVector<T> minimum_norm_solve(const DynamicQRDecomposition<T>& qr_of_transpose, const DynamicVector<T>& b)
+    {
+        int n = qr_of_transpose.reflectors(0).length();
+        int m = qr_of_transpose.R(0).length();
+        if(b.length() != m)
+        {
+            throw MismatchedLength(m, b.length());
+        }
+        if(n < m)
+        {
+            throw MismatchedLength(n, m);
+        }
+        DynamicVector<T> x(n);
+        std::copy(b.data(), b.data() + m, x.data());
+        transposed_forward_substitution(qr_of_transpose.R, x.data(), m);
+        std::fill(x.data() + m, x.data() + n, static_cast<T>(0));
+        apply_q(qr_of_transpose.reflectors, x, static_cast<T*>(nullptr));
+        return x;
+    }
+
+    // Least squares solution when A has at least as many rows as columns, otherwise the
+    // minimum norm solution; neither forms Q
+    template <typename T>
+    DynamicVector<T> lstsq(const DynamicMatrix<T>& A, const DynamicVector<T>& b)
+    {
+        if(A.length() >= A(0).length())
+        {
+            return lstsq(DynamicQRDecomposition<T>(A, FormQ::No), b);
+        }
+        return minimum_norm_solve(DynamicQRDecomposition<T>(transpose(A), FormQ::No), b);
+    }
+
+    template <typename T>
+    struct LogDeterminant
+    {
+        // -1, 0 or +1
+        T sign;
+        // log|det A|, -inf for a singular matrix
+        T log_abs;
+    };
+
+    template <typename T>
+    void check_square(const DynamicMatrix<T>& matrix)
+    {
+        if(matrix.length() != matrix(0).length())
+        {
+            throw MismatchedLength(matrix.length(), matrix(0).length());
+        }
+    }
+
+    // Product of the pivots; may overflow or underflow for large matrices, where logdet does not
+    template <typename T>
+    T det(const DynamicLUDecomposition<T>& lu_decomp)
+    {
+        check_square(lu_decomp.U);
+        T determinant = static_cast<T>(lu_decomp.permutation_sign);
+        for(int index = 0; index < lu_decomp.U.length(); ++index)
+        {
+            determinant *= lu_decomp.U(index,index);
+        }
+        return determinant;
+    }
+
+    template <typename T>
+    LogDeterminant<T> logdet(const DynamicLUDecomposition<T>& lu_decomp)
+    {
+        check_square(lu_decomp.U);
+        LogDeterminant<T> result{static_cast<T>(lu_decomp.permutation_sign), static_cast<T>(0)};
+        for(int index = 0; index < lu_decomp.U.length(); ++index)
+        {
+            T pivot = lu_decomp.U(index,index);
+            if(pivot == static_cast<T>(0))
+            {
+                return {static_cast<T>(0), -std::numeric_limits<T>::infinity()};
+            }
+            if(pivot < 0)
+            {
+                result.sign = -result.sign;
+            }
+            result.log_abs += std::log(std::abs(pivot));
+        }
+        return result;
+    }
+
+    template <typename T>
+    T det(const DynamicCholeskyDecomposition<T>& cholesky_decomp)
+    {
+        T determinant = static_cast<T>(1);
+        for(int index = 0; index < cholesky_decomp.cholesky.length(); ++index)
+        {
+            T diagonal = cholesky_decomp.cholesky(index,index);
+            determinant *= diagonal*diagonal;
+        }
+        return determinant;
+    }
+
+    // log det A = 2 sum log U(i,i); A is positive definite, so there is no sign
+    template <typename T>
+    T logdet(const DynamicCholeskyDecomposition<T>& cholesky_decomp)
+    {
+        T log_determinant = static_cast<T>(0);
+        for(int index = 0; index < cholesky_decomp.cholesky.length(); ++index)
+        {
+            log_determinant += std::log(cholesky_decomp.cholesky(index,index));
+        }
+        return 2*log_determinant;
+    }
+
+    // Replaces the upper triangular U by its inverse in place, bottom row first, as in LAPACK's
+    // trtri: row i of the inverse only needs U(i,:) and the rows below, which are already inverted.
+    // The workspace holds N entries.
+    template <typename Matrix, typename T>
+    void invert_upper_triangular(Matrix& U, T* workspace, int N)
+    {
+        for(int i = N-1; i >= 0; --i)
+        {
+            T* row = U(i).data();
+            T pivot = row[i];
+            if(pivot == static_cast<T>(0))
+            {
+                throw SingularMatrix(i);
+            }
+            std::fill(workspace + i+1, workspace + N, static_cast<T>(0));
+            for(int k = i+1; k < N; ++k)
+            {
+                axpy(N-k, row[k], U(k).data() + k, workspace + k);
+            }
+            row[i] = 1/pivot;
+            for(int j = i+1; j < N; ++j)
+            {
+                row[j] = -workspace[j]/pivot;
+            }
+        }
+    }
+
+    // Rows of the inverse handled together while a row of L is in cache
+    constexpr int inverse_block_rows = 64;
+
+    // A^-1 = U^-1 L^-1 P, computed in place in one matrix as in LAPACK's getri: U is inverted,
+    // multiplied by L^-1 from the right a block of rows at a time, and its columns permuted back
+    template <typename T>
+    DynamicMatrix<T> inverse(const DynamicLUDecomposition<T>& lu_decomp)
+    {
+        check_square(lu_decomp.U);
+        int N = lu_decomp.U.length();
+        DynamicMatrix<T> X(lu_decomp.U);
+        DynamicVector<T> workspace(N);
+        invert_upper_triangular(X, workspace.data(), N);
+
+        // Solves X L = U^-1 row by row; x(i) is final once every later column has been subtracted
+        for(int first = 0; first < N; first += inverse_block_rows)
+        {
+            int last = std::min(N, first + inverse_block_rows);
+            for(int i = N-1; i > 0; --i)
+            {
+                const T* l_row = lu_decomp.L(i).data();
+                for(int row = first; row < last; ++row)
+                {
+                    T* x = X(row).data();
+                    axpy(i, -x[i], l_row, x);
+                }
+            }
+        }
+
+        for(int row = 0; row < N; ++row)
+        {
+            T* x = X(row).data();
+            for(int column = 0; column < N; ++column)
+            {
+                workspace(lu_decomp.P(column)) = x[column];
+            }
+            std::copy(workspace.data(), workspace.data() + N, x);
+        }
+        return X;
+    }
+
+    // A^-1 = U^-1 U^-T, filling the upper triangle with row dot products and mirroring it
+    template <typename T>
+    DynamicMatrix<T> inverse(const DynamicCholeskyDecomposition<T>& cholesky_decomp)
+    {
+        int N = cholesky_decomp.cholesky.length();
+        DynamicMatrix<T> W(cholesky_decomp.cholesky);
+        DynamicVector<T> workspace(N);
+        invert_upper_triangular(W, workspace.data(), N);
+        DynamicMatrix<T> X(N, N);
+        for(int i = 0; i < N; ++i)
+        {
+            for(int j = i; j < N; ++j)
+            {
+                X(i,j) = dot(N-j, W(i).data() + j, W(j).data() + j);
+                X(j,i) = X(i,j);
+            }
+        }
+        return X;
+    }
+
+    // Estimates |A^-1|_1 in O(N^2) from a few solves with A and A^T: Hager's method, which
+    // climbs towards the column of A^-1 with the largest 1-norm, as refined by Higham (LAPACK's
+    // xLACON) with an extra alternating-sign test vector that catches its worst cases.
+    // solve and transposed_solve overwrite their argument v with A^-1 v and A^-T v.
+    template <typename T, typename Solve, typename TransposedSolve>
+    T inverse_norm1_estimate(int N, Solve solve, TransposedSolve transposed_solve)
+    {
+        constexpr int max_iterations = 5;
+        DynamicVector<T> x(N);
+        DynamicVector<T> y(N);
+        x.fill(static_cast<T>(1)/N);
+        T estimate = static_cast<T>(0);
+        for(int iteration = 0; iteration < max_iterations; ++iteration)
+        {
+            y.fill(x);
+            solve(y);
+            estimate = std::max(estimate, norm1(y));
+            for(int index = 0; index < N; ++index)
+            {
+                y(index) = y(index) >= 0 ? static_cast<T>(1) : static_cast<T>(-1);
+            }
+            transposed_solve(y);
+            int j = 0;
+            for(int index = 1; index < N; ++index)
+            {
+                if(std::abs(y(index)) > std::abs(y(j)))
+                {
+                    j = index;
+                }
+            }
+            if(std::abs(y(j)) <= dot(N, y.data(), x.data()))
+            {
+                break;
+            }
+            x.fill(static_cast<T>(0));
+            x(j) = static_cast<T>(1);
+        }
+
+        for(int index = 0; index < N; ++index)
+        {
+            T magnitude = 1 + (N > 1 ? static_cast<T>(index)/(N-1) : static_cast<T>(0));
+            x(index) = index%2 == 0 ? magnitude : -magnitude;
+        }
+        solve(x);
+        return std::max(estimate, 2*norm1(x)/(3*N));
+    }
+
+    template <typename T>
+    T inverse_norm1_estimate(const DynamicLUDecomposition<T>& lu_decomp)
+    {
+        check_square(lu_decomp.U);
+        int N = lu_decomp.U.length();
+        DynamicVector<T> scratch(N);
+        auto solve_lu = [&](DynamicVector<T>& v)
+        {
+            solve(lu_decomp, v, scratch);
+            v.fill(scratch);
+        };
+        // A^T = U^T L^T P, so solve U^T z = v, then L^T w = z, then scatter w through P
+        auto transposed_solve_lu = [&](DynamicVector<T>& v)
+        {
+            transposed_forward_substitution(lu_decomp.U, v.data(), N);
+            for(int index = N-1; index >= 0; --index)
+            {
+                for(int row = index+1; row < N; ++row)
+                {
+                    v(index) -= lu_decomp.L(row,index)*v(row);
+                }
+            }
+            for(int index = 0; index < N; ++index)
+            {
+                scratch(lu_decomp.P(index)) = v(index);
+            }
+            v.fill(scratch);
+        };
+        return inverse_norm1_estimate<T>(N, solve_lu, transposed_solve_lu);
+    }
+
+    template <typename T>
+    T inverse_norm1_estimate(const DynamicCholeskyDecomposition<T>& cholesky_decomp)
+    {
+        auto solve_cholesky = [&](DynamicVector<T>& v)
+        {
+            solve(cholesky_decomp, v, v);
+        };
+        return inverse_norm1_estimate<T>(cholesky_decomp.cholesky.length(), solve_cholesky, solve_cholesky);
+    }
+
+    // Estimate of the 1-norm condition number |A|_1 |A^-1|_1 without forming A^-1
+    template <typename T, typename Decomposition>
+    T condition_number_estimate(const DynamicMatrix<T>& A, const Decomposition& decomposition)
+    {
+        return norm1(A)*inverse_norm1_estimate(decomposition);
+    }
+
+    // Online least squares min |Ax - b| over rows that arrive one at a time. Only the upper
+    // triangular factor of the augmented matrix [A b] is kept:
+    //
+    //     factor = [R  z  ]    with R^T R = A^T A, z = Q^T b and rho the residual norm,
+    //              [0  rho]
+    //
+    // so each row costs O(n^2) regardless of how many rows came before. A forgetting factor
+    // below 1 weights a row seen k rows ago by forgetting_factor^k.
+    template <typename T>
+    struct StreamingLeastSquares
+    {
+        DynamicMatrix<T> factor;
+        DynamicVector<T> workspace;
+        T forgetting_factor;
+
+        StreamingLeastSquares(int num_features, T _forgetting_factor = static_cast<T>(1))
+        : factor(num_features+1, num_features+1), workspace(4*(num_features+1)), forgetting_factor(_forgetting_factor)
+        {
+            factor.fill(static_cast<T>(0));
+        }
+
+        int num_features() const
+        {
+            return factor.length()-1;
+        }
+
+        void add(const DynamicVector<T>& a, T b)
+        {
+            T* x = load_workspace(a, b);
+            if(forgetting_factor != static_cast<T>(1))
+            {
+                T scale = std::sqrt(forgetting_factor);
+                for(int row = 0; row < factor.length(); ++row)
+                {
+                    T* values = factor(row).data();
+                    for(int column = row; column < factor.length(); ++column)
+                    {
+                        values[column] *= scale;
+                    }
+                }
+            }
+            cholesky_update(factor, x, factor.length());
+        }
+
+        // Adds every row of A with the matching entry of b
+        void add(const DynamicMatrix<T>& A, const DynamicVector<T>& b)
+        {
+            if(A.length() != b.length())
+            {
+                throw MismatchedLength(A.length(), b.length());
+            }
+            for(int row = 0; row < A.length(); ++row)
+            {
+                add(A(row), b(row));
+            }
+        }
+
+        // Removes a row added before, for a sliding window. With forgetting, the row must be
+        // passed scaled by the square root of its current weight. Throws NotPositiveDefinite,
+        // keeping the factor, when too few rows would remain to determine the fit.
+        //
+        // Only R is downdated with a. Downdating the whole augmented factor would also ask rho
+        // to stay positive, which fails whenever the remaining rows fit exactly. With
+        // p = R^-T a, the residual r = b - p^T z of the removed row and w = R^T z - a b:
+        //
+        //     R'^T R' = R^T R - a a^T,   R'^T z' = w,   rho'^2 = rho^2 - r^2/(1 - |p|^2)
+        void remove(const DynamicVector<T>& a, T b)
+        {
+            int n = num_features();
+            T* x = load_workspace(a, b);
+            T* downdate_workspace = x + n + 1;
+            T* w = downdate_workspace + 2*n;
+
+            std::copy(x, x + n, w);
+            transposed_forward_substitution(factor, w, n);
+            T squared_norm_p = static_cast<T>(0);
+            T residual = b;
+            for(int index = 0; index < n; ++index)
+            {
+                squared_norm_p += w[index]*w[index];
+                residual -= w[index]*factor(index, n);
+            }
+
+            for(int column = 0; column < n; ++column)
+            {
+                T sum = static_cast<T>(0);
+                for(int row = 0; row <= column; ++row)
+                {
+                    sum += factor(row, column)*factor(row, n);
+                }
+                w[column] = sum - x[column]*b;
+            }
+            cholesky_downdate(factor, x, downdate_workspace, n);
+
+            transposed_forward_substitution(factor, w, n);
+            for(int row = 0; row < n; ++row)
+            {
+                factor(row, n) = w[row];
+            }
+            T rho = factor(n, n);
+            T squared_rho = rho*rho - residual*residual/(1 - squared_norm_p);
+            factor(n, n) = std::sqrt(std::max(squared_rho, static_cast<T>(0)));
+        }
+
+        // Writes the least squares solution into x in O(n^2); needs n independent rows
+        void solve(DynamicVector<T>& x) const
+        {
+            int n = num_features();
+            ensure_shape(x, n);
+            for(int row = 0; row < n; ++row)
+            {
+                x(row) = factor(row, n);
+            }
+            backward_substitution_solve(factor, x, x);
+        }
+
+        DynamicVector<T> solve() const
+        {
+            DynamicVector<T> x;
+            solve(x);
+            return x;
+        }
+
+        // Norm of the residual Ax - b of the current fit
+        T residual_norm() const
+        {
+            int n = num_features();
+            return std::abs(factor(n, n));
+        }
+
+        private:
+            T* load_workspace(const DynamicVector<T>& a, T b)
+            {
+                int n = num_features();
+                if(a.length() != n)
+                {
+                    throw MismatchedLength(n, a.length());
+                }
+                T* x = workspace.data();
+                std::copy(a.data(), a.data() + n, x);
+                x[n] = b;
+                return x;
+            }
+    };
+
+    template <typename T>
+    struct MixedPrecisionSolution
+    {
+        DynamicVector<T> x;
+        int iterations;
+        T backward_error;
+        bool used_fallback;
+    };
+
+    template <typename T>
+    bool all_finite(const DynamicVector<T>& vector)
+    {
+        for(int index = 0; index < vector.length(); ++index)
+        {
+            if(!std::isfinite(vector(index)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Factors A in Low precision and recovers the accuracy of T by iterative refinement
+    // with residuals computed in T. Falls back to a full factorization in T when the
+    // refinement stalls or the low precision factorization breaks down.
+    template <typename T, typename Low = float>
+    MixedPrecisionSolution<T> mixed_precision_solve(const DynamicMatrix<T>& A, const DynamicVector<T>& b, int max_iterations = 30)
+    {
+        int N = A.length();
+        T norm_A = norm_inf(A);
+        T norm_b = norm_inf(b);
+        T tolerance = std::numeric_limits<T>::epsilon()*std::sqrt(static_cast<T>(N));
+
+        auto backward_error = [&](const DynamicVector<T>& x, const DynamicVector<T>& residual)
+        {
+            T denominator = norm_A*norm_inf(x) + norm_b;
+            return denominator > static_cast<T>(0) ? norm_inf(residual)/denominator : static_cast<T>(0);
+        };
+
+        MixedPrecisionSolution<T> solution{DynamicVector<T>(), 0, static_cast<T>(0), false};
+
+        DynamicLUDecomposition<Low> low_lu(cast<Low>(A));
+        DynamicVector<Low> low_x = solve(low_lu, cast<Low>(b));
+        if(all_finite(low_x))
+        {
+            solution.x = cast<T>(low_x);
+            T previous_error = std::numeric_limits<T>::infinity();
+            for(; solution.iterations < max_iterations; ++solution.iterations)
+            {
+                DynamicVector<T> residual = b - A*solution.x;
+                solution.backward_error = backward_error(solution.x, residual);
+                if(solution.backward_error <= tolerance)
+                {
+                    return solution;
+                }
+                // Refinement that fails to halve the error has stalled
+                if(!(solution.backward_error < previous_error/2))
+                {
+                    break;
+                }
+                previous_error = solution.backward_error;
+
+                DynamicVector<Low> correction = solve(low_lu, cast<Low>(residual));
+                if(!all_finite(correction))
+                {
+                    break;
+                }
+                for(int index = 0; index < N; ++index)
+                {
+                    solution.x(index) += static_cast<T>(correction(index));
+                }
+            }
+        }
+
+        DynamicLUDecomposition<T> lu(A);
+        solution.x = solve(lu, b);
+        solution.backward_error = backward_error(solution.x, b - A*solution.x);
+        solution.used_fallback = true;
+        return solution;
+    }
 }
\ No newline at end of file
@@ -1,35 +1,40 @@
 #pragma once
 #include "base.hpp"
+#include "memory.hpp"
+#include "parallel.hpp"
 
+#include <algorithm>
+#include <array>
 #include <initializer_list>
+#include <tuple>
 
 namespace math
 {
 
-class MismatchedLength: public std::exception
-{
-    private:
-        int left_length_;
-        int right_length_;
-
-    public:
-        MismatchedLength(int left_length, int right_length)
-        : left_length_(left_length), right_length_(right_length) {}
+template <typename T, int NumDims>
+std::array<int, NumDims> shape(const Array<T, false, NumDims>& array);
 
-        ~MismatchedLength() override {};
+template <typename T, int NumDims>
+bool is_rectangular(const Array<T, false, NumDims>& array);
 
-        const char* what() const noexcept override
-        {
-            return "mismatched lengths";
-        }
+// Tag for constructors that start every element at zero. Blocks the kernel maps fresh are
+// already zero and are left untouched, so their pages are only faulted in when written.
+struct ZeroInitialize
+{
 };
 
+constexpr ZeroInitialize zero_initialize{};
+
 template <typename T>
 class Array<T, false, 1>
 {
+    template <typename, bool, int ...> friend class Array;
+
     private:
         int length_;
         T* data_;
+        std::pmr::memory_resource* resource_;
+        bool owns_data_;
 
         void check_input(int index) const
         {
@@ -47,40 +52,107 @@ class Array<T, false, 1>
             }
         }
 
+        void release()
+        {
+            if(owns_data_)
+            {
+                deallocate_elements(resource_, data_, length_);
+            }
+            data_ = nullptr;
+            length_ = 0;
+            owns_data_ = false;
+        }
+
+        // Points this vector at elements owned by an enclosing array
+        void bind(T* elements, int _length)
+        {
+            release();
+            data_ = elements;
+            length_ = _length;
+        }
+
+        bool bound_to(const T* elements, std::size_t count) const
+        {
+            return !owns_data_ && data_ == elements && static_cast<std::size_t>(length_) <= count;
+        }
+
+        static std::size_t storage_length(int _length)
+        {
+            return padded_length<T>(_length);
+        }
+
+        static bool shape_of(const std::initializer_list<T>& values, int* lengths)
+        {
+            lengths[0] = values.size();
+            return true;
+        }
+
     public:
+        using ValueType = T;
         using InitializerList = std::initializer_list<T>;
 
         Array()
-        : length_(0) {}
+        : length_(0), data_(nullptr), resource_(array_resource()), owns_data_(false) {}
+
+        explicit Array(std::pmr::memory_resource* resource)
+        : length_(0), data_(nullptr), resource_(resource), owns_data_(false) {}
 
         Array(int _length)
-        : length_(_length), data_(new T[length_]) {}
+        : Array()
+        {
+            allocate(_length);
+        }
+
+        Array(ZeroInitialize, int _length)
+        : Array()
+        {
+            allocate(_length);
+            if(!allocates_zeroed(resource_, _length*sizeof(T)))
+            {
+                fill(T());
+            }
+        }
 
         Array(const Array& array)
-        : length_(array.length()), data_(new T[length_])
+        : Array()
         {
             fill(array);
         }
 
+        Array(Array&& array) noexcept
+        : length_(array.length_), data_(array.data_), resource_(array.resource_), owns_data_(array.owns_data_)
+        {
+            array.data_ = nullptr;
+            array.length_ = 0;
+            array.owns_data_ = false;
+        }
+
         Array(const InitializerList& values)
-        : length_(values.size()), data_(new T[length_])
+        : Array()
         {
-            int index = 0;
-            for(T value : values)
-            {
-                data_[index] = value;
-                ++index;
-            }
+            fill(values);
+        }
+
+        // Frees the elements, leaving an empty vector
+        void clear()
+        {
+            release();
         }
 
         void allocate(int _length)
         {
-            if(length_ > 0)
+            release();
+            data_ = allocate_elements<T>(resource_, _length);
+            length_ = _length;
+            owns_data_ = true;
+            if(first_touch(resource_, _length*sizeof(T)))
             {
-                delete [] data_;
+                // Written directly, since fill() would hand mapped pages back untouched
+                parallel_for(0, _length, grain_size(1), [&](int begin, int end)
+                {
+                    std::fill(data_ + begin, data_ + end, T());
+                });
             }
-            data_ = new T[_length];
-            length_ = _length;
         }
         
         void allocate_like(const Array& array)
@@ -90,10 +162,7 @@ class Array<T, false, 1>
 
         ~Array()
         {
-            if(length_ > 0)
-            {
-                delete [] data_;
-            }
+            release();
         }
 
         T operator()(int index) const
@@ -113,6 +182,21 @@ class Array<T, false, 1>
             return length_;
         }
 
+        T* data()
+        {
+            return data_;
+        }
+
+        const T* data() const
+        {
+            return data_;
+        }
+
+        std::pmr::memory_resource* resource() const
+        {
+            return resource_;
+        }
+
         void fill(const InitializerList& values)
         {
             if(length_ == 0)
@@ -133,10 +217,23 @@ class Array<T, false, 1>
 
         void fill(T value)
         {
-            for(int index = 0; index < length_; ++index)
+            // Pages placed by first touch stay mapped, since the next thread to fault them in
+            // would take them all to its own node
+            if(owns_data_ && is_zero_bits(value) && allocates_zeroed(resource_, length_*sizeof(T)) && !first_touch(resource_, length_*sizeof(T)))
             {
-                data_[index] = value;
+                zero_elements(resource_, data_, length_);
+                return;
             }
+            parallel_for(0, length_, parallel_grain, [&](int begin, int end)
+            {
+                std::fill(data_ + begin, data_ + end, value);
+            });
+        }
+
+        // Passes an access pattern hint for the elements on to the kernel
+        void advise(Advice advice)
+        {
+            math::advise(data_, length_*sizeof(T), advice);
         }
 
         void fill(const Array& vector)
@@ -148,21 +245,31 @@ class Array<T, false, 1>
             check_length_matches(vector);
             for(int index = 0; index < length_; ++index)
             {
-                data_[index] = vector(index);
+                data_[index] = vector.data_[index];
             }
         }
 
         void operator=(const Array& vector)
         {
-            if(length_ == 0)
-            {
-                allocate(vector.length());
-            }
-            check_length_matches(vector);
-            for(int index = 0; index < length_; ++index)
+            fill(vector);
+        }
+
+        // Takes over the storage of an expiring vector unless this one already has elements to fill
+        void operator=(Array&& vector)
+        {
+            if(length_ != 0)
             {
-                data_[index] = vector(index);
+                fill(vector);
+                return;
             }
+            release();
+            length_ = vector.length_;
+            data_ = vector.data_;
+            resource_ = vector.resource_;
+            owns_data_ = vector.owns_data_;
+            vector.data_ = nullptr;
+            vector.length_ = 0;
+            vector.owns_data_ = false;
         }
 
         Array operator()(const Array<int, false, 1>& indices) const
@@ -181,12 +288,18 @@ template <typename T, int NumDims>
 requires(NumDims > 1)
 class Array<T, false, NumDims>
 {
+    template <typename, bool, int ...> friend class Array;
+
     public:
         using SubArray = Array<T, false, NumDims-1>;
 
     private:
         int length_;
         SubArray* data_;
+        std::pmr::memory_resource* resource_;
+        // Single block holding the elements of every row, when this array allocated them
+        T* elements_;
+        std::size_t num_elements_;
 
         void check_input(int index) const
         {
@@ -196,57 +309,185 @@ class Array<T, false, NumDims>
             }
         }
 
+        void release_rows()
+        {
+            if(data_ != nullptr)
+            {
+                std::destroy_n(data_, length_);
+                resource_->deallocate(data_, length_*sizeof(SubArray), alignof(SubArray));
+            }
+            data_ = nullptr;
+            length_ = 0;
+        }
+
+        void release()
+        {
+            release_rows();
+            deallocate_elements(resource_, elements_, num_elements_);
+            elements_ = nullptr;
+            num_elements_ = 0;
+        }
+
+        void allocate_rows(int _length)
+        {
+            if(_length > 0)
+            {
+                data_ = static_cast<SubArray*>(resource_->allocate(_length*sizeof(SubArray), alignof(SubArray)));
+                for(int index = 0; index < _length; ++index)
+                {
+                    new (data_ + index) SubArray(resource_);
+                }
+            }
+            length_ = _length;
+        }
+
+        template <typename ... OtherLengths>
+        static std::size_t storage_length(int _length, OtherLengths... others)
+        {
+            return _length*SubArray::storage_length(others...);
+        }
+
+        // Lays the rows out over elements owned by this array or an enclosing one
+        template <typename ... OtherLengths>
+        void bind(T* elements, int _length, OtherLengths... others)
+        {
+            release_rows();
+            allocate_rows(_length);
+            std::size_t stride = SubArray::storage_length(others...);
+            for(int index = 0; index < _length; ++index)
+            {
+                data_[index].bind(elements + index*stride, others...);
+            }
+        }
+
+        // Whether every row still lies where bind() put it in a block of count elements
+        bool bound_to(const T* elements, std::size_t count) const
+        {
+            std::size_t stride = length_ == 0 ? 0 : count/length_;
+            for(int index = 0; index < length_; ++index)
+            {
+                if(!data_[index].bound_to(elements + index*stride, stride))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template <typename ... OtherLengths>
+        void allocate_block(int _length, OtherLengths... others)
+        {
+            release();
+            num_elements_ = storage_length(_length, others...);
+            elements_ = allocate_elements<T>(resource_, num_elements_);
+            bind(elements_, _length, others...);
+            if(_length > 0 && first_touch(resource_, num_elements_*sizeof(T)))
+            {
+                // Each thread writes the block of rows a parallel kernel would hand it, which
+                // places those pages on its own node
+                std::size_t stride = num_elements_/_length;
+                parallel_for(0, _length, grain_size(stride), [&](int begin, int end)
+                {
+                    std::fill(elements_ + begin*stride, elements_ + end*stride, T());
+                });
+            }
+        }
+
+        // Records the lengths of a nested initializer list and whether it is rectangular
+        static bool shape_of(const std::initializer_list<typename SubArray::InitializerList>& values, int* lengths)
+        {
+            lengths[0] = values.size();
+            bool rectangular = true;
+            bool first = true;
+            int first_lengths[NumDims-1] = {};
+            for(const auto& value : values)
+            {
+                int row_lengths[NumDims-1];
+                rectangular = SubArray::shape_of(value, row_lengths) && rectangular;
+                if(first)
+                {
+                    std::copy(row_lengths, row_lengths + NumDims-1, first_lengths);
+                    first = false;
+                }
+                else
+                {
+                    rectangular = std::equal(row_lengths, row_lengths + NumDims-1, first_lengths) && rectangular;
+                }
+            }
+            std::copy(first_lengths, first_lengths + NumDims-1, lengths+1);
+            return rectangular;
+        }
+
+        template <typename Lengths>
+        void allocate_shape(const Lengths& lengths)
+        {
+            std::apply([&](auto ... _lengths)
+            {
+                allocate(_lengths...);
+            }, lengths);
+        }
 
     public:
+        using ValueType = T;
         using InitializerList = std::initializer_list<typename SubArray::InitializerList>;
 
         Array()
-        : length_(0) {}
+        : length_(0), data_(nullptr), resource_(array_resource()), elements_(nullptr), num_elements_(0) {}
+
+        explicit Array(std::pmr::memory_resource* resource)
+        : length_(0), data_(nullptr), resource_(resource), elements_(nullptr), num_elements_(0) {}
 
         template <typename ... OtherDims>
         requires(sizeof...(OtherDims) == (NumDims-1))
         Array(int _length, OtherDims... others)
-        : length_(_length), data_(new SubArray[length_]) 
+        : Array()
         {
-            for(int index = 0; index < length_; ++index)
+            allocate(_length, others...);
+        }
+
+        template <typename ... OtherDims>
+        requires(sizeof...(OtherDims) == (NumDims-1))
+        Array(ZeroInitialize, int _length, OtherDims... others)
+        : Array()
+        {
+            allocate(_length, others...);
+            if(!allocates_zeroed(resource_, num_elements_*sizeof(T)))
             {
-                data_[index].allocate(others...);
+                fill(T());
             }
         }
 
         Array(const Array& array)
-        : length_(array.length()), data_(new SubArray[length_])
+        : Array()
         {
-            for(int index = 0; index < length_; ++index)
-            {
-                data_[index].fill(array(index));
-            }
+            fill(array);
+        }
+
+        Array(Array&& array) noexcept
+        : length_(array.length_), data_(array.data_), resource_(array.resource_), elements_(array.elements_), num_elements_(array.num_elements_)
+        {
+            array.length_ = 0;
+            array.data_ = nullptr;
+            array.elements_ = nullptr;
+            array.num_elements_ = 0;
         }
 
         Array(const InitializerList& values)
-        : length_(values.size()), data_(new SubArray[length_])
+        : Array()
         {
-            int index = 0;
-            for(typename SubArray::InitializerList value : values)
-            {
-                data_[index].fill(value);
-                ++index;
-            }
+            fill(values);
         }
 
         ~Array()
         {
-            if(length_ > 0)
-            {
-                delete [] data_;
-            }
+            release();
         }
 
         void fill(const Array& array)
         {
             if(length_ == 0)
             {
-                allocate(array.length());
+                allocate_like(array);
             }
             else if(length_ != array.length())
             {
@@ -258,7 +499,7 @@ class Array<T, false, NumDims>
             }
         }
 
-        SubArray operator()(int index) const
+        const SubArray& operator()(int index) const
         {
             check_input(index);
             return data_[index];
@@ -291,11 +532,37 @@ class Array<T, false, NumDims>
             return length_;
         }
 
+        std::pmr::memory_resource* resource() const
+        {
+            return resource_;
+        }
+
         void fill(T value)
         {
+            // Pages placed by first touch are overwritten row block by row block instead
+            if(elements_ != nullptr && is_zero_bits(value) && allocates_zeroed(resource_, num_elements_*sizeof(T)) && !first_touch(resource_, num_elements_*sizeof(T))
+                && bound_to(elements_, num_elements_))
+            {
+                zero_elements(resource_, elements_, num_elements_);
+                return;
+            }
+            parallel_for_each_leaf([value](auto& vector, int begin, int end)
+            {
+                std::fill(vector.data() + begin, vector.data() + end, value);
+            }, *this);
+        }
+
+        // Passes an access pattern hint for the elements on to the kernel
+        void advise(Advice advice)
+        {
+            if(elements_ != nullptr)
+            {
+                math::advise(elements_, num_elements_*sizeof(T), advice);
+                return;
+            }
             for(int index = 0; index < length_; ++index)
             {
-                data_[index].fill(value);
+                data_[index].advise(advice);
             }
         }
 
@@ -303,7 +570,15 @@ class Array<T, false, NumDims>
         {
             if(length_ == 0)
             {
-                allocate(values.size());
+                std::array<int, NumDims> lengths;
+                if(shape_of(values, lengths.data()))
+                {
+                    allocate_shape(lengths);
+                }
+                else
+                {
+                    allocate(values.size());
+                }
             }
             if(values.size() != length_)
             {
@@ -317,29 +592,34 @@ class Array<T, false, NumDims>
             }
         } 
 
+        // Frees the rows and their elements, leaving an empty array
+        void clear()
+        {
+            release();
+        }
+
+        // Allocates _length empty rows, each of which can later be allocated on its own
         void allocate(int _length)
         {
-            if(length_ > 0)
-            {
-                delete [] data_;
-            }
-            data_ = new SubArray[_length];
-            length_ = _length;
+            release();
+            allocate_rows(_length);
         }
 
+        // Allocates every row in one block from the array's memory resource
         template <typename ... OtherLengths>
         requires(sizeof...(OtherLengths) == (NumDims-1))
         void allocate(int _length, OtherLengths... others)
         {
-            allocate(_length);
-            for(int index = 0; index < length_; ++index)
-            {
-                data_[index].allocate(others...);
-            }
+            allocate_block(_length, others...);
         }
 
         void allocate_like(const Array& array)
         {
+            if(is_rectangular(array))
+            {
+                allocate_shape(shape(array));
+                return;
+            }
             allocate(array.length());
             for(int index = 0; index < length_; ++index)
             {
@@ -352,10 +632,39 @@ class Array<T, false, NumDims>
             fill(array);
         }
 
+        // Takes over the storage of an expiring array unless this one already has rows to fill
+        void operator=(Array&& array)
+        {
+            if(length_ != 0)
+            {
+                fill(array);
+                return;
+            }
+            release();
+            length_ = array.length_;
+            data_ = array.data_;
+            resource_ = array.resource_;
+            elements_ = array.elements_;
+            num_elements_ = array.num_elements_;
+            array.length_ = 0;
+            array.data_ = nullptr;
+            array.elements_ = nullptr;
+            array.num_elements_ = 0;
+        }
+
         Array operator()(const Array<int, false, 1>& indices) const
         {
             Array indexed;
-            indexed.allocate(indices.length());
+            if(length_ > 0 && is_rectangular(*this))
+            {
+                auto lengths = shape(*this);
+                lengths[0] = indices.length();
+                indexed.allocate_shape(lengths);
+            }
+            else
+            {
+                indexed.allocate(indices.length());
+            }
             for(int index = 0; index < indices.length(); ++index)
             {
                 indexed(index) = data_[indices(index)];
@@ -395,22 +704,111 @@ using DynamicMatrixf = DynamicMatrix<float>;
 
 using DynamicMatrixd = DynamicMatrix<double>;
 
-template <typename T>
-DynamicVector<T> empty_like(const DynamicVector<T>& vector)
+// Lengths of a rectangular dynamic array, read along its first elements
+template <typename T, int NumDims>
+std::array<int, NumDims> shape(const DynamicArray<T, NumDims>& array)
+{
+    std::array<int, NumDims> lengths{};
+    lengths[0] = array.length();
+    if constexpr(NumDims > 1)
+    {
+        if(array.length() > 0)
+        {
+            auto inner = shape(array(0));
+            std::copy(inner.begin(), inner.end(), lengths.begin()+1);
+        }
+    }
+    return lengths;
+}
+
+template <typename T, int NumDims>
+bool has_shape(const DynamicArray<T, NumDims>& array, const int* lengths)
+{
+    if(array.length() != lengths[0])
+    {
+        return false;
+    }
+    if constexpr(NumDims > 1)
+    {
+        for(int index = 0; index < array.length(); ++index)
+        {
+            if(!has_shape(array(index), lengths+1))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename T, int NumDims>
+bool is_rectangular(const DynamicArray<T, NumDims>& array)
+{
+    auto lengths = shape(array);
+    return has_shape(array, lengths.data());
+}
+
+// Reallocates only when the shape differs, so refilling an array of the same shape never allocates
+template <typename T, int NumDims, typename ... Lengths>
+requires(sizeof...(Lengths) == NumDims)
+void ensure_shape(DynamicArray<T, NumDims>& array, Lengths... lengths)
 {
-    DynamicVector<T> empty_vector(vector.length());
+    const int expected[] = {lengths...};
+    if(!has_shape(array, expected))
+    {
+        array.allocate(lengths...);
+    }
+}
+
+template <typename T, typename V=T>
+DynamicVector<V> empty_like(const DynamicVector<T>& vector)
+{
+    DynamicVector<V> empty_vector(vector.length());
     return empty_vector;
 };
 
-template <typename T, int NumDims>
+template <typename T, typename V=T, int NumDims>
 requires(NumDims > 1)
-DynamicArray<T, NumDims> empty_like(const DynamicArray<T, NumDims>& array)
+DynamicArray<V, NumDims> empty_like(const DynamicArray<T, NumDims>& array)
 {
-    DynamicArray<T, NumDims> empty_array;
-    empty_array.allocate_like(array);
+    DynamicArray<V, NumDims> empty_array;
+    if(is_rectangular(array))
+    {
+        std::apply([&](auto ... lengths)
+        {
+            empty_array.allocate(lengths...);
+        }, shape(array));
+        return empty_array;
+    }
+    empty_array.allocate(array.length());
+    for(int index = 0; index < array.length(); ++index)
+    {
+        empty_array(index) = empty_like<T, V>(array(index));
+    }
     return empty_array;
 };
 
+// Converts length elements; element types with dedicated conversion kernels overload it
+template <typename T, typename V>
+void convert(const T* source, V* target, int length)
+{
+    for(int index = 0; index < length; ++index)
+    {
+        target[index] = static_cast<V>(source[index]);
+    }
+}
+
+template <typename V, typename T, int NumDims>
+DynamicArray<V, NumDims> cast(const DynamicArray<T, NumDims>& array)
+{
+    DynamicArray<V, NumDims> converted = empty_like<T, V>(array);
+    for_each_leaf([](auto& target, const auto& source)
+    {
+        convert(source.data(), target.data(), source.length());
+    }, converted, array);
+    return converted;
+};
+
 template <typename T>
 bool all_equal(const DynamicVector<T>& left, const DynamicVector<T>& right)
 {
@@ -449,18 +847,27 @@ bool all_equal(const DynamicArray<T, NumDims>& left, const DynamicArray<T, NumDi
 };
 
 template <typename T>
-DynamicMatrix<T> Identity(int N)
+void fill_identity(DynamicMatrix<T>& matrix)
 {
-    DynamicMatrix<T> matrix(N,N);
-    auto identity_element = static_cast<T>(1);
-    auto zero_element = static_cast<T>(0);
-    for(int row = 0; row < N; ++row)
+    matrix.fill(static_cast<T>(0));
+    for(int row = 0; row < matrix.length(); ++row)
     {
-        for(int column = 0; column < N; ++column)
+        if(row < matrix(row).length())
         {
-            matrix(row,column) = (row == column ? identity_element : zero_element);
+            matrix(row,row) = static_cast<T>(1);
         }
     }
+};
+
+// Only the diagonal is written, so a large identity costs one page per row
+template <typename T>
+DynamicMatrix<T> Identity(int N)
+{
+    DynamicMatrix<T> matrix(zero_initialize, N, N);
+    for(int row = 0; row < N; ++row)
+    {
+        matrix(row,row) = static_cast<T>(1);
+    }
     return matrix;
 };
 
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <ostream>
+
+#if defined(__F16C__) || defined(__AVX512F__) || defined(__AVX512BF16__)
+#include <immintrin.h>
+#endif
+
+namespace math
+{
+
+// IEEE 754 binary16: 5 exponent and 10 mantissa bits, finite up to 65504
+struct Binary16
+{
+    // Rounds to nearest even; overflow gives infinity
+    static std::uint16_t encode(float value)
+    {
+        constexpr std::uint32_t infinity = 255u << 23;
+        constexpr std::uint32_t overflow = (127u + 16) << 23;
+        constexpr std::uint32_t smallest_normal = 113u << 23;
+        constexpr std::uint32_t subnormal_magic = ((127u - 15) + (23 - 10) + 1) << 23;
+        std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+        std::uint32_t sign = bits & 0x80000000u;
+        bits ^= sign;
+        std::uint32_t result;
+        if(bits >= overflow)
+        {
+            result = bits > infinity ? 0x7e00 : 0x7c00;
+        }
+        else if(bits < smallest_normal)
+        {
+            // Adding a magic number lets the float unit round the subnormal mantissa
+            float rounded = std::bit_cast<float>(bits) + std::bit_cast<float>(subnormal_magic);
+            result = std::bit_cast<std::uint32_t>(rounded) - subnormal_magic;
+        }
+        else
+        {
+            std::uint32_t odd = (bits >> 13) & 1;
+            bits += ((15u - 127) << 23) + 0xfff + odd;
+            result = bits >> 13;
+        }
+        return static_cast<std::uint16_t>(result | (sign >> 16));
+    }
+
+    static float decode(std::uint16_t half)
+    {
+        constexpr std::uint32_t exponent_mask = 0x7c00u << 13;
+        std::uint32_t bits = (half & 0x7fffu) << 13;
+        std::uint32_t exponent = bits & exponent_mask;
+        bits += (127u - 15) << 23;
+        if(exponent == exponent_mask)
+        {
+            bits += (128u - 16) << 23;
+        }
+        else if(exponent == 0)
+        {
+            bits += 1u << 23;
+            bits = std::bit_cast<std::uint32_t>(std::bit_cast<float>(bits) - std::bit_cast<float>(113u << 23));
+        }
+        return std::bit_cast<float>(bits | (static_cast<std::uint32_t>(half & 0x8000u) << 16));
+    }
+};
+
+// bfloat16: the upper half of a float, with its full exponent range and 7 mantissa bits
+struct BrainFloat16
+{
+    // Rounds to nearest even; NaNs stay quiet NaNs
+    static std::uint16_t encode(float value)
+    {
+        std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+        if((bits & 0x7fffffffu) > 0x7f800000u)
+        {
+            return static_cast<std::uint16_t>((bits >> 16) | 0x40);
+        }
+        bits += 0x7fffu + ((bits >> 16) & 1);
+        return static_cast<std::uint16_t>(bits >> 16);
+    }
+
+    static float decode(std::uint16_t half)
+    {
+        return std::bit_cast<float>(static_cast<std::uint32_t>(half) << 16);
+    }
+};
+
+// 16-bit storage for floating-point values. Elements convert to float for every operation, and
+// products and sums over arrays of them accumulate in float, so only storage is narrowed.
+template <typename Format>
+struct NarrowFloat
+{
+    std::uint16_t bits;
+
+    NarrowFloat() = default;
+
+    NarrowFloat(float value)
+    : bits(Format::encode(value)) {}
+
+    static NarrowFloat from_bits(std::uint16_t bits)
+    {
+        NarrowFloat value;
+        value.bits = bits;
+        return value;
+    }
+
+    operator float() const
+    {
+        return Format::decode(bits);
+    }
+
+    NarrowFloat& operator+=(float value)
+    {
+        return *this = static_cast<float>(*this) + value;
+    }
+
+    NarrowFloat& operator-=(float value)
+    {
+        return *this = static_cast<float>(*this) - value;
+    }
+
+    NarrowFloat& operator*=(float value)
+    {
+        return *this = static_cast<float>(*this)*value;
+    }
+
+    NarrowFloat& operator/=(float value)
+    {
+        return *this = static_cast<float>(*this)/value;
+    }
+
+    NarrowFloat operator-() const
+    {
+        return from_bits(bits ^ 0x8000);
+    }
+};
+
+using float16 = NarrowFloat<Binary16>;
+using bfloat16 = NarrowFloat<BrainFloat16>;
+
+template <typename Format>
+struct accumulator_type_of<NarrowFloat<Format>>
+{
+    using type = float;
+};
+
+template <typename Format>
+struct real_type_of<NarrowFloat<Format>>
+{
+    using type = float;
+};
+
+template <typename Format>
+std::ostream& operator<<(std::ostream& stream, NarrowFloat<Format> value)
+{
+    return stream << static_cast<float>(value);
+}
+
+// Conversion kernels behind cast() and the widening products, using F16C or AVX-512 where
+// the target has them
+
+inline void convert(const float16* source, float* target, int length)
+{
+    int index = 0;
+#if defined(__AVX512F__)
+    for(; index + 16 <= length; index += 16)
+    {
+        __m256i half = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + index));
+        _mm512_storeu_ps(target + index, _mm512_cvtph_ps(half));
+    }
+#endif
+#if defined(__F16C__)
+    for(; index + 8 <= length; index += 8)
+    {
+        __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + index));
+        _mm256_storeu_ps(target + index, _mm256_cvtph_ps(half));
+    }
+#endif
+    for(; index < length; ++index)
+    {
+        target[index] = Binary16::decode(source[index].bits);
+    }
+}
+
+inline void convert(const float* source, float16* target, int length)
+{
+    int index = 0;
+#if defined(__AVX512F__)
+    for(; index + 16 <= length; index += 16)
+    {
+        __m256i half = _mm512_cvtps_ph(_mm512_loadu_ps(source + index), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(target + index), half);
+    }
+#endif
+#if defined(__F16C__)
+    for(; index + 8 <= length; index += 8)
+    {
+        __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(source + index), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + index), half);
+    }
+#endif
+    for(; index < length; ++index)
+    {
+        target[index].bits = Binary16::encode(source[index]);
+    }
+}
+
+// A shift per element, which compilers vectorize without intrinsics
+inline void convert(const bfloat16* source, float* target, int length)
+{
+    for(int index = 0; index < length; ++index)
+    {
+        target[index] = std::bit_cast<float>(static_cast<std::uint32_t>(source[index].bits) << 16);
+    }
+}
+
+inline void convert(const float* source, bfloat16* target, int length)
+{
+    int index = 0;
+#if defined(__AVX512BF16__)
+    for(; index + 16 <= length; index += 16)
+    {
+        __m256bh half = _mm512_cvtneps_pbh(_mm512_loadu_ps(source + index));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(target + index), reinterpret_cast<__m256i&>(half));
+    }
+#endif
+    for(; index < length; ++index)
+    {
+        target[index].bits = BrainFloat16::encode(source[index]);
+    }
+}
+
+}
@@ -12,17 +12,20 @@ DynamicMatrix<T> triu(const DynamicMatrix<T>& matrix)
     int N = matrix.length();
     DynamicMatrix<T> upper_triangular(N,N);
     auto zero_element = static_cast<T>(0);
-    for(int row = 0; row < N; ++row)
+    parallel_for(0, N, grain_size(N), [&](int begin, int end)
     {
-        for(int column = 0; column < row; ++column)
+        for(int row = begin; row < end; ++row)
         {
-            upper_triangular(row,column) = zero_element;
+            for(int column = 0; column < row; ++column)
+            {
+                upper_triangular(row,column) = zero_element;
+            }
+            for(int column = row; column < N; ++column)
+            {
+                upper_triangular(row,column) = matrix(row,column);
+            }
         }
-        for(int column = row; column < N; ++column)
-        {
-            upper_triangular(row,column) = matrix(row,column);
-        }
-    }
+    });
     return upper_triangular;
 }
 
@@ -51,17 +54,20 @@ DynamicMatrix<T> tril(const DynamicMatrix<T>& matrix)
     int N = matrix.length();
     DynamicMatrix<T> lower_triangular(N,N);
     auto zero_element = static_cast<T>(0);
-    for(int row = 0; row < N; ++row)
+    parallel_for(0, N, grain_size(N), [&](int begin, int end)
     {
-        for(int column = 0; column <= row; ++column)
+        for(int row = begin; row < end; ++row)
         {
-            lower_triangular(row,column) = matrix(row,column);
+            for(int column = 0; column <= row; ++column)
+            {
+                lower_triangular(row,column) = matrix(row,column);
+            }
+            for(int column = row+1; column < N; ++column)
+            {
+                lower_triangular(row,column) = zero_element;
+            }
         }
-        for(int column = row+1; column < N; ++column)
-        {
-            lower_triangular(row,column) = zero_element;
-        }
-    }
+    });
     return lower_triangular;
 }
 
@@ -94,4 +100,34 @@ Array<T, true, High-Low, OtherDims...> slice(const Array<T, true, FirstDim, Othe
     }
     return sliced;
 }
-}
\ No newline at end of file
+
+template <typename T>
+DynamicMatrix<T> transpose(const DynamicMatrix<T>& matrix)
+{
+    int rows = matrix.length();
+    int columns = rows > 0 ? matrix(0).length() : 0;
+    DynamicMatrix<T> transposed(columns, rows);
+    for(int row = 0; row < rows; ++row)
+    {
+        for(int column = 0; column < columns; ++column)
+        {
+            transposed(column, row) = matrix(row, column);
+        }
+    }
+    return transposed;
+}
+
+template <typename T, int M, int N>
+Array<T, true, N, M> transpose(const Array<T, true, M, N>& matrix)
+{
+    Array<T, true, N, M> transposed;
+    for(int row = 0; row < M; ++row)
+    {
+        for(int column = 0; column < N; ++column)
+        {
+            transposed(column, row) = matrix(row, column);
+        }
+    }
+    return transposed;
+}
+}
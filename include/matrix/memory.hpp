@@ -0,0 +1,588 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace math
+{
+
+// Alignment of every array allocation, one cache line and the widest SIMD register
+constexpr std::size_t default_alignment = 64;
+
+constexpr std::size_t round_up(std::size_t value, std::size_t multiple)
+{
+    return (value + multiple - 1)/multiple*multiple;
+}
+
+class AlignedResource: public std::pmr::memory_resource
+{
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            return ::operator new(bytes, std::align_val_t(std::max(alignment, default_alignment)));
+        }
+
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override
+        {
+            ::operator delete(pointer, bytes, std::align_val_t(std::max(alignment, default_alignment)));
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+};
+
+inline AlignedResource* aligned_resource()
+{
+    static AlignedResource resource;
+    return &resource;
+}
+
+enum class HugePages
+{
+    No,
+    // Asks the kernel to back the block with transparent huge pages (MADV_HUGEPAGE)
+    Transparent,
+    // Maps from the reserved huge page pool (MAP_HUGETLB), or falls back to Transparent
+    // when no pages are reserved
+    Explicit
+};
+
+constexpr std::size_t huge_page_bytes = 1 << 21;
+
+inline std::size_t page_bytes()
+{
+#ifdef __linux__
+    static const std::size_t bytes = sysconf(_SC_PAGESIZE);
+    return bytes;
+#else
+    return 4096;
+#endif
+}
+
+inline std::size_t mapped_length(std::size_t bytes, HugePages huge_pages)
+{
+    return round_up(bytes, huge_pages == HugePages::No ? page_bytes() : huge_page_bytes);
+}
+
+// Anonymous private mapping of at least bytes, zeroed by the kernel, or nullptr on failure.
+// Huge page mappings are aligned to a huge page so that the kernel can actually use them.
+inline void* map_pages(std::size_t bytes, HugePages huge_pages)
+{
+#ifdef __linux__
+    std::size_t length = mapped_length(bytes, huge_pages);
+    if(huge_pages == HugePages::Explicit)
+    {
+        void* pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(pointer != MAP_FAILED)
+        {
+            return pointer;
+        }
+    }
+    if(huge_pages == HugePages::No)
+    {
+        void* pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return pointer == MAP_FAILED ? nullptr : pointer;
+    }
+    void* pointer = mmap(nullptr, length + huge_page_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(pointer == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    auto* start = static_cast<std::byte*>(pointer);
+    auto* aligned = reinterpret_cast<std::byte*>(round_up(reinterpret_cast<std::uintptr_t>(start), huge_page_bytes));
+    if(aligned != start)
+    {
+        munmap(start, aligned - start);
+    }
+    std::size_t tail = (start + length + huge_page_bytes) - (aligned + length);
+    if(tail > 0)
+    {
+        munmap(aligned + length, tail);
+    }
+    madvise(aligned, length, MADV_HUGEPAGE);
+    return aligned;
+#else
+    (void)bytes;
+    (void)huge_pages;
+    return nullptr;
+#endif
+}
+
+inline void unmap_pages(void* pointer, std::size_t bytes, HugePages huge_pages)
+{
+#ifdef __linux__
+    munmap(pointer, mapped_length(bytes, huge_pages));
+#else
+    (void)pointer;
+    (void)bytes;
+    (void)huge_pages;
+#endif
+}
+
+enum class Advice
+{
+    Normal,
+    // Read ahead aggressively and drop pages soon after they are read
+    Sequential,
+    Random,
+    WillNeed,
+    // Returns the pages to the kernel; the values they held become unspecified
+    DontNeed
+};
+
+// Passes advice on to the kernel for the whole pages inside [pointer, pointer + bytes).
+// Returns false where the kernel refused it or does not support it.
+inline bool advise(void* pointer, std::size_t bytes, Advice advice)
+{
+#ifdef __linux__
+    auto address = reinterpret_cast<std::uintptr_t>(pointer);
+    std::uintptr_t first = round_up(address, page_bytes());
+    std::uintptr_t last = (address + bytes)/page_bytes()*page_bytes();
+    if(last <= first)
+    {
+        return true;
+    }
+    int flags[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED, MADV_DONTNEED};
+    return madvise(reinterpret_cast<void*>(first), last - first, flags[static_cast<int>(advice)]) == 0;
+#else
+    (void)pointer;
+    (void)bytes;
+    (void)advice;
+    return false;
+#endif
+}
+
+// Blocks of at least min_bytes are mapped straight from the kernel, which hands them out
+// zeroed and maps the pages only when they are first touched. Smaller blocks go upstream.
+class MappedResource: public std::pmr::memory_resource
+{
+    private:
+        HugePages huge_pages_;
+        std::size_t min_bytes_;
+        std::pmr::memory_resource* upstream_;
+
+    protected:
+        // Called on every new mapping, before it is handed out
+        virtual void place(void*, std::size_t)
+        {
+        }
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            if(!mapped(bytes, alignment))
+            {
+                return upstream_->allocate(bytes, alignment);
+            }
+            void* pointer = map_pages(bytes, huge_pages_);
+            if(pointer == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            place(pointer, mapped_length(bytes, huge_pages_));
+            return pointer;
+        }
+
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override
+        {
+            if(!mapped(bytes, alignment))
+            {
+                upstream_->deallocate(pointer, bytes, alignment);
+                return;
+            }
+            unmap_pages(pointer, bytes, huge_pages_);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+    public:
+        explicit MappedResource(HugePages huge_pages = HugePages::Transparent, std::size_t min_bytes = 1 << 22, std::pmr::memory_resource* upstream = aligned_resource())
+        : huge_pages_(huge_pages), min_bytes_(min_bytes), upstream_(upstream) {}
+
+        MappedResource(const MappedResource&) = delete;
+        MappedResource& operator=(const MappedResource&) = delete;
+
+        bool mapped(std::size_t bytes, std::size_t alignment = default_alignment) const
+        {
+#ifdef __linux__
+            return bytes >= min_bytes_ && alignment <= page_bytes();
+#else
+            (void)bytes;
+            (void)alignment;
+            return false;
+#endif
+        }
+};
+
+// Default for new arrays: large blocks are mapped with transparent huge pages, small ones
+// come from the aligned heap
+inline MappedResource* large_page_resource()
+{
+    static MappedResource resource;
+    return &resource;
+}
+
+// Whether a block of bytes from resource comes back already zeroed
+inline bool allocates_zeroed(std::pmr::memory_resource* resource, std::size_t bytes)
+{
+    auto* mapped = dynamic_cast<MappedResource*>(resource);
+    return mapped != nullptr && mapped->mapped(bytes);
+}
+
+template <typename T>
+bool is_zero_bits(const T& value)
+{
+    if constexpr(std::is_trivially_copyable_v<T>)
+    {
+        T zero{};
+        return std::memcmp(&value, &zero, sizeof(T)) == 0;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// Zeroes bytes of a mapped block. Whole pages are handed back to the kernel, which maps its
+// shared zero page on the next read, instead of being written.
+inline void zero_mapped_bytes(void* block, std::size_t bytes)
+{
+    auto address = reinterpret_cast<std::uintptr_t>(block);
+    std::uintptr_t first = round_up(address, page_bytes());
+    std::uintptr_t last = (address + bytes)/page_bytes()*page_bytes();
+    if(last <= first || !advise(reinterpret_cast<void*>(first), last - first, Advice::DontNeed))
+    {
+        std::memset(block, 0, bytes);
+        return;
+    }
+    std::memset(block, 0, first - address);
+    std::memset(reinterpret_cast<void*>(last), 0, address + bytes - last);
+}
+
+// Zeroes a block allocated from resource, skipping the writes to whole mapped pages. Only
+// trivial types are cleared bytewise; the rest, such as std::complex, are filled with T{}.
+template <typename T>
+void zero_elements(std::pmr::memory_resource* resource, T* elements, std::size_t count)
+{
+    std::size_t bytes = count*sizeof(T);
+    if constexpr(std::is_trivial_v<T>)
+    {
+        if(allocates_zeroed(resource, bytes) && is_zero_bits(T{}))
+        {
+            zero_mapped_bytes(elements, bytes);
+            return;
+        }
+    }
+    std::fill(elements, elements + count, T{});
+}
+
+inline std::pmr::memory_resource*& current_array_resource()
+{
+    thread_local std::pmr::memory_resource* resource = large_page_resource();
+    return resource;
+}
+
+// Resource used by dynamic arrays constructed on this thread
+inline std::pmr::memory_resource* array_resource()
+{
+    return current_array_resource();
+}
+
+inline std::pmr::memory_resource* set_array_resource(std::pmr::memory_resource* resource)
+{
+    std::pmr::memory_resource* previous = current_array_resource();
+    current_array_resource() = resource ? resource : large_page_resource();
+    return previous;
+}
+
+// Makes resource the default for this thread until the end of the scope
+class ScopedResource
+{
+    private:
+        std::pmr::memory_resource* previous_;
+
+    public:
+        explicit ScopedResource(std::pmr::memory_resource* resource)
+        : previous_(set_array_resource(resource)) {}
+
+        ScopedResource(const ScopedResource&) = delete;
+        ScopedResource& operator=(const ScopedResource&) = delete;
+
+        ~ScopedResource()
+        {
+            set_array_resource(previous_);
+        }
+};
+
+// Bump allocator: allocation advances a pointer, deallocation does nothing, and release()
+// returns every block at once. Arrays allocated from an arena must not outlive it.
+// Not thread-safe.
+class ArenaResource: public std::pmr::memory_resource
+{
+    private:
+        struct Block
+        {
+            Block* next;
+            std::size_t bytes;
+        };
+
+        static constexpr std::size_t header_bytes = round_up(sizeof(Block), default_alignment);
+
+        std::pmr::memory_resource* upstream_;
+        std::size_t block_bytes_;
+        Block* blocks_;
+        std::byte* cursor_;
+        std::byte* end_;
+        std::size_t used_bytes_;
+
+        void add_block(std::size_t minimum_bytes)
+        {
+            std::size_t bytes = std::max(block_bytes_, round_up(minimum_bytes, default_alignment)) + header_bytes;
+            auto* block = static_cast<Block*>(upstream_->allocate(bytes, default_alignment));
+            block->next = blocks_;
+            block->bytes = bytes;
+            blocks_ = block;
+            cursor_ = reinterpret_cast<std::byte*>(block) + header_bytes;
+            end_ = reinterpret_cast<std::byte*>(block) + bytes;
+        }
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            alignment = std::max(alignment, default_alignment);
+            auto address = reinterpret_cast<std::uintptr_t>(cursor_);
+            auto aligned = reinterpret_cast<std::byte*>(round_up(address, alignment));
+            if(cursor_ == nullptr || aligned + bytes > end_)
+            {
+                add_block(bytes + alignment);
+                aligned = reinterpret_cast<std::byte*>(round_up(reinterpret_cast<std::uintptr_t>(cursor_), alignment));
+            }
+            cursor_ = aligned + bytes;
+            used_bytes_ += bytes;
+            return aligned;
+        }
+
+        void do_deallocate(void*, std::size_t, std::size_t) override
+        {
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+    public:
+        explicit ArenaResource(std::size_t block_bytes = 1 << 20, std::pmr::memory_resource* upstream = aligned_resource())
+        : upstream_(upstream), block_bytes_(block_bytes), blocks_(nullptr), cursor_(nullptr), end_(nullptr), used_bytes_(0) {}
+
+        ArenaResource(const ArenaResource&) = delete;
+        ArenaResource& operator=(const ArenaResource&) = delete;
+
+        ~ArenaResource() override
+        {
+            release();
+        }
+
+        void release()
+        {
+            while(blocks_ != nullptr)
+            {
+                Block* next = blocks_->next;
+                upstream_->deallocate(blocks_, blocks_->bytes, default_alignment);
+                blocks_ = next;
+            }
+            cursor_ = nullptr;
+            end_ = nullptr;
+            used_bytes_ = 0;
+        }
+
+        std::size_t used_bytes() const
+        {
+            return used_bytes_;
+        }
+};
+
+// Size-class pool: requests up to max_pooled_bytes are rounded up to a power of two and served
+// from a free list per class, so steady-state allocation of recurring sizes never reaches the
+// upstream resource. Larger requests go straight upstream. Not thread-safe.
+class PoolResource: public std::pmr::memory_resource
+{
+    private:
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        struct Chunk
+        {
+            Chunk* next;
+            std::size_t bytes;
+        };
+
+        static constexpr std::size_t min_class_bytes = default_alignment;
+        static constexpr int num_classes = 15;
+        static constexpr std::size_t max_pooled_bytes = min_class_bytes << (num_classes-1);
+        static constexpr std::size_t chunk_bytes = 1 << 20;
+        static constexpr std::size_t header_bytes = round_up(sizeof(Chunk), default_alignment);
+
+        std::pmr::memory_resource* upstream_;
+        FreeBlock* free_lists_[num_classes];
+        Chunk* chunks_;
+
+        static int size_class(std::size_t bytes)
+        {
+            int index = 0;
+            std::size_t class_bytes = min_class_bytes;
+            while(class_bytes < bytes)
+            {
+                class_bytes <<= 1;
+                ++index;
+            }
+            return index;
+        }
+
+        void refill(int index)
+        {
+            std::size_t class_bytes = min_class_bytes << index;
+            std::size_t bytes = header_bytes + std::max(chunk_bytes, class_bytes);
+            auto* chunk = static_cast<Chunk*>(upstream_->allocate(bytes, default_alignment));
+            chunk->next = chunks_;
+            chunk->bytes = bytes;
+            chunks_ = chunk;
+            std::byte* block = reinterpret_cast<std::byte*>(chunk) + header_bytes;
+            std::byte* end = reinterpret_cast<std::byte*>(chunk) + bytes;
+            for(; block + class_bytes <= end; block += class_bytes)
+            {
+                auto* free_block = reinterpret_cast<FreeBlock*>(block);
+                free_block->next = free_lists_[index];
+                free_lists_[index] = free_block;
+            }
+        }
+
+        static bool pooled(std::size_t bytes, std::size_t alignment)
+        {
+            return bytes <= max_pooled_bytes && alignment <= default_alignment;
+        }
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            if(!pooled(bytes, alignment))
+            {
+                return upstream_->allocate(bytes, alignment);
+            }
+            int index = size_class(bytes);
+            if(free_lists_[index] == nullptr)
+            {
+                refill(index);
+            }
+            FreeBlock* block = free_lists_[index];
+            free_lists_[index] = block->next;
+            return block;
+        }
+
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override
+        {
+            if(!pooled(bytes, alignment))
+            {
+                upstream_->deallocate(pointer, bytes, alignment);
+                return;
+            }
+            int index = size_class(bytes);
+            auto* block = static_cast<FreeBlock*>(pointer);
+            block->next = free_lists_[index];
+            free_lists_[index] = block;
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+    public:
+        explicit PoolResource(std::pmr::memory_resource* upstream = aligned_resource())
+        : upstream_(upstream), free_lists_(), chunks_(nullptr) {}
+
+        PoolResource(const PoolResource&) = delete;
+        PoolResource& operator=(const PoolResource&) = delete;
+
+        ~PoolResource() override
+        {
+            release();
+        }
+
+        // Returns every chunk upstream; blocks handed out before must no longer be in use
+        void release()
+        {
+            while(chunks_ != nullptr)
+            {
+                Chunk* next = chunks_->next;
+                upstream_->deallocate(chunks_, chunks_->bytes, default_alignment);
+                chunks_ = next;
+            }
+            std::fill(free_lists_, free_lists_ + num_classes, nullptr);
+        }
+};
+
+template <typename T>
+T* allocate_elements(std::pmr::memory_resource* resource, std::size_t count)
+{
+    if(count == 0)
+    {
+        return nullptr;
+    }
+    std::size_t alignment = std::max(alignof(T), default_alignment);
+    T* elements = static_cast<T*>(resource->allocate(count*sizeof(T), alignment));
+    try
+    {
+        std::uninitialized_default_construct_n(elements, count);
+    }
+    catch(...)
+    {
+        resource->deallocate(elements, count*sizeof(T), alignment);
+        throw;
+    }
+    return elements;
+}
+
+template <typename T>
+void deallocate_elements(std::pmr::memory_resource* resource, T* elements, std::size_t count)
+{
+    if(elements == nullptr)
+    {
+        return;
+    }
+    std::destroy_n(elements, count);
+    resource->deallocate(elements, count*sizeof(T), std::max(alignof(T), default_alignment));
+}
+
+// Elements per row of a contiguous block. Rows are padded to whole cache lines, so that every
+// row starts aligned, whenever the padding costs at most an eighth of the row.
+template <typename T>
+std::size_t padded_length(int length)
+{
+    std::size_t bytes = static_cast<std::size_t>(length)*sizeof(T);
+    std::size_t padded_bytes = round_up(bytes, default_alignment);
+    if(default_alignment % sizeof(T) != 0 || (padded_bytes - bytes)*8 > bytes)
+    {
+        return length;
+    }
+    return padded_bytes/sizeof(T);
+}
+
+}
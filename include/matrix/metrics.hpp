@@ -1,19 +1,201 @@
 #pragma once
 
 #include "products.hpp"
+#include "reductions.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace math
 {
 
-template <typename T>
-double norm(const DynamicVector<T>& vector)
+// Euclidean norm, scaled by the largest magnitude so that the squares neither overflow nor underflow
+template <typename T, bool IsStatic, int ... Shape>
+real_type<T> norm(const Array<T, IsStatic, Shape...>& array)
 {
-    return sqrt(dot(vector,vector));
+    using R = real_type<T>;
+    if(size(array) == 0)
+    {
+        return static_cast<R>(0);
+    }
+    R scale = find_extremum<R>(array, Greater(), Absolute()).value;
+    if(!(scale > static_cast<R>(0)) || !std::isfinite(scale))
+    {
+        return scale;
+    }
+    // Complex elements contribute the squares of both scaled parts
+    auto scaled_square = [](T value, auto scale_part)
+    {
+        if constexpr(is_complex_v<T>)
+        {
+            R real = scale_part(value.real());
+            R imag = scale_part(value.imag());
+            return real*real + imag*imag;
+        }
+        else
+        {
+            R scaled = scale_part(static_cast<R>(value));
+            return scaled*scaled;
+        }
+    };
+    R sum_of_squares;
+    if(scale >= std::numeric_limits<R>::min())
+    {
+        R inverse = static_cast<R>(1)/scale;
+        sum_of_squares = transformed_sum<R>(array, [&](T value)
+        {
+            return scaled_square(value, [inverse](R part) { return part*inverse; });
+        });
+    }
+    else
+    {
+        sum_of_squares = transformed_sum<R>(array, [&](T value)
+        {
+            return scaled_square(value, [scale](R part) { return part/scale; });
+        });
+    }
+    return scale*std::sqrt(sum_of_squares);
 }
 
-template <typename T, int N>
-double norm(const StaticVector<T,N>& vector)
+template <typename T, bool IsStatic, int ... Shape>
+real_type<T> frobenius_norm(const Array<T, IsStatic, Shape...>& matrix)
 {
-    return sqrt(static_cast<double>(dot(vector,vector)));
+    static_assert(array_rank<Array<T, IsStatic, Shape...>>::value == 2, "frobenius_norm is defined for matrices");
+    return norm(matrix);
+}
+
+// Vector 1-norm, or the induced matrix 1-norm (largest absolute column sum)
+template <typename T, bool IsStatic, int ... Shape>
+real_type<T> norm1(const Array<T, IsStatic, Shape...>& array)
+{
+    using R = real_type<T>;
+    constexpr int rank = array_rank<Array<T, IsStatic, Shape...>>::value;
+    static_assert(rank <= 2, "norm1 is defined for vectors and matrices");
+    if constexpr(rank == 1)
+    {
+        return transformed_sum<R>(array, Absolute());
+    }
+    else
+    {
+        R largest = static_cast<R>(0);
+        int columns = array.length() == 0 ? 0 : array(0).length();
+        for(int column = 0; column < columns; ++column)
+        {
+            R column_sum = static_cast<R>(0);
+            for(int row = 0; row < array.length(); ++row)
+            {
+                column_sum += static_cast<R>(std::abs(array(row,column)));
+            }
+            largest = std::max(largest, column_sum);
+        }
+        return largest;
+    }
+}
+
+// Vector infinity-norm, or the induced matrix infinity-norm (largest absolute row sum)
+template <typename T, bool IsStatic, int ... Shape>
+real_type<T> norm_inf(const Array<T, IsStatic, Shape...>& array)
+{
+    using R = real_type<T>;
+    constexpr int rank = array_rank<Array<T, IsStatic, Shape...>>::value;
+    static_assert(rank <= 2, "norm_inf is defined for vectors and matrices");
+    if(array.length() == 0)
+    {
+        return static_cast<R>(0);
+    }
+    if constexpr(rank == 1)
+    {
+        return find_extremum<R>(array, Greater(), Absolute()).value;
+    }
+    else
+    {
+        R largest = static_cast<R>(0);
+        for(int row = 0; row < array.length(); ++row)
+        {
+            largest = std::max(largest, norm1(array(row)));
+        }
+        return largest;
+    }
+}
+
+template <typename T, int NumDims>
+requires(NumDims > 1)
+DynamicArray<real_type<T>, NumDims-1> norm(const DynamicArray<T, NumDims>& array, int axis)
+{
+    using R = real_type<T>;
+    // One pass over the rows keeping a running scale and the sum of squares relative to it
+    auto accumulate = [](R& scale, R& sum_of_squares, R magnitude)
+    {
+        if(magnitude > scale)
+        {
+            R ratio = scale/magnitude;
+            sum_of_squares = static_cast<R>(1) + sum_of_squares*ratio*ratio;
+            scale = magnitude;
+        }
+        else if(magnitude > static_cast<R>(0))
+        {
+            R ratio = magnitude/scale;
+            sum_of_squares += ratio*ratio;
+        }
+        else if(std::isnan(magnitude))
+        {
+            scale = magnitude;
+        }
+    };
+    auto init = [&](const auto& row)
+    {
+        AxisAccumulator accumulator{empty_like<T, R>(row), empty_like<T, R>(row)};
+        for_each_leaf([&](auto& scale, auto& sum_of_squares, const auto& vector)
+        {
+            for(int index = 0; index < vector.length(); ++index)
+            {
+                scale.data()[index] = static_cast<R>(0);
+                sum_of_squares.data()[index] = static_cast<R>(0);
+                accumulate(scale.data()[index], sum_of_squares.data()[index], static_cast<R>(std::abs(vector.data()[index])));
+            }
+        }, accumulator.values, accumulator.other, row);
+        return accumulator;
+    };
+    auto fold = [&](auto& accumulator, const auto& row, int)
+    {
+        for_each_leaf([&](auto& scale, auto& sum_of_squares, const auto& vector)
+        {
+            for(int index = 0; index < vector.length(); ++index)
+            {
+                accumulate(scale.data()[index], sum_of_squares.data()[index], static_cast<R>(std::abs(vector.data()[index])));
+            }
+        }, accumulator.values, accumulator.other, row);
+    };
+    auto finish = [](auto& accumulator)
+    {
+        for_each_leaf([](auto& scale, const auto& sum_of_squares)
+        {
+            for(int index = 0; index < scale.length(); ++index)
+            {
+                scale.data()[index] *= std::sqrt(sum_of_squares.data()[index]);
+            }
+        }, accumulator.values, accumulator.other);
+        return accumulator.values;
+    };
+    auto reduce_vector = [](const auto& vector)
+    {
+        return norm(vector);
+    };
+    return reduce_axis<R>(array, axis, init, fold, finish, reduce_vector);
+}
+
+template <typename T, int NumDims>
+requires(NumDims > 1)
+DynamicArray<real_type<T>, NumDims-1> norm1(const DynamicArray<T, NumDims>& array, int axis)
+{
+    return sum_axis<real_type<T>>(array, axis, Absolute());
+}
+
+template <typename T, int NumDims>
+requires(NumDims > 1)
+DynamicArray<real_type<T>, NumDims-1> norm_inf(const DynamicArray<T, NumDims>& array, int axis)
+{
+    return extremum_axis<real_type<T>, false>(array, axis, Greater(), Absolute());
+}
 }
-}
\ No newline at end of file
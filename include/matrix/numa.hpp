@@ -0,0 +1,213 @@
+#pragma once
+
+#include "memory.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace math
+{
+
+// Parses a kernel id list such as "0-3,8,10-11"
+inline std::vector<int> parse_id_list(const std::string& list)
+{
+    std::vector<int> ids;
+    std::size_t position = 0;
+    while(position < list.size())
+    {
+        std::size_t end = list.find(',', position);
+        if(end == std::string::npos)
+        {
+            end = list.size();
+        }
+        std::string range = list.substr(position, end - position);
+        std::size_t dash = range.find('-');
+        try
+        {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash+1));
+            for(int id = first; id <= last; ++id)
+            {
+                ids.push_back(id);
+            }
+        }
+        catch(const std::exception&)
+        {
+        }
+        position = end + 1;
+    }
+    return ids;
+}
+
+inline std::vector<int> read_id_list(const std::string& path)
+{
+    std::ifstream file(path);
+    std::string list;
+    if(!file || !std::getline(file, list))
+    {
+        return {};
+    }
+    return parse_id_list(list);
+}
+
+// Online NUMA nodes; a single node 0 where the kernel exposes none
+inline const std::vector<int>& numa_nodes()
+{
+    static const std::vector<int> nodes = []
+    {
+        std::vector<int> online = read_id_list("/sys/devices/system/node/online");
+        return online.empty() ? std::vector<int>{0} : online;
+    }();
+    return nodes;
+}
+
+inline int num_numa_nodes()
+{
+    return numa_nodes().size();
+}
+
+// CPUs of one node, or every online CPU when the node cannot be read
+inline std::vector<int> numa_node_cpus(int node)
+{
+    std::vector<int> cpus = read_id_list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if(cpus.empty())
+    {
+        cpus = read_id_list("/sys/devices/system/cpu/online");
+    }
+    if(cpus.empty())
+    {
+        for(int cpu = 0; cpu < static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// Online CPUs ordered to alternate between nodes, so consecutive threads pinned along it
+// spread over every socket
+inline const std::vector<int>& spread_cpus()
+{
+    static const std::vector<int> cpus = []
+    {
+        std::vector<std::vector<int>> per_node;
+        for(int node : numa_nodes())
+        {
+            per_node.push_back(numa_node_cpus(node));
+        }
+        std::vector<int> order;
+        for(std::size_t index = 0; ; ++index)
+        {
+            bool any = false;
+            for(const std::vector<int>& cpus : per_node)
+            {
+                if(index < cpus.size())
+                {
+                    any = true;
+                    if(std::find(order.begin(), order.end(), cpus[index]) == order.end())
+                    {
+                        order.push_back(cpus[index]);
+                    }
+                }
+            }
+            if(!any)
+            {
+                break;
+            }
+        }
+        return order;
+    }();
+    return cpus;
+}
+
+// Restricts the calling thread to one CPU; false when the system refuses or does not support it
+inline bool pin_current_thread(int cpu)
+{
+#ifdef __linux__
+    if(cpu < 0 || cpu >= CPU_SETSIZE)
+    {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+enum class NumaPolicy
+{
+    // Each page lands on the node of the thread that first writes it. Dynamic arrays
+    // initialize such blocks in parallel, one block of rows per thread.
+    FirstTouch,
+    // Pages are spread round-robin over all nodes
+    Interleave
+};
+
+// Maps allocations of at least min_bytes straight from the kernel and places them according
+// to a NUMA policy; smaller ones go upstream. On a single node, or where mbind is refused,
+// the policy falls back to the kernel's default placement.
+class NumaResource: public MappedResource
+{
+    private:
+        NumaPolicy policy_;
+
+    protected:
+        void place(void* pointer, std::size_t length) override
+        {
+#ifdef __linux__
+            if(policy_ == NumaPolicy::Interleave && num_numa_nodes() > 1)
+            {
+                constexpr int interleave_mode = 3;
+                constexpr int mask_bits = 8*sizeof(unsigned long);
+                std::vector<unsigned long> mask(numa_nodes().back()/mask_bits + 1);
+                for(int node : numa_nodes())
+                {
+                    mask[node/mask_bits] |= 1ul << (node % mask_bits);
+                }
+                syscall(SYS_mbind, pointer, length, interleave_mode, mask.data(), mask.size()*mask_bits + 1, 0);
+            }
+#else
+            (void)pointer;
+            (void)length;
+#endif
+        }
+
+    public:
+        explicit NumaResource(NumaPolicy policy = NumaPolicy::FirstTouch, std::size_t min_bytes = 1 << 21, std::pmr::memory_resource* upstream = aligned_resource(),
+            HugePages huge_pages = HugePages::No)
+        : MappedResource(huge_pages, min_bytes, upstream), policy_(policy) {}
+
+        NumaPolicy policy() const
+        {
+            return policy_;
+        }
+
+        // Whether a block of this size is still unplaced and should be first written by the
+        // threads that will work on it
+        bool places_on_first_touch(std::size_t bytes) const
+        {
+            return policy_ == NumaPolicy::FirstTouch && mapped(bytes);
+        }
+};
+
+// Whether arrays allocated from resource should initialize a block of this size in parallel
+inline bool first_touch(std::pmr::memory_resource* resource, std::size_t bytes)
+{
+    auto* numa = dynamic_cast<NumaResource*>(resource);
+    return numa != nullptr && numa->places_on_first_touch(bytes);
+}
+
+}
@@ -2,20 +2,16 @@
 
 #include "base.hpp"
 #include "dynamic.hpp"
+#include "broadcasting.hpp"
 #include <cmath>
 
 namespace math
 {
 
-template <typename T, bool IsStatic, int ... Shape>
-Array<bool, IsStatic, Shape ...> operator==(const Array<T, IsStatic, Shape ...>& left, const Array<T, IsStatic, Shape ...>& right)
+template <typename T, bool IsStatic, int ... LeftShape, int ... RightShape>
+auto operator==(const Array<T, IsStatic, LeftShape ...>& left, const Array<T, IsStatic, RightShape ...>& right)
 {
-    Array<bool, IsStatic, Shape ... > result = empty_like<T, bool>(left);
-    for(int index = 0; index < result.length(); ++index)
-    {
-        result(index) = (left(index) == right(index));
-    }
-    return result;
+    return broadcast<bool>(left, right, [](T a, T b) { return a == b; });
 }
 
 template <bool IsStatic, int ... Shape>
@@ -29,10 +25,34 @@ Array<bool, IsStatic, Shape ...> operator!(const Array<bool, IsStatic, Shape ...
     return result;
 }
 
-template <typename T, bool IsStatic, int ... Shape>
-Array<bool, IsStatic, Shape ...> operator!=(const Array<T, IsStatic, Shape ...>& left, const Array<T, IsStatic, Shape ...>& right)
+template <typename T, bool IsStatic, int ... LeftShape, int ... RightShape>
+auto operator!=(const Array<T, IsStatic, LeftShape ...>& left, const Array<T, IsStatic, RightShape ...>& right)
+{
+    return broadcast<bool>(left, right, [](T a, T b) { return a != b; });
+}
+
+template <typename T, bool IsStatic, int ... LeftShape, int ... RightShape>
+auto operator<(const Array<T, IsStatic, LeftShape ...>& left, const Array<T, IsStatic, RightShape ...>& right)
+{
+    return broadcast<bool>(left, right, [](T a, T b) { return a < b; });
+}
+
+template <typename T, bool IsStatic, int ... LeftShape, int ... RightShape>
+auto operator<=(const Array<T, IsStatic, LeftShape ...>& left, const Array<T, IsStatic, RightShape ...>& right)
+{
+    return broadcast<bool>(left, right, [](T a, T b) { return a <= b; });
+}
+
+template <typename T, bool IsStatic, int ... LeftShape, int ... RightShape>
+auto operator>(const Array<T, IsStatic, LeftShape ...>& left, const Array<T, IsStatic, RightShape ...>& right)
 {
-    return !(left==right);
+    return broadcast<bool>(left, right, [](T a, T b) { return a > b; });
+}
+
+template <typename T, bool IsStatic, int ... LeftShape, int ... RightShape>
+auto operator>=(const Array<T, IsStatic, LeftShape ...>& left, const Array<T, IsStatic, RightShape ...>& right)
+{
+    return broadcast<bool>(left, right, [](T a, T b) { return a >= b; });
 }
 
 template <typename T, bool IsStatic, int ... Shape>
@@ -46,26 +66,29 @@ Array<T, IsStatic, Shape ...> operator-(const Array<T, IsStatic, Shape ...>& arr
     return negative_array;
 }
 
-template <typename T, bool IsStatic, int ... Shape>
-Array<T, IsStatic, Shape ...> operator+(const Array<T, IsStatic, Shape ...>& left, const Array<T, IsStatic, Shape ...>& right)
+template <typename T, bool IsStatic, int ... LeftShape, int ... RightShape>
+auto operator+(const Array<T, IsStatic, LeftShape ...>& left, const Array<T, IsStatic, RightShape ...>& right)
 {
-    auto summed = empty_like(left);
-    for(int index = 0; index < summed.length(); ++index)
-    {
-        summed(index) = left(index) + right(index);
-    }
-    return summed;
+    return broadcast<T>(left, right, [](T a, T b) { return a + b; });
 }
 
-template <typename T, bool IsStatic, int ... Shape>
-Array<T, IsStatic, Shape ...> operator-(const Array<T, IsStatic, Shape ...>& left, const Array<T, IsStatic, Shape ...>& right)
+template <typename T, bool IsStatic, int ... LeftShape, int ... RightShape>
+auto operator-(const Array<T, IsStatic, LeftShape ...>& left, const Array<T, IsStatic, RightShape ...>& right)
 {
-    auto summed = empty_like(left);
-    for(int index = 0; index < summed.length(); ++index)
-    {
-        summed(index) = left(index) - right(index);
-    }
-    return summed;
+    return broadcast<T>(left, right, [](T a, T b) { return a - b; });
+}
+
+// Elementwise product; operator* between arrays is the matrix product
+template <typename T, bool IsStatic, int ... LeftShape, int ... RightShape>
+auto multiply(const Array<T, IsStatic, LeftShape ...>& left, const Array<T, IsStatic, RightShape ...>& right)
+{
+    return broadcast<T>(left, right, [](T a, T b) { return a * b; });
+}
+
+template <typename T, bool IsStatic, int ... LeftShape, int ... RightShape>
+auto operator/(const Array<T, IsStatic, LeftShape ...>& left, const Array<T, IsStatic, RightShape ...>& right)
+{
+    return broadcast<T>(left, right, [](T a, T b) { return a / b; });
 }
 
 template <typename T, bool IsStatic, int ... Shape>
@@ -79,25 +102,67 @@ Array<T, IsStatic, Shape ...> operator/(const Array<T, IsStatic, Shape ...>& arr
     return divided;
 }
 
-template <typename T, bool IsStatic, int ... Shape>
-Array<T, IsStatic, Shape ...> operator/=(Array<T, IsStatic, Shape ...>& array, T divisor)
+// Elementwise product written into result, which may alias left for an in-place update
+template <typename T, bool IsStatic, int ... ResultShape, int ... LeftShape, int ... RightShape>
+Array<T, IsStatic, ResultShape ...>& multiply(const Array<T, IsStatic, LeftShape ...>& left, const Array<T, IsStatic, RightShape ...>& right, Array<T, IsStatic, ResultShape ...>& result)
+{
+    return broadcast_assign(result, left, right, [](T a, T b) { return a * b; });
+}
+
+template <typename T, bool IsStatic, int ... Shape, int ... OtherShape>
+Array<T, IsStatic, Shape ...>& operator+=(Array<T, IsStatic, Shape ...>& array, const Array<T, IsStatic, OtherShape ...>& other)
 {
-    for(int index = 0; index < array.length(); ++index)
+    return broadcast_assign(array, array, other, [](T a, T b) { return a + b; });
+}
+
+template <typename T, bool IsStatic, int ... Shape, int ... OtherShape>
+Array<T, IsStatic, Shape ...>& operator-=(Array<T, IsStatic, Shape ...>& array, const Array<T, IsStatic, OtherShape ...>& other)
+{
+    return broadcast_assign(array, array, other, [](T a, T b) { return a - b; });
+}
+
+template <typename T, bool IsStatic, int ... Shape, int ... OtherShape>
+Array<T, IsStatic, Shape ...>& operator/=(Array<T, IsStatic, Shape ...>& array, const Array<T, IsStatic, OtherShape ...>& other)
+{
+    return broadcast_assign(array, array, other, [](T a, T b) { return a / b; });
+}
+
+template <typename T, bool IsStatic, int ... Shape, typename Operation>
+Array<T, IsStatic, Shape ...>& update_each(Array<T, IsStatic, Shape ...>& array, Operation operation)
+{
+    parallel_for_each_leaf([&](auto& vector, int begin, int end)
     {
-        array(index) /= divisor;
-    }
+        T* values = vector.data();
+        for(int index = begin; index < end; ++index)
+        {
+            values[index] = operation(values[index]);
+        }
+    }, array);
     return array;
 }
 
-template <typename T, int N>
-T sum(const StaticVector<T,N>& vector)
+template <typename T, bool IsStatic, int ... Shape>
+Array<T, IsStatic, Shape ...>& operator+=(Array<T, IsStatic, Shape ...>& array, T value)
 {
-    T summation = vector(0);
-    for(int index = 1; index < N; ++index)
-    {
-        summation += vector(index);
-    }
-    return summation;
+    return update_each(array, [value](T element) { return element + value; });
+}
+
+template <typename T, bool IsStatic, int ... Shape>
+Array<T, IsStatic, Shape ...>& operator-=(Array<T, IsStatic, Shape ...>& array, T value)
+{
+    return update_each(array, [value](T element) { return element - value; });
+}
+
+template <typename T, bool IsStatic, int ... Shape>
+Array<T, IsStatic, Shape ...>& operator*=(Array<T, IsStatic, Shape ...>& array, T factor)
+{
+    return update_each(array, [factor](T element) { return element * factor; });
+}
+
+template <typename T, bool IsStatic, int ... Shape>
+Array<T, IsStatic, Shape ...>& operator/=(Array<T, IsStatic, Shape ...>& array, T divisor)
+{
+    return update_each(array, [divisor](T element) { return element / divisor; });
 }
 
 }
\ No newline at end of file
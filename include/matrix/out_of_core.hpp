@@ -0,0 +1,784 @@
+#pragma once
+
+#include "base.hpp"
+#include "dynamic.hpp"
+#include "products.hpp"
+#include "tiled.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace math
+{
+
+// Distinct for every file handle opened by the process, unlike its address
+inline unsigned long long next_file_serial()
+{
+    static std::atomic<unsigned long long> serial{0};
+    return ++serial;
+}
+
+// Row-major matrix of T stored in a flat binary file without a header
+template <typename T>
+class MatrixFile
+{
+    private:
+        int descriptor_;
+        int rows_;
+        int columns_;
+        unsigned long long serial_;
+
+        off_t offset(int row, int column) const
+        {
+            return (static_cast<off_t>(row)*columns_ + column)*static_cast<off_t>(sizeof(T));
+        }
+
+        void check_block(int row, int column, int height, int width) const
+        {
+            if(row < 0 || row + height > rows_)
+            {
+                throw OutOfRange(row + height - 1, rows_);
+            }
+            if(column < 0 || column + width > columns_)
+            {
+                throw OutOfRange(column + width - 1, columns_);
+            }
+        }
+
+    public:
+        enum class Mode {Read, ReadWrite, Create};
+
+        // Create makes a zero-filled file of the given shape, replacing any file at path
+        MatrixFile(const std::string& path, int rows, int columns, Mode mode = Mode::ReadWrite)
+        : descriptor_(-1), rows_(rows), columns_(columns), serial_(next_file_serial())
+        {
+            int flags = mode == Mode::Read ? O_RDONLY : (mode == Mode::Create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR);
+            descriptor_ = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+            if(descriptor_ < 0)
+            {
+                throw FileError(errno);
+            }
+            if(mode == Mode::Create && ftruncate(descriptor_, offset(rows, 0)) != 0)
+            {
+                int error = errno;
+                ::close(descriptor_);
+                throw FileError(error);
+            }
+        }
+
+        MatrixFile(const MatrixFile&) = delete;
+        MatrixFile& operator=(const MatrixFile&) = delete;
+
+        ~MatrixFile()
+        {
+            ::close(descriptor_);
+        }
+
+        int rows() const
+        {
+            return rows_;
+        }
+
+        int columns() const
+        {
+            return columns_;
+        }
+
+        // Identifies this handle in a TileCache, which outlives handles built at the same address
+        unsigned long long serial() const
+        {
+            return serial_;
+        }
+
+        // Reads the block whose first element is (row, column); the block's shape gives its extent
+        void read(int row, int column, DynamicMatrix<T>& block) const
+        {
+            int width = block.length() == 0 ? 0 : block(0).length();
+            check_block(row, column, block.length(), width);
+            for(int index = 0; index < block.length(); ++index)
+            {
+                auto* bytes = reinterpret_cast<char*>(block(index).data());
+                std::size_t remaining = width*sizeof(T);
+                off_t position = offset(row + index, column);
+                while(remaining > 0)
+                {
+                    ssize_t done = ::pread(descriptor_, bytes, remaining, position);
+                    if(done < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    if(done <= 0)
+                    {
+                        throw FileError(done < 0 ? errno : EIO);
+                    }
+                    bytes += done;
+                    remaining -= done;
+                    position += done;
+                }
+            }
+        }
+
+        // Writing goes through the descriptor and leaves the handle itself unchanged
+        void write(int row, int column, const DynamicMatrix<T>& block) const
+        {
+            int width = block.length() == 0 ? 0 : block(0).length();
+            check_block(row, column, block.length(), width);
+            for(int index = 0; index < block.length(); ++index)
+            {
+                const auto* bytes = reinterpret_cast<const char*>(block(index).data());
+                std::size_t remaining = width*sizeof(T);
+                off_t position = offset(row + index, column);
+                while(remaining > 0)
+                {
+                    ssize_t done = ::pwrite(descriptor_, bytes, remaining, position);
+                    if(done < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    if(done <= 0)
+                    {
+                        throw FileError(done < 0 ? errno : EIO);
+                    }
+                    bytes += done;
+                    remaining -= done;
+                    position += done;
+                }
+            }
+        }
+};
+
+template <typename T>
+void save(const std::string& path, const DynamicMatrix<T>& matrix)
+{
+    MatrixFile<T> file(path, matrix.length(), matrix.length() == 0 ? 0 : matrix(0).length(), MatrixFile<T>::Mode::Create);
+    file.write(0, 0, matrix);
+}
+
+template <typename T>
+DynamicMatrix<T> load(const std::string& path, int rows, int columns)
+{
+    MatrixFile<T> file(path, rows, columns, MatrixFile<T>::Mode::Read);
+    DynamicMatrix<T> matrix(rows, columns);
+    file.read(0, 0, matrix);
+    return matrix;
+}
+
+// Runs file transfers in order on one background thread, so computation overlaps with I/O
+// and a tile written back always lands before a later read of it
+class IOQueue
+{
+    private:
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        std::deque<std::packaged_task<void()>> jobs_;
+        int num_pending_ = 0;
+        bool stopping_ = false;
+        std::thread thread_;
+
+        void work()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while(true)
+            {
+                changed_.wait(lock, [this]{ return stopping_ || !jobs_.empty(); });
+                if(jobs_.empty())
+                {
+                    return;
+                }
+                std::packaged_task<void()> job = std::move(jobs_.front());
+                jobs_.pop_front();
+                lock.unlock();
+                job();
+                lock.lock();
+                --num_pending_;
+                changed_.notify_all();
+            }
+        }
+
+    public:
+        IOQueue()
+        : thread_([this]{ work(); }) {}
+
+        IOQueue(const IOQueue&) = delete;
+        IOQueue& operator=(const IOQueue&) = delete;
+
+        // Finishes the queued jobs first
+        ~IOQueue()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            changed_.notify_all();
+            thread_.join();
+        }
+
+        // The future rethrows what the job threw
+        std::shared_future<void> submit(std::function<void()> job)
+        {
+            std::packaged_task<void()> task(std::move(job));
+            std::shared_future<void> done = task.get_future().share();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                jobs_.push_back(std::move(task));
+                ++num_pending_;
+            }
+            changed_.notify_all();
+            return done;
+        }
+
+        void wait_idle()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [this]{ return num_pending_ == 0; });
+        }
+};
+
+// Square tiles of matrix files held in memory within a byte budget. A tile is pinned between
+// acquire() and release(); unpinned tiles are evicted least recently used first, and evicted
+// tiles that were modified are written back in the background. Tiles still being written
+// count against the budget until they are on disk.
+template <typename T>
+class TileCache
+{
+    private:
+        using Key = std::tuple<unsigned long long, int, int>;
+
+        struct Tile
+        {
+            const MatrixFile<T>* file;
+            std::shared_ptr<DynamicMatrix<T>> values;
+            std::shared_future<void> ready;
+            std::size_t bytes;
+            int pins = 0;
+            bool dirty = false;
+            long long last_use = 0;
+        };
+
+        int tile_size_;
+        std::size_t budget_bytes_;
+        std::size_t resident_bytes_ = 0;
+        std::size_t peak_bytes_ = 0;
+        std::shared_ptr<std::atomic<std::size_t>> writing_bytes_ = std::make_shared<std::atomic<std::size_t>>(0);
+        long long clock_ = 0;
+        std::map<Key, Tile> tiles_;
+        std::vector<std::shared_future<void>> writes_;
+        IOQueue io_;
+
+        int extent(int length, int index) const
+        {
+            return std::min(tile_size_, length - index*tile_size_);
+        }
+
+        std::size_t tile_bytes(int height, int width) const
+        {
+            return static_cast<std::size_t>(height)*padded_length<T>(width)*sizeof(T);
+        }
+
+        void write_back(const Key& key, Tile& tile)
+        {
+            std::size_t bytes = tile.bytes;
+            *writing_bytes_ += bytes;
+            auto [serial, row, column] = key;
+            writes_.push_back(io_.submit([file = tile.file, values = tile.values, writing = writing_bytes_, bytes, row, column, size = tile_size_]
+            {
+                struct Done
+                {
+                    std::atomic<std::size_t>& writing;
+                    std::size_t bytes;
+
+                    ~Done()
+                    {
+                        writing -= bytes;
+                    }
+                } done{*writing, bytes};
+                file->write(row*size, column*size, *values);
+            }));
+            tile.dirty = false;
+        }
+
+        // Evicts unpinned tiles until bytes more fit; false when the pinned tiles leave no room
+        bool make_room(std::size_t bytes)
+        {
+            while(resident_bytes_ + *writing_bytes_ + bytes > budget_bytes_)
+            {
+                auto victim = tiles_.end();
+                for(auto tile = tiles_.begin(); tile != tiles_.end(); ++tile)
+                {
+                    if(tile->second.pins == 0 && (victim == tiles_.end() || tile->second.last_use < victim->second.last_use))
+                    {
+                        victim = tile;
+                    }
+                }
+                if(victim == tiles_.end())
+                {
+                    if(*writing_bytes_ == 0)
+                    {
+                        return false;
+                    }
+                    io_.wait_idle();
+                    continue;
+                }
+                victim->second.ready.wait();
+                if(victim->second.dirty)
+                {
+                    write_back(victim->first, victim->second);
+                }
+                resident_bytes_ -= victim->second.bytes;
+                tiles_.erase(victim);
+            }
+            return true;
+        }
+
+        typename std::map<Key, Tile>::iterator insert(const MatrixFile<T>& file, int row, int column, bool read)
+        {
+            int height = extent(file.rows(), row);
+            int width = extent(file.columns(), column);
+            if(height <= 0 || width <= 0)
+            {
+                throw OutOfRange(height <= 0 ? row : column, height <= 0 ? file.rows() : file.columns());
+            }
+            std::size_t bytes = tile_bytes(height, width);
+            if(!make_room(bytes))
+            {
+                throw InsufficientMemory(resident_bytes_ + bytes, budget_bytes_);
+            }
+            Tile tile;
+            tile.file = &file;
+            tile.values = std::make_shared<DynamicMatrix<T>>(height, width);
+            tile.bytes = bytes;
+            if(read)
+            {
+                tile.ready = io_.submit([&file, values = tile.values, row = row*tile_size_, column = column*tile_size_]
+                {
+                    file.read(row, column, *values);
+                });
+            }
+            else
+            {
+                tile.values->fill(static_cast<T>(0));
+                std::promise<void> done;
+                done.set_value();
+                tile.ready = done.get_future().share();
+            }
+            resident_bytes_ += bytes;
+            peak_bytes_ = std::max(peak_bytes_, resident_bytes_ + *writing_bytes_);
+            return tiles_.emplace(Key{file.serial(), row, column}, std::move(tile)).first;
+        }
+
+    public:
+        TileCache(int tile_size, std::size_t budget_bytes)
+        : tile_size_(tile_size), budget_bytes_(budget_bytes) {}
+
+        TileCache(const TileCache&) = delete;
+        TileCache& operator=(const TileCache&) = delete;
+
+        int tile_size() const
+        {
+            return tile_size_;
+        }
+
+        std::size_t budget_bytes() const
+        {
+            return budget_bytes_;
+        }
+
+        // Most memory held by tiles at once, those being written back included
+        std::size_t peak_bytes() const
+        {
+            return peak_bytes_;
+        }
+
+        // Throws unless num_tiles full tiles fit in the budget together
+        void require(int num_tiles) const
+        {
+            std::size_t bytes = num_tiles*tile_bytes(tile_size_, tile_size_);
+            if(bytes > budget_bytes_)
+            {
+                throw InsufficientMemory(bytes, budget_bytes_);
+            }
+        }
+
+        // Tile (row, column) of file, pinned until release(). A tile that is not cached is read
+        // from the file, or starts at zero when read is false because it will be overwritten.
+        DynamicMatrix<T>& acquire(const MatrixFile<T>& file, int row, int column, bool read = true)
+        {
+            auto tile = tiles_.find(Key{file.serial(), row, column});
+            if(tile == tiles_.end())
+            {
+                tile = insert(file, row, column, read);
+            }
+            tile->second.ready.get();
+            ++tile->second.pins;
+            tile->second.last_use = ++clock_;
+            return *tile->second.values;
+        }
+
+        void release(const MatrixFile<T>& file, int row, int column, bool modified = false)
+        {
+            Tile& tile = tiles_.at(Key{file.serial(), row, column});
+            --tile.pins;
+            tile.dirty = tile.dirty || modified;
+        }
+
+        // Starts reading a tile in the background when it fits without evicting a pinned one
+        void prefetch(const MatrixFile<T>& file, int row, int column)
+        {
+            Key key{file.serial(), row, column};
+            if(tiles_.count(key) != 0)
+            {
+                return;
+            }
+            std::size_t bytes = tile_bytes(extent(file.rows(), row), extent(file.columns(), column));
+            if(make_room(bytes))
+            {
+                insert(file, row, column, true)->second.last_use = ++clock_;
+            }
+        }
+
+        // Writes every modified tile back and waits until all writes are on disk, rethrowing
+        // the first write error
+        void flush()
+        {
+            for(auto& [key, tile] : tiles_)
+            {
+                if(tile.dirty)
+                {
+                    tile.ready.wait();
+                    write_back(key, tile);
+                }
+            }
+            io_.wait_idle();
+            std::vector<std::shared_future<void>> writes;
+            writes.swap(writes_);
+            for(const std::shared_future<void>& write : writes)
+            {
+                write.get();
+            }
+        }
+
+        // Flushes, then frees every unpinned tile
+        void clear()
+        {
+            flush();
+            for(auto tile = tiles_.begin(); tile != tiles_.end();)
+            {
+                if(tile->second.pins == 0)
+                {
+                    resident_bytes_ -= tile->second.bytes;
+                    tile = tiles_.erase(tile);
+                }
+                else
+                {
+                    ++tile;
+                }
+            }
+        }
+};
+
+// C = A*B for matrices in files, one tile of C at a time. Tiles of C are visited row by row
+// in a serpentine order and the inner dimension alternates direction, so the tiles of A and B
+// used last for one tile of C are the first needed for the next, while they are still cached.
+// The next pair of tiles is read in the background while the current pair is multiplied.
+template <typename T>
+void out_of_core_multiply(const MatrixFile<T>& A, const MatrixFile<T>& B, const MatrixFile<T>& C, TileCache<T>& cache)
+{
+    if(A.columns() != B.rows())
+    {
+        throw MismatchedLength(A.columns(), B.rows());
+    }
+    if(C.rows() != A.rows() || C.columns() != B.columns())
+    {
+        throw MismatchedLength(C.rows() != A.rows() ? C.rows() : C.columns(), C.rows() != A.rows() ? A.rows() : B.columns());
+    }
+    cache.require(3);
+    int size = cache.tile_size();
+    int m_tiles = (A.rows() + size - 1)/size;
+    int n_tiles = (B.columns() + size - 1)/size;
+    int k_tiles = (A.columns() + size - 1)/size;
+    if(k_tiles == 0)
+    {
+        for(int i = 0; i < m_tiles; ++i)
+        {
+            for(int j = 0; j < n_tiles; ++j)
+            {
+                cache.acquire(C, i, j, false);
+                cache.release(C, i, j, true);
+            }
+        }
+        cache.flush();
+        return;
+    }
+
+    auto step = [=](long long index)
+    {
+        long long c_tile = index/k_tiles;
+        int i = c_tile/n_tiles;
+        int j = (c_tile % n_tiles);
+        j = i % 2 == 0 ? j : n_tiles-1 - j;
+        int p = index % k_tiles;
+        p = c_tile % 2 == 0 ? p : k_tiles-1 - p;
+        return std::array<int, 3>{i, j, p};
+    };
+    long long num_steps = static_cast<long long>(m_tiles)*n_tiles*k_tiles;
+    for(long long index = 0; index < num_steps; ++index)
+    {
+        auto [i, j, p] = step(index);
+        bool first = index % k_tiles == 0;
+        bool last = index % k_tiles == k_tiles-1;
+        DynamicMatrix<T>& c = cache.acquire(C, i, j, false);
+        if(!first)
+        {
+            cache.release(C, i, j);
+        }
+        const DynamicMatrix<T>& a = cache.acquire(A, i, p);
+        const DynamicMatrix<T>& b = cache.acquire(B, p, j);
+        if(index+1 < num_steps)
+        {
+            auto [next_i, next_j, next_p] = step(index+1);
+            cache.prefetch(A, next_i, next_p);
+            cache.prefetch(B, next_p, next_j);
+        }
+        gemm(static_cast<T>(1), a, b, static_cast<T>(1), c);
+        cache.release(A, i, p);
+        cache.release(B, p, j);
+        if(last)
+        {
+            cache.release(C, i, j, true);
+        }
+    }
+    cache.flush();
+}
+
+// Solves U^T X = X in place for the upper triangular diagonal tile U
+template <typename T>
+void transposed_upper_solve(const DynamicMatrix<T>& U, DynamicMatrix<T>& X)
+{
+    int width = X.length() == 0 ? 0 : X(0).length();
+    for(int row = 0; row < X.length(); ++row)
+    {
+        T* values = X(row).data();
+        for(int previous = 0; previous < row; ++previous)
+        {
+            axpy(width, -U(previous,row), X(previous).data(), values);
+        }
+        T inverse_pivot = 1/U(row,row);
+        for(int column = 0; column < width; ++column)
+        {
+            values[column] *= inverse_pivot;
+        }
+    }
+}
+
+// Solves L X = X in place for the unit lower triangle L stored below the diagonal of a tile
+template <typename T>
+void unit_lower_solve(const DynamicMatrix<T>& L, DynamicMatrix<T>& X)
+{
+    int width = X.length() == 0 ? 0 : X(0).length();
+    for(int row = 0; row < X.length(); ++row)
+    {
+        T* values = X(row).data();
+        for(int previous = 0; previous < row; ++previous)
+        {
+            axpy(width, -L(row,previous), X(previous).data(), values);
+        }
+    }
+}
+
+// Upper Cholesky factor of the symmetric matrix in A, which it overwrites with U (zeros
+// below the diagonal). Left-looking: tile row k of U is finished in a single pass that reads
+// the finished rows above it, so every tile is written exactly once.
+template <typename T>
+void out_of_core_cholesky(const MatrixFile<T>& A, TileCache<T>& cache)
+{
+    if(A.rows() != A.columns())
+    {
+        throw MismatchedLength(A.rows(), A.columns());
+    }
+    cache.require(3);
+    int size = cache.tile_size();
+    int num_tiles = (A.rows() + size - 1)/size;
+    for(int k = 0; k < num_tiles; ++k)
+    {
+        for(int j = 0; j < k; ++j)
+        {
+            cache.acquire(A, k, j, false);
+            cache.release(A, k, j, true);
+        }
+        for(int j = k; j < num_tiles; ++j)
+        {
+            DynamicMatrix<T>& x = cache.acquire(A, k, j);
+            for(int s = 0; s < k; ++s)
+            {
+                const DynamicMatrix<T>& left = cache.acquire(A, s, k);
+                const DynamicMatrix<T>& right = cache.acquire(A, s, j);
+                if(s+1 < k)
+                {
+                    cache.prefetch(A, s+1, j);
+                }
+                else if(j+1 < num_tiles)
+                {
+                    cache.prefetch(A, k, j+1);
+                    cache.prefetch(A, 0, j+1);
+                }
+                gemm(static_cast<T>(-1), left, Transpose::Yes, right, Transpose::No, static_cast<T>(1), x);
+                cache.release(A, s, k);
+                cache.release(A, s, j);
+            }
+            if(j == k)
+            {
+                tile_cholesky(x, 0, x.length());
+                for(int row = 1; row < x.length(); ++row)
+                {
+                    std::fill(x(row).data(), x(row).data() + row, static_cast<T>(0));
+                }
+            }
+            else
+            {
+                transposed_upper_solve(cache.acquire(A, k, k), x);
+                cache.release(A, k, k);
+            }
+            cache.release(A, k, j, true);
+        }
+    }
+    cache.flush();
+}
+
+// LU factorization with partial pivoting of the square matrix in A, which it overwrites with
+// the unit lower L below the diagonal and U on and above it, as LAPACK's getrf does. Returns
+// the pivots: row r was swapped with row pivots[r], in order of r. Left-looking over columns
+// of tiles: a whole column (the panel) stays pinned while every finished column to its left
+// is applied to it one tile at a time, so the budget must hold a column of tiles plus two.
+template <typename T>
+std::vector<int> out_of_core_lu(const MatrixFile<T>& A, TileCache<T>& cache)
+{
+    if(A.rows() != A.columns())
+    {
+        throw MismatchedLength(A.rows(), A.columns());
+    }
+    int N = A.rows();
+    int size = cache.tile_size();
+    int num_tiles = (N + size - 1)/size;
+    cache.require(num_tiles + 2);
+    std::vector<int> pivots(N);
+    std::vector<DynamicMatrix<T>*> panel(num_tiles);
+    auto panel_row = [&](int row)
+    {
+        return (*panel[row/size])(row % size).data();
+    };
+    auto swap_rows = [&](int first, int second, int width)
+    {
+        std::swap_ranges(panel_row(first), panel_row(first) + width, panel_row(second));
+    };
+
+    for(int k = 0; k < num_tiles; ++k)
+    {
+        for(int i = 0; i < num_tiles; ++i)
+        {
+            panel[i] = &cache.acquire(A, i, k);
+        }
+        int k0 = k*size;
+        int width = (*panel[0])(0).length();
+        for(int s = 0; s < k; ++s)
+        {
+            int s0 = s*size;
+            for(int row = s0; row < s0 + size; ++row)
+            {
+                if(pivots[row] != row)
+                {
+                    swap_rows(row, pivots[row], width);
+                }
+            }
+            unit_lower_solve(cache.acquire(A, s, s), *panel[s]);
+            cache.release(A, s, s);
+            for(int i = s+1; i < num_tiles; ++i)
+            {
+                const DynamicMatrix<T>& l = cache.acquire(A, i, s);
+                if(i+1 < num_tiles)
+                {
+                    cache.prefetch(A, i+1, s);
+                }
+                else if(s+1 < k)
+                {
+                    cache.prefetch(A, s+1, s+1);
+                }
+                gemm(static_cast<T>(-1), l, *panel[s], static_cast<T>(1), *panel[i]);
+                cache.release(A, i, s);
+            }
+        }
+
+        for(int column = 0; column < width; ++column)
+        {
+            int c = k0 + column;
+            int pivot = c;
+            for(int row = c+1; row < N; ++row)
+            {
+                if(std::abs(panel_row(row)[column]) > std::abs(panel_row(pivot)[column]))
+                {
+                    pivot = row;
+                }
+            }
+            pivots[c] = pivot;
+            if(pivot != c)
+            {
+                swap_rows(c, pivot, width);
+            }
+            const T* pivot_row = panel_row(c);
+            if(pivot_row[column] == static_cast<T>(0))
+            {
+                continue;
+            }
+            for(int row = c+1; row < N; ++row)
+            {
+                T* values = panel_row(row);
+                values[column] /= pivot_row[column];
+                axpy(width - (column+1), -values[column], pivot_row + column+1, values + column+1);
+            }
+        }
+        for(int i = 0; i < num_tiles; ++i)
+        {
+            cache.release(A, i, k, true);
+        }
+    }
+
+    // Swaps chosen for later columns still have to reach the columns of L to their left
+    for(int s = 0; s+1 < num_tiles; ++s)
+    {
+        for(int i = s+1; i < num_tiles; ++i)
+        {
+            panel[i] = &cache.acquire(A, i, s);
+        }
+        int width = (*panel[s+1])(0).length();
+        for(int row = (s+1)*size; row < N; ++row)
+        {
+            if(pivots[row] != row)
+            {
+                swap_rows(row, pivots[row], width);
+            }
+        }
+        for(int i = s+1; i < num_tiles; ++i)
+        {
+            cache.release(A, i, s, true);
+        }
+    }
+    cache.flush();
+    return pivots;
+}
+
+}
@@ -0,0 +1,461 @@
+#pragma once
+
+#include "base.hpp"
+#include "complex.hpp"
+#include "decompositions.hpp"
+#include "dynamic.hpp"
+#include "memory.hpp"
+#include "parallel.hpp"
+#include "products.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace math
+{
+
+enum class Triangle
+{
+    Upper,
+    Lower
+};
+
+// Elements of a triangle of order n. Offsets are 64-bit: n = 50000 already passes 2^31.
+inline std::size_t packed_size(int n)
+{
+    return static_cast<std::size_t>(n)*(n + 1)/2;
+}
+
+// Triangular matrix of order n that stores its triangle alone, row after row: row i of an upper
+// matrix holds columns i..n-1 and row i of a lower matrix columns 0..i, so every stored row is
+// contiguous and the vector kernels of products.hpp run over it
+template <typename T>
+class PackedTriangular
+{
+    private:
+        int n_ = 0;
+        Triangle triangle_ = Triangle::Upper;
+        std::pmr::vector<T> values_{array_resource()};
+
+    public:
+        PackedTriangular() = default;
+
+        PackedTriangular(int n, Triangle triangle)
+        : n_(n), triangle_(triangle), values_(packed_size(n), static_cast<T>(0), array_resource()) {}
+
+        PackedTriangular(const PackedTriangular& other)
+        : n_(other.n_), triangle_(other.triangle_), values_(other.values_, array_resource()) {}
+
+        PackedTriangular(PackedTriangular&& other) = default;
+        PackedTriangular& operator=(const PackedTriangular& other) = default;
+        PackedTriangular& operator=(PackedTriangular&& other) = default;
+
+        int order() const
+        {
+            return n_;
+        }
+
+        Triangle triangle() const
+        {
+            return triangle_;
+        }
+
+        std::size_t size() const
+        {
+            return values_.size();
+        }
+
+        // Column of the first stored element of row
+        int first_column(int row) const
+        {
+            return triangle_ == Triangle::Upper ? row : 0;
+        }
+
+        int row_length(int row) const
+        {
+            return triangle_ == Triangle::Upper ? n_ - row : row + 1;
+        }
+
+        T* row(int index)
+        {
+            return values_.data() + offset(index);
+        }
+
+        const T* row(int index) const
+        {
+            return values_.data() + offset(index);
+        }
+
+        // (row, column) must lie in the stored triangle
+        T& operator()(int row_index, int column)
+        {
+            return row(row_index)[column - first_column(row_index)];
+        }
+
+        const T& operator()(int row_index, int column) const
+        {
+            return row(row_index)[column - first_column(row_index)];
+        }
+
+        // Element anywhere in the matrix, zero outside the triangle
+        T element(int row_index, int column) const
+        {
+            bool stored = triangle_ == Triangle::Upper ? column >= row_index : column <= row_index;
+            return stored ? (*this)(row_index, column) : static_cast<T>(0);
+        }
+
+        T* data()
+        {
+            return values_.data();
+        }
+
+        const T* data() const
+        {
+            return values_.data();
+        }
+
+    private:
+        std::size_t offset(int index) const
+        {
+            std::size_t i = index;
+            return triangle_ == Triangle::Upper ? i*n_ - i*(i - 1)/2 : i*(i + 1)/2;
+        }
+};
+
+// Symmetric matrix, or Hermitian for complex T, stored as its upper triangle
+template <typename T>
+struct PackedSymmetric
+{
+    PackedTriangular<T> upper;
+
+    PackedSymmetric() = default;
+
+    explicit PackedSymmetric(int n)
+    : upper(n, Triangle::Upper) {}
+
+    int order() const
+    {
+        return upper.order();
+    }
+
+    T element(int row, int column) const
+    {
+        return column >= row ? upper(row, column) : conjugate(upper(column, row));
+    }
+};
+
+// Packs the triangle of a square matrix; the other triangle is not read
+template <typename T>
+PackedTriangular<T> pack(const DynamicMatrix<T>& A, Triangle triangle)
+{
+    check_square(A);
+    int n = A.length();
+    PackedTriangular<T> packed(n, triangle);
+    parallel_for(0, n, grain_size(n), [&](int begin, int end)
+    {
+        for(int row = begin; row < end; ++row)
+        {
+            const T* source = A(row).data() + packed.first_column(row);
+            std::copy(source, source + packed.row_length(row), packed.row(row));
+        }
+    });
+    return packed;
+}
+
+// Packs a symmetric or Hermitian matrix from its upper triangle
+template <typename T>
+PackedSymmetric<T> pack_symmetric(const DynamicMatrix<T>& A)
+{
+    PackedSymmetric<T> packed;
+    packed.upper = pack(A, Triangle::Upper);
+    return packed;
+}
+
+template <typename T>
+DynamicMatrix<T> unpack(const PackedTriangular<T>& A)
+{
+    int n = A.order();
+    DynamicMatrix<T> full(n, n);
+    parallel_for(0, n, grain_size(n), [&](int begin, int end)
+    {
+        for(int row = begin; row < end; ++row)
+        {
+            for(int column = 0; column < n; ++column)
+            {
+                full(row, column) = A.element(row, column);
+            }
+        }
+    });
+    return full;
+}
+
+template <typename T>
+DynamicMatrix<T> unpack(const PackedSymmetric<T>& A)
+{
+    int n = A.order();
+    DynamicMatrix<T> full(n, n);
+    parallel_for(0, n, grain_size(n), [&](int begin, int end)
+    {
+        for(int row = begin; row < end; ++row)
+        {
+            for(int column = 0; column < n; ++column)
+            {
+                full(row, column) = A.element(row, column);
+            }
+        }
+    });
+    return full;
+}
+
+template <typename T>
+void check_packed_lengths(int n, const DynamicVector<T>& x, const DynamicVector<T>& y)
+{
+    if(x.length() != n)
+    {
+        throw MismatchedLength(x.length(), n);
+    }
+    if(y.length() != n)
+    {
+        throw MismatchedLength(y.length(), n);
+    }
+}
+
+// y = alpha*op(A)*x + beta*y into the caller's y; y must not alias x
+template <typename T>
+DynamicVector<T>& gemv(T alpha, const PackedTriangular<T>& A, Transpose transpose_A, const DynamicVector<T>& x, T beta, DynamicVector<T>& y)
+{
+    int n = A.order();
+    check_packed_lengths(n, x, y);
+    scale(y, beta);
+    if(alpha == static_cast<T>(0))
+    {
+        return y;
+    }
+    if(transpose_A == Transpose::No)
+    {
+        parallel_for(0, n, grain_size(n), [&](int begin, int end)
+        {
+            for(int row = begin; row < end; ++row)
+            {
+                y(row) += alpha*dot(A.row_length(row), A.row(row), x.data() + A.first_column(row));
+            }
+        });
+    }
+    else
+    {
+        // Threads take disjoint ranges of y and add the slice of every stored row that falls in it
+        parallel_for(0, n, grain_size(n), [&](int begin, int end)
+        {
+            for(int inner = 0; inner < n; ++inner)
+            {
+                int first = std::max(begin, A.first_column(inner));
+                int last = std::min(end, A.first_column(inner) + A.row_length(inner));
+                if(first >= last)
+                {
+                    continue;
+                }
+                const T* a = A.row(inner) + (first - A.first_column(inner));
+                if(transpose_A == Transpose::ConjugateTranspose)
+                {
+                    axpyc(last - first, alpha*x(inner), a, y.data() + first);
+                }
+                else
+                {
+                    axpy(last - first, alpha*x(inner), a, y.data() + first);
+                }
+            }
+        });
+    }
+    return y;
+}
+
+// y = alpha*A*x + beta*y into the caller's y; y must not alias x. Each stored row contributes
+// a dot product to its own element of y and, past the diagonal, its conjugate to the others.
+template <typename T>
+DynamicVector<T>& gemv(T alpha, const PackedSymmetric<T>& A, const DynamicVector<T>& x, T beta, DynamicVector<T>& y)
+{
+    int n = A.order();
+    check_packed_lengths(n, x, y);
+    scale(y, beta);
+    if(alpha == static_cast<T>(0))
+    {
+        return y;
+    }
+    const PackedTriangular<T>& U = A.upper;
+    parallel_for(0, n, grain_size(n), [&](int begin, int end)
+    {
+        for(int row = begin; row < end; ++row)
+        {
+            y(row) += alpha*dot(n - row, U.row(row), x.data() + row);
+        }
+        for(int inner = 0; inner < end - 1; ++inner)
+        {
+            int first = std::max(begin, inner + 1);
+            axpyc(end - first, alpha*x(inner), U.row(inner) + (first - inner), y.data() + first);
+        }
+    });
+    return y;
+}
+
+template <typename T>
+DynamicVector<T> operator*(const PackedTriangular<T>& A, const DynamicVector<T>& x)
+{
+    DynamicVector<T> answer(A.order());
+    gemv(static_cast<T>(1), A, Transpose::No, x, static_cast<T>(0), answer);
+    return answer;
+}
+
+template <typename T>
+DynamicVector<T> operator*(const PackedSymmetric<T>& A, const DynamicVector<T>& x)
+{
+    DynamicVector<T> answer(A.order());
+    gemv(static_cast<T>(1), A, x, static_cast<T>(0), answer);
+    return answer;
+}
+
+// Solves op(A) x = b into x, which may be b itself. Rows are walked as stored: a dot product
+// per row when op keeps A's triangle, an axpy per row when it transposes it.
+template <typename T>
+void triangular_solve(const PackedTriangular<T>& A, Transpose transpose_A, const DynamicVector<T>& b, DynamicVector<T>& x)
+{
+    int n = A.order();
+    if(b.length() != n)
+    {
+        throw MismatchedLength(b.length(), n);
+    }
+    if(&x != &b)
+    {
+        ensure_shape(x, n);
+        x.fill(b);
+    }
+    T* values = x.data();
+    bool conjugated = transpose_A == Transpose::ConjugateTranspose;
+    auto diagonal = [&](int index)
+    {
+        T value = A(index, index);
+        return conjugated ? conjugate(value) : value;
+    };
+    auto eliminate = [&](int length, T value, const T* a, T* target)
+    {
+        if(conjugated)
+        {
+            axpyc(length, -value, a, target);
+        }
+        else
+        {
+            axpy(length, -value, a, target);
+        }
+    };
+    bool upper = A.triangle() == Triangle::Upper;
+    if(transpose_A == Transpose::No && upper)
+    {
+        for(int index = n - 1; index >= 0; --index)
+        {
+            const T* row = A.row(index);
+            values[index] = (values[index] - dot(n - index - 1, row + 1, values + index + 1))/row[0];
+        }
+    }
+    else if(transpose_A == Transpose::No)
+    {
+        for(int index = 0; index < n; ++index)
+        {
+            const T* row = A.row(index);
+            values[index] = (values[index] - dot(index, row, values))/row[index];
+        }
+    }
+    else if(upper)
+    {
+        for(int index = 0; index < n; ++index)
+        {
+            values[index] /= diagonal(index);
+            eliminate(n - index - 1, values[index], A.row(index) + 1, values + index + 1);
+        }
+    }
+    else
+    {
+        for(int index = n - 1; index >= 0; --index)
+        {
+            values[index] /= diagonal(index);
+            eliminate(index, values[index], A.row(index), values);
+        }
+    }
+}
+
+template <typename T>
+DynamicVector<T> triangular_solve(const PackedTriangular<T>& A, Transpose transpose_A, const DynamicVector<T>& b)
+{
+    DynamicVector<T> x(b);
+    triangular_solve(A, transpose_A, x, x);
+    return x;
+}
+
+// Factors a packed upper triangle in place into U with A = U^T U, or A = U^H U, like
+// cholesky_factor. Row i is scaled first and then subtracted from every later row, each update
+// being an axpy over contiguous storage that threads split by rows.
+template <typename T>
+void packed_cholesky_factor(PackedTriangular<T>& U)
+{
+    int n = U.order();
+    for(int i = 0; i < n; ++i)
+    {
+        T* pivot_row = U.row(i);
+        pivot_row[0] = real_part(pivot_row[0]);
+        if(!(real_part(pivot_row[0]) > 0))
+        {
+            throw NotPositiveDefinite(i);
+        }
+        auto sqrt_factor = std::sqrt(real_part(pivot_row[0]));
+        for(int column = 0; column < n - i; ++column)
+        {
+            pivot_row[column] /= sqrt_factor;
+        }
+        parallel_for(i + 1, n, grain_size(n - i), [&](int begin, int end)
+        {
+            for(int j = begin; j < end; ++j)
+            {
+                axpy(n - j, -conjugate(pivot_row[j - i]), pivot_row + (j - i), U.row(j));
+            }
+        });
+    }
+}
+
+template <typename T>
+struct PackedCholeskyDecomposition
+{
+    PackedTriangular<T> cholesky;
+
+    PackedCholeskyDecomposition(const PackedSymmetric<T>& A)
+    : cholesky(A.upper)
+    {
+        packed_cholesky_factor(cholesky);
+    }
+
+    // Factors in A's own storage, for matrices too large to hold twice
+    PackedCholeskyDecomposition(PackedSymmetric<T>&& A)
+    : cholesky(std::move(A.upper))
+    {
+        packed_cholesky_factor(cholesky);
+    }
+};
+
+// Solves U^T U x = b, or U^H U x = b, into x, which may be b itself
+template <typename T>
+void solve(const PackedCholeskyDecomposition<T>& cholesky_decomp, const DynamicVector<T>& b, DynamicVector<T>& x)
+{
+    triangular_solve(cholesky_decomp.cholesky, Transpose::ConjugateTranspose, b, x);
+    triangular_solve(cholesky_decomp.cholesky, Transpose::No, x, x);
+}
+
+template <typename T>
+DynamicVector<T> solve(const PackedCholeskyDecomposition<T>& cholesky_decomp, const DynamicVector<T>& b)
+{
+    DynamicVector<T> x;
+    solve(cholesky_decomp, b, x);
+    return x;
+}
+
+}
@@ -0,0 +1,470 @@
+#pragma once
+
+#include "base.hpp"
+#include "numa.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace math
+{
+
+inline int default_num_threads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs the chunks of a parallel loop. Library code reaches it through current_executor(), so
+// an application with its own thread pool can adopt it with set_executor() or ScopedExecutor.
+class Executor
+{
+    public:
+        virtual ~Executor() = default;
+
+        // Number of threads that may run chunks at once, the calling thread included
+        virtual int concurrency() const = 0;
+
+        // Calls chunk(index) once for each index in [0, num_chunks) and returns when all of
+        // them have finished. It may be called again from inside a chunk.
+        virtual void run(int num_chunks, const std::function<void(int)>& chunk) = 0;
+};
+
+// Runs every chunk on the calling thread
+class SerialExecutor: public Executor
+{
+    public:
+        int concurrency() const override
+        {
+            return 1;
+        }
+
+        void run(int num_chunks, const std::function<void(int)>& chunk) override
+        {
+            for(int index = 0; index < num_chunks; ++index)
+            {
+                chunk(index);
+            }
+        }
+};
+
+// Work-stealing pool. Each worker owns a deque: jobs queued from a worker go to the back of
+// its own deque and it takes them back from there, while idle workers steal from the front
+// of the others. A thread waiting for its chunks runs queued jobs while there are any, and
+// only sleeps once every chunk of its loop has been claimed, so chunks that start parallel
+// loops of their own cannot deadlock the pool.
+class ThreadPool: public Executor
+{
+    private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> jobs;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<std::thread> threads_;
+        std::mutex sleep_mutex_;
+        std::condition_variable wake_;
+        std::atomic<int> num_queued_{0};
+        std::atomic<unsigned> next_worker_{0};
+        bool stopping_ = false;
+
+        static inline thread_local ThreadPool* current_pool_ = nullptr;
+        static inline thread_local int current_index_ = -1;
+
+        int own_index() const
+        {
+            return current_pool_ == this ? current_index_ : -1;
+        }
+
+        void push(std::function<void()> job)
+        {
+            int index = own_index();
+            if(index < 0)
+            {
+                index = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+            }
+            {
+                std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+                workers_[index]->jobs.push_back(std::move(job));
+            }
+            num_queued_.fetch_add(1);
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+            }
+            wake_.notify_one();
+        }
+
+        bool pop(int index, std::function<void()>& job)
+        {
+            if(index >= 0)
+            {
+                Worker& own = *workers_[index];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if(!own.jobs.empty())
+                {
+                    job = std::move(own.jobs.back());
+                    own.jobs.pop_back();
+                    return true;
+                }
+            }
+            int num_workers = workers_.size();
+            for(int offset = 1; offset <= num_workers; ++offset)
+            {
+                int victim = (std::max(index, 0) + offset) % num_workers;
+                Worker& other = *workers_[victim];
+                std::lock_guard<std::mutex> lock(other.mutex);
+                if(!other.jobs.empty())
+                {
+                    job = std::move(other.jobs.front());
+                    other.jobs.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool run_one(int index)
+        {
+            std::function<void()> job;
+            if(!pop(index, job))
+            {
+                return false;
+            }
+            num_queued_.fetch_sub(1);
+            job();
+            return true;
+        }
+
+        void work(int index)
+        {
+            current_pool_ = this;
+            current_index_ = index;
+            while(true)
+            {
+                if(run_one(index))
+                {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sleep_mutex_);
+                wake_.wait(lock, [this]{ return stopping_ || num_queued_.load() > 0; });
+                if(stopping_ && num_queued_.load() == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+    public:
+        enum class Pinning {No, Cores};
+
+        // Starts num_threads workers; the threads that call run() work alongside them. Pinned
+        // workers each stay on one CPU, taken alternately from every NUMA node, so that pages
+        // they touch first stay local to them.
+        explicit ThreadPool(int num_threads = default_num_threads() - 1, Pinning pinning = Pinning::No)
+        {
+            for(int index = 0; index < num_threads; ++index)
+            {
+                workers_.push_back(std::make_unique<Worker>());
+            }
+            for(int index = 0; index < num_threads; ++index)
+            {
+                threads_.emplace_back([this, index, pinning]
+                {
+                    if(pinning == Pinning::Cores)
+                    {
+                        const std::vector<int>& cpus = spread_cpus();
+                        pin_current_thread(cpus[(index + 1) % cpus.size()]);
+                    }
+                    work(index);
+                });
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() override
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                stopping_ = true;
+            }
+            wake_.notify_all();
+            for(std::thread& thread : threads_)
+            {
+                thread.join();
+            }
+        }
+
+        int concurrency() const override
+        {
+            return workers_.size() + 1;
+        }
+
+        // Rethrows the first exception a chunk threw; chunks not yet started by then are skipped
+        void run(int num_chunks, const std::function<void(int)>& chunk) override
+        {
+            if(num_chunks <= 1 || workers_.empty())
+            {
+                for(int index = 0; index < num_chunks; ++index)
+                {
+                    chunk(index);
+                }
+                return;
+            }
+
+            // Helpers may still be dequeued after run() returns, so they share the loop state
+            // and find no chunks left rather than touching the caller's frame
+            struct Loop
+            {
+                const std::function<void(int)>* chunk;
+                int num_chunks;
+                std::atomic<int> next{0};
+                std::atomic<int> num_finished{0};
+                std::atomic<bool> failed{false};
+                std::mutex error_mutex;
+                std::exception_ptr error;
+            };
+            auto loop = std::make_shared<Loop>();
+            loop->chunk = &chunk;
+            loop->num_chunks = num_chunks;
+            auto drain = [loop]
+            {
+                int index;
+                while((index = loop->next.fetch_add(1)) < loop->num_chunks)
+                {
+                    if(!loop->failed.load())
+                    {
+                        try
+                        {
+                            (*loop->chunk)(index);
+                        }
+                        catch(...)
+                        {
+                            std::lock_guard<std::mutex> lock(loop->error_mutex);
+                            if(!loop->failed.exchange(true))
+                            {
+                                loop->error = std::current_exception();
+                            }
+                        }
+                    }
+                    if(loop->num_finished.fetch_add(1, std::memory_order_acq_rel) + 1 == loop->num_chunks)
+                    {
+                        loop->num_finished.notify_all();
+                    }
+                }
+            };
+
+            int num_helpers = std::min<int>(num_chunks - 1, workers_.size());
+            for(int helper = 0; helper < num_helpers; ++helper)
+            {
+                push(drain);
+            }
+            drain();
+            // The chunks left are running on other threads; sleep until the last one wakes us
+            // rather than spinning for as long as it takes
+            int index = own_index();
+            int num_finished;
+            while((num_finished = loop->num_finished.load(std::memory_order_acquire)) < num_chunks)
+            {
+                if(!run_one(index))
+                {
+                    loop->num_finished.wait(num_finished, std::memory_order_acquire);
+                }
+            }
+            if(loop->error)
+            {
+                std::rethrow_exception(loop->error);
+            }
+        }
+};
+
+// Whether the default pool pins its workers; only read when the pool starts
+inline std::atomic<ThreadPool::Pinning>& default_pool_pinning()
+{
+    static std::atomic<ThreadPool::Pinning> pinning{ThreadPool::Pinning::No};
+    return pinning;
+}
+
+// Pool behind the library's parallel loops, started on first use
+inline ThreadPool& default_pool()
+{
+    static ThreadPool pool(default_num_threads() - 1, default_pool_pinning().load());
+    return pool;
+}
+
+inline std::atomic<Executor*>& executor_slot()
+{
+    static std::atomic<Executor*> executor{nullptr};
+    return executor;
+}
+
+inline Executor& current_executor()
+{
+    Executor* executor = executor_slot().load(std::memory_order_acquire);
+    return executor ? *executor : default_pool();
+}
+
+// Routes the library's parallel loops to executor, or back to the default pool for nullptr,
+// for every thread; returns the previous executor
+inline Executor* set_executor(Executor* executor)
+{
+    return executor_slot().exchange(executor);
+}
+
+class ScopedExecutor
+{
+    private:
+        Executor* previous_;
+
+    public:
+        explicit ScopedExecutor(Executor* executor)
+        : previous_(set_executor(executor)) {}
+
+        ScopedExecutor(const ScopedExecutor&) = delete;
+        ScopedExecutor& operator=(const ScopedExecutor&) = delete;
+
+        ~ScopedExecutor()
+        {
+            set_executor(previous_);
+        }
+};
+
+// Elementary operations below which a loop stays on the calling thread
+constexpr int parallel_grain = 1 << 15;
+
+// Loop iterations per chunk when each iteration costs work_per_item elementary operations
+inline int grain_size(long long work_per_item)
+{
+    return std::max<long long>(1, parallel_grain/std::max<long long>(1, work_per_item));
+}
+
+// Calls body(chunk_begin, chunk_end) over disjoint chunks covering [begin, end), each at least
+// grain long. Ranges no longer than grain run inline without touching the executor.
+template <typename Body>
+void parallel_for(int begin, int end, int grain, Body&& body)
+{
+    int length = end - begin;
+    grain = std::max(grain, 1);
+    if(length <= grain)
+    {
+        if(length > 0)
+        {
+            body(begin, end);
+        }
+        return;
+    }
+    Executor& executor = current_executor();
+    int concurrency = executor.concurrency();
+    if(concurrency == 1)
+    {
+        body(begin, end);
+        return;
+    }
+    int num_chunks = std::min((length + grain - 1)/grain, 4*concurrency);
+    executor.run(num_chunks, [&](int chunk)
+    {
+        int chunk_begin = begin + static_cast<long long>(length)*chunk/num_chunks;
+        int chunk_end = begin + static_cast<long long>(length)*(chunk+1)/num_chunks;
+        body(chunk_begin, chunk_end);
+    });
+}
+
+// combine(... combine(combine(identity, map(first chunk)), map(second chunk)) ..., map(last chunk)).
+// The chunks depend only on the range and grain, never on the number of threads, so a
+// floating-point reduction gives the same result on every machine and executor.
+template <typename R, typename Map, typename Combine>
+R parallel_reduce(int begin, int end, int grain, R identity, Map map, Combine combine)
+{
+    grain = std::max(grain, 1);
+    int length = end - begin;
+    if(length <= 0)
+    {
+        return identity;
+    }
+    if(length <= grain)
+    {
+        return combine(identity, map(begin, end));
+    }
+    int num_chunks = (length + grain - 1)/grain;
+    std::vector<R> partials(num_chunks, identity);
+    parallel_for(0, num_chunks, 1, [&](int first, int last)
+    {
+        for(int chunk = first; chunk < last; ++chunk)
+        {
+            int chunk_begin = begin + chunk*grain;
+            partials[chunk] = map(chunk_begin, std::min(end, chunk_begin + grain));
+        }
+    });
+    R result = identity;
+    for(const R& partial : partials)
+    {
+        result = combine(result, partial);
+    }
+    return result;
+}
+
+// Runs first and second, possibly at the same time, and returns when both have finished
+template <typename First, typename Second>
+void parallel_invoke(First&& first, Second&& second)
+{
+    Executor& executor = current_executor();
+    if(executor.concurrency() == 1)
+    {
+        first();
+        second();
+        return;
+    }
+    executor.run(2, [&](int index)
+    {
+        if(index == 0)
+        {
+            first();
+        }
+        else
+        {
+            second();
+        }
+    });
+}
+
+// Calls function(leaves..., begin, end) over index ranges of the innermost vectors of arrays
+// that share a shape. A vector is split into ranges, and many short vectors are handed out a
+// block of rows at a time, so function must be safe to call on disjoint ranges at once.
+template <typename Function, typename First, typename ... Others>
+void parallel_for_each_leaf(Function&& function, First&& first, Others&& ... others)
+{
+    ((others.length() != first.length() ? throw MismatchedLength(first.length(), others.length()) : void()), ...);
+    if constexpr(array_rank<std::remove_cvref_t<First>>::value == 1)
+    {
+        parallel_for(0, first.length(), parallel_grain, [&](int begin, int end)
+        {
+            function(first, others..., begin, end);
+        });
+    }
+    else
+    {
+        if(first.length() == 0)
+        {
+            return;
+        }
+        parallel_for(0, first.length(), grain_size(size(first(0))), [&](int begin, int end)
+        {
+            for(int index = begin; index < end; ++index)
+            {
+                parallel_for_each_leaf(function, first(index), others(index)...);
+            }
+        });
+    }
+}
+
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "base.hpp"
+#include "dynamic.hpp"
+#include "products.hpp"
+
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace math
+{
+
+// Hands items from one thread to another; pop() returns nothing once the queue is closed
+// and empty
+template <typename Item>
+class HandoffQueue
+{
+    private:
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        std::deque<Item> items_;
+        bool closed_ = false;
+
+    public:
+        void push(Item item)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                items_.push_back(std::move(item));
+            }
+            changed_.notify_one();
+        }
+
+        std::optional<Item> pop()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [this]{ return closed_ || !items_.empty(); });
+            if(items_.empty())
+            {
+                return std::nullopt;
+            }
+            Item item = std::move(items_.front());
+            items_.pop_front();
+            return item;
+        }
+
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                closed_ = true;
+            }
+            changed_.notify_all();
+        }
+};
+
+// Sink writing each output vector to a file descriptor as raw T values
+template <typename T>
+struct DescriptorSink
+{
+    int descriptor;
+
+    void operator()(const DynamicMatrix<T>& outputs, int count) const
+    {
+        for(int row = 0; row < count; ++row)
+        {
+            const auto* bytes = reinterpret_cast<const char*>(outputs(row).data());
+            std::size_t remaining = outputs(row).length()*sizeof(T);
+            while(remaining > 0)
+            {
+                ssize_t done = ::write(descriptor, bytes, remaining);
+                if(done < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if(done <= 0)
+                {
+                    throw FileError(done < 0 ? errno : EIO);
+                }
+                bytes += done;
+                remaining -= done;
+            }
+        }
+    }
+};
+
+// Waits until descriptor has data or has ended, and throws FileError(ECANCELED) instead if
+// cancel_descriptor becomes readable first. Regular files always poll as readable.
+inline void wait_readable(int descriptor, int cancel_descriptor)
+{
+    pollfd descriptors[2] = {{descriptor, POLLIN, 0}, {cancel_descriptor, POLLIN, 0}};
+    while(::poll(descriptors, 2, -1) < 0)
+    {
+        if(errno != EINTR)
+        {
+            throw FileError(errno);
+        }
+    }
+    if(descriptors[1].revents != 0)
+    {
+        throw FileError(ECANCELED);
+    }
+}
+
+// Fills the first rows of batch from a stream of raw T vectors; returns how many were read,
+// fewer than the batch only at the end of the stream. When cancel_descriptor is given, a
+// read from a pipe or socket that is still waiting for data gives up with
+// FileError(ECANCELED) as soon as cancel_descriptor becomes readable.
+template <typename T>
+int read_rows(int descriptor, DynamicMatrix<T>& batch, int cancel_descriptor = -1)
+{
+    int width = batch(0).length();
+    std::size_t row_bytes = width*sizeof(T);
+    for(int row = 0; row < batch.length(); ++row)
+    {
+        auto* bytes = reinterpret_cast<char*>(batch(row).data());
+        std::size_t received = 0;
+        while(received < row_bytes)
+        {
+            if(cancel_descriptor >= 0)
+            {
+                wait_readable(descriptor, cancel_descriptor);
+            }
+            ssize_t done = ::read(descriptor, bytes + received, row_bytes - received);
+            if(done < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(done < 0)
+            {
+                throw FileError(errno);
+            }
+            if(done == 0)
+            {
+                if(received != 0)
+                {
+                    // The stream ended inside a vector
+                    throw FileError(EIO);
+                }
+                return row;
+            }
+            received += done;
+        }
+    }
+    return batch.length();
+}
+
+// Computes y = W x for every vector x in a stream of raw T vectors of W's width read from
+// input_descriptor, and passes the results to sink(outputs, count) in stream order, count
+// rows of outputs at a time. A reader thread fills one of two input batches while the
+// calling thread multiplies the other as a single gemm, and a writer thread drains one of
+// two output batches into the sink, so reading, computing and writing overlap. Returns the
+// number of vectors processed. The first error on any of the three threads stops the
+// pipeline and is rethrown here; the input may be a pipe or socket, whose reader is woken
+// through a self-pipe rather than left waiting for the producer.
+template <typename T, typename Sink>
+long long apply_to_stream(const DynamicMatrix<T>& W, int input_descriptor, Sink&& sink, int batch_rows = 256)
+{
+    int m = W.length();
+    int n = m == 0 ? 0 : W(0).length();
+    if(batch_rows < 1)
+    {
+        throw OutOfRange(batch_rows, 1);
+    }
+    posix_fadvise(input_descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    DynamicMatrix<T> inputs[2] = {DynamicMatrix<T>(zero_initialize, batch_rows, n), DynamicMatrix<T>(zero_initialize, batch_rows, n)};
+    DynamicMatrix<T> outputs[2] = {DynamicMatrix<T>(batch_rows, m), DynamicMatrix<T>(batch_rows, m)};
+    HandoffQueue<int> free_inputs;
+    HandoffQueue<std::pair<int, int>> full_inputs;
+    HandoffQueue<int> free_outputs;
+    HandoffQueue<std::pair<int, int>> full_outputs;
+    for(int index = 0; index < 2; ++index)
+    {
+        free_inputs.push(index);
+        free_outputs.push(index);
+    }
+
+    // Written once stop() is called, so a reader waiting on the input wakes up
+    int cancel[2];
+    if(::pipe(cancel) != 0)
+    {
+        throw FileError(errno);
+    }
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto stop = [&]
+    {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if(!error)
+            {
+                error = std::current_exception();
+            }
+        }
+        free_inputs.close();
+        full_inputs.close();
+        free_outputs.close();
+        full_outputs.close();
+        char byte = 0;
+        while(::write(cancel[1], &byte, 1) < 0 && errno == EINTR)
+        {
+        }
+    };
+
+    std::thread reader([&]
+    {
+        try
+        {
+            while(auto index = free_inputs.pop())
+            {
+                int count = n == 0 ? 0 : read_rows(input_descriptor, inputs[*index], cancel[0]);
+                if(count == 0)
+                {
+                    break;
+                }
+                full_inputs.push({*index, count});
+                if(count < batch_rows)
+                {
+                    break;
+                }
+            }
+            full_inputs.close();
+        }
+        catch(...)
+        {
+            stop();
+        }
+    });
+    std::thread writer([&]
+    {
+        try
+        {
+            while(auto batch = full_outputs.pop())
+            {
+                sink(static_cast<const DynamicMatrix<T>&>(outputs[batch->first]), batch->second);
+                free_outputs.push(batch->first);
+            }
+        }
+        catch(...)
+        {
+            stop();
+        }
+    });
+
+    long long num_vectors = 0;
+    try
+    {
+        while(auto batch = full_inputs.pop())
+        {
+            auto output = free_outputs.pop();
+            if(!output)
+            {
+                break;
+            }
+            gemm(static_cast<T>(1), inputs[batch->first], Transpose::No, W, Transpose::Yes, static_cast<T>(0), outputs[*output]);
+            free_inputs.push(batch->first);
+            full_outputs.push({*output, batch->second});
+            num_vectors += batch->second;
+        }
+        full_outputs.close();
+    }
+    catch(...)
+    {
+        stop();
+    }
+    reader.join();
+    writer.join();
+    ::close(cancel[0]);
+    ::close(cancel[1]);
+    if(error)
+    {
+        std::rethrow_exception(error);
+    }
+    return num_vectors;
+}
+
+}
@@ -3,6 +3,12 @@
 #include "static.hpp"
 #include "dynamic.hpp"
 #include "operators.hpp"
+#include "complex.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
 
 namespace math
 {
@@ -142,15 +148,634 @@ StaticVector<T, M> operator*(const StaticArray<T, M, N>& A, const StaticVector<T
     return answer;
 }
 
+enum class Transpose
+{
+    No,
+    Yes,
+    // Transposes and conjugates a complex operand; the same as Yes for real ones
+    ConjugateTranspose
+};
+
+template <typename T>
+void axpy(int length, T alpha, const T* x, T* y)
+{
+    for(int index = 0; index < length; ++index)
+    {
+        y[index] += alpha*x[index];
+    }
+}
+
+template <typename T>
+accumulator_type<T> dot(int length, const T* x, const T* y)
+{
+    using R = accumulator_type<T>;
+    constexpr int lanes = 4;
+    R partial[lanes];
+    for(int lane = 0; lane < lanes; ++lane)
+    {
+        partial[lane] = static_cast<R>(0);
+    }
+    int index = 0;
+    for(; index + lanes <= length; index += lanes)
+    {
+        for(int lane = 0; lane < lanes; ++lane)
+        {
+            partial[lane] += static_cast<R>(x[index+lane])*static_cast<R>(y[index+lane]);
+        }
+    }
+    R dot_product = (partial[0]+partial[1])+(partial[2]+partial[3]);
+    for(; index < length; ++index)
+    {
+        dot_product += static_cast<R>(x[index])*static_cast<R>(y[index]);
+    }
+    return dot_product;
+}
+
+// sum of conj(x[i])*y[i], which complex.hpp overloads for complex vectors
+template <typename T>
+accumulator_type<T> dotc(int length, const T* x, const T* y)
+{
+    return dot(length, x, y);
+}
+
+// y += alpha*conj(x), which complex.hpp overloads for complex vectors
+template <typename T>
+void axpyc(int length, T alpha, const T* x, T* y)
+{
+    axpy(length, alpha, x, y);
+}
+
+template <typename T>
+int rows(const DynamicMatrix<T>& matrix, Transpose transpose)
+{
+    if(transpose != Transpose::No)
+    {
+        return matrix.length() == 0 ? 0 : matrix(0).length();
+    }
+    return matrix.length();
+}
+
+template <typename T>
+int columns(const DynamicMatrix<T>& matrix, Transpose transpose)
+{
+    return rows(matrix, transpose == Transpose::No ? Transpose::Yes : Transpose::No);
+}
+
+template <typename T>
+void scale(DynamicVector<T>& vector, T beta)
+{
+    T* values = vector.data();
+    if(beta == static_cast<T>(0))
+    {
+        // BLAS semantics: with beta = 0 the previous contents are never read, so NaNs do not survive
+        for(int index = 0; index < vector.length(); ++index)
+        {
+            values[index] = static_cast<T>(0);
+        }
+    }
+    else if(beta != static_cast<T>(1))
+    {
+        for(int index = 0; index < vector.length(); ++index)
+        {
+            values[index] *= beta;
+        }
+    }
+}
+
+constexpr int gemm_block_inner = 256;
+constexpr int gemm_block_columns = 2048;
+
+// C = alpha*op(A)*op(B) + beta*C into the caller's C, where op transposes its operand on request.
+// Transposed operands are read in place; C must not alias A or B.
+template <typename T>
+DynamicMatrix<T>& gemm(T alpha, const DynamicMatrix<T>& A, Transpose transpose_A, const DynamicMatrix<T>& B, Transpose transpose_B, T beta, DynamicMatrix<T>& C)
+{
+    int m = rows(A, transpose_A);
+    int k = columns(A, transpose_A);
+    int n = columns(B, transpose_B);
+    if(rows(B, transpose_B) != k)
+    {
+        throw MismatchedLength(k, rows(B, transpose_B));
+    }
+    if(C.length() != m)
+    {
+        throw MismatchedLength(C.length(), m);
+    }
+    for(int row = 0; row < m; ++row)
+    {
+        if(C(row).length() != n)
+        {
+            throw MismatchedLength(C(row).length(), n);
+        }
+        scale(C(row), beta);
+    }
+    if(alpha == static_cast<T>(0))
+    {
+        return C;
+    }
+    // Each thread owns a block of rows of C, so every element is accumulated in the same order
+    // as on one thread
+    int grain = grain_size(static_cast<long long>(k)*n);
+    if(transpose_B == Transpose::No)
+    {
+        // Rows of C accumulate scaled rows of B; blocking keeps a panel of B in cache across rows of C
+        parallel_for(0, m, grain, [&](int row_begin, int row_end)
+        {
+            for(int inner_start = 0; inner_start < k; inner_start += gemm_block_inner)
+            {
+                int inner_end = std::min(k, inner_start + gemm_block_inner);
+                for(int column_start = 0; column_start < n; column_start += gemm_block_columns)
+                {
+                    int width = std::min(n, column_start + gemm_block_columns) - column_start;
+                    for(int row = row_begin; row < row_end; ++row)
+                    {
+                        T* c = C(row).data() + column_start;
+                        for(int inner = inner_start; inner < inner_end; ++inner)
+                        {
+                            T a = transpose_A == Transpose::No ? A(row,inner) : A(inner,row);
+                            a = transpose_A == Transpose::ConjugateTranspose ? conjugate(a) : a;
+                            axpy(width, alpha*a, B(inner).data() + column_start, c);
+                        }
+                    }
+                }
+            }
+        });
+    }
+    else if(transpose_A == Transpose::No)
+    {
+        // Both operands are traversed along contiguous rows
+        parallel_for(0, m, grain, [&](int row_begin, int row_end)
+        {
+            for(int row = row_begin; row < row_end; ++row)
+            {
+                T* c = C(row).data();
+                const T* a = A(row).data();
+                for(int column = 0; column < n; ++column)
+                {
+                    // sum a*conj(b) = conj(sum conj(a)*b)
+                    T product = transpose_B == Transpose::ConjugateTranspose ? conjugate(dotc(k, a, B(column).data())) : dot(k, a, B(column).data());
+                    c[column] += alpha*product;
+                }
+            }
+        });
+    }
+    else
+    {
+        parallel_for(0, m, grain, [&](int row_begin, int row_end)
+        {
+            for(int row = row_begin; row < row_end; ++row)
+            {
+                T* c = C(row).data();
+                for(int column = 0; column < n; ++column)
+                {
+                    const T* b = B(column).data();
+                    T dot_product = static_cast<T>(0);
+                    for(int inner = 0; inner < k; ++inner)
+                    {
+                        T a = transpose_A == Transpose::ConjugateTranspose ? conjugate(A(inner,row)) : A(inner,row);
+                        T b_value = transpose_B == Transpose::ConjugateTranspose ? conjugate(b[inner]) : b[inner];
+                        dot_product = multiply_add(dot_product, a, b_value);
+                    }
+                    c[column] += alpha*dot_product;
+                }
+            }
+        });
+    }
+    return C;
+}
+
+// Element types narrower than their accumulator
+template <typename T>
+concept Narrow = !std::is_same_v<accumulator_type<T>, T>;
+
+// Narrow operands are widened once, O(mk + kn + mn) conversions against the O(mkn) product,
+// and each element of C is rounded back once
+template <Narrow T>
+DynamicMatrix<T>& gemm(T alpha, const DynamicMatrix<T>& A, Transpose transpose_A, const DynamicMatrix<T>& B, Transpose transpose_B, T beta, DynamicMatrix<T>& C)
+{
+    using R = accumulator_type<T>;
+    DynamicMatrix<R> wide_C = cast<R>(C);
+    gemm(static_cast<R>(alpha), cast<R>(A), transpose_A, cast<R>(B), transpose_B, static_cast<R>(beta), wide_C);
+    for(int row = 0; row < C.length(); ++row)
+    {
+        convert(wide_C(row).data(), C(row).data(), C(row).length());
+    }
+    return C;
+}
+
+template <typename T>
+DynamicMatrix<T>& gemm(T alpha, const DynamicMatrix<T>& A, const DynamicMatrix<T>& B, T beta, DynamicMatrix<T>& C)
+{
+    return gemm(alpha, A, Transpose::No, B, Transpose::No, beta, C);
+}
+
+// y = alpha*op(A)*x + beta*y into the caller's y; y must not alias x
+template <typename T>
+DynamicVector<T>& gemv(T alpha, const DynamicMatrix<T>& A, Transpose transpose_A, const DynamicVector<T>& x, T beta, DynamicVector<T>& y)
+{
+    int m = rows(A, transpose_A);
+    int n = columns(A, transpose_A);
+    if(x.length() != n)
+    {
+        throw MismatchedLength(x.length(), n);
+    }
+    if(y.length() != m)
+    {
+        throw MismatchedLength(y.length(), m);
+    }
+    scale(y, beta);
+    if(alpha == static_cast<T>(0))
+    {
+        return y;
+    }
+    if(transpose_A == Transpose::No)
+    {
+        parallel_for(0, m, grain_size(n), [&](int begin, int end)
+        {
+            for(int row = begin; row < end; ++row)
+            {
+                y(row) += alpha*dot(n, A(row).data(), x.data());
+            }
+        });
+    }
+    else
+    {
+        // Threads take disjoint ranges of y and sweep all of A's rows over them
+        parallel_for(0, m, grain_size(n), [&](int begin, int end)
+        {
+            for(int inner = 0; inner < n; ++inner)
+            {
+                if(transpose_A == Transpose::ConjugateTranspose)
+                {
+                    axpyc(end - begin, alpha*x(inner), A(inner).data() + begin, y.data() + begin);
+                }
+                else
+                {
+                    axpy(end - begin, alpha*x(inner), A(inner).data() + begin, y.data() + begin);
+                }
+            }
+        });
+    }
+    return y;
+}
+
+// Bandwidth bound: A is read once in its narrow form, a row or row slice at a time widened
+// into a buffer that stays in L1, and y accumulates in the wide type
+template <Narrow T>
+DynamicVector<T>& gemv(T alpha, const DynamicMatrix<T>& A, Transpose transpose_A, const DynamicVector<T>& x, T beta, DynamicVector<T>& y)
+{
+    using R = accumulator_type<T>;
+    int m = rows(A, transpose_A);
+    int n = columns(A, transpose_A);
+    if(x.length() != n)
+    {
+        throw MismatchedLength(x.length(), n);
+    }
+    if(y.length() != m)
+    {
+        throw MismatchedLength(y.length(), m);
+    }
+    scale(y, beta);
+    if(alpha == static_cast<T>(0))
+    {
+        return y;
+    }
+    std::vector<R> wide_x(n);
+    convert(x.data(), wide_x.data(), n);
+    R wide_alpha = static_cast<R>(alpha);
+    if(transpose_A == Transpose::No)
+    {
+        parallel_for(0, m, grain_size(n), [&](int begin, int end)
+        {
+            std::vector<R> wide_row(n);
+            for(int row = begin; row < end; ++row)
+            {
+                convert(A(row).data(), wide_row.data(), n);
+                y(row) = static_cast<R>(y(row)) + wide_alpha*dot(n, wide_row.data(), wide_x.data());
+            }
+        });
+    }
+    else
+    {
+        parallel_for(0, m, grain_size(n), [&](int begin, int end)
+        {
+            std::vector<R> wide_row(end - begin);
+            std::vector<R> wide_y(end - begin);
+            convert(y.data() + begin, wide_y.data(), end - begin);
+            for(int inner = 0; inner < n; ++inner)
+            {
+                convert(A(inner).data() + begin, wide_row.data(), end - begin);
+                axpy(end - begin, wide_alpha*wide_x[inner], wide_row.data(), wide_y.data());
+            }
+            convert(wide_y.data(), y.data() + begin, end - begin);
+        });
+    }
+    return y;
+}
+
+template <typename T>
+DynamicVector<T>& gemv(T alpha, const DynamicMatrix<T>& A, const DynamicVector<T>& x, T beta, DynamicVector<T>& y)
+{
+    return gemv(alpha, A, Transpose::No, x, beta, y);
+}
+
 template <typename T>
 DynamicVector<T> operator*(const DynamicMatrix<T>& A, const DynamicVector<T>& x)
 {
     DynamicVector<T> answer(A.length());
-    for(int index = 0; index < answer.length(); ++index)
+    gemv(static_cast<T>(1), A, x, static_cast<T>(0), answer);
+    return answer;
+}
+
+// Strassen-Winograd multiplication, opt-in per thread. Each level replaces the eight half-size
+// products of the classical algorithm with seven and fifteen additions, O(n^2.81) in all. The
+// price is accuracy: the classical product satisfies |C - fl(AB)| <= n u |A| |B| element by
+// element, while Strassen-Winograd only has the normwise bound
+//     ||C - fl(AB)|| <= [(n/n0)^log2(18) (n0^2 + 6 n0) - 6n] u ||A|| ||B|| + O(u^2)
+// for crossover n0 (Higham, Accuracy and Stability of Numerical Algorithms, section 23.2), so
+// entries of C much smaller than ||A|| ||B|| can lose all their digits. operator* therefore
+// only takes this path once the caller raises the crossover above zero.
+
+constexpr int default_strassen_crossover = 256;
+
+inline int& current_strassen_crossover()
+{
+    thread_local int crossover = 0;
+    return crossover;
+}
+
+// Order at or below which products run classically; 0 while Strassen-Winograd is disabled
+inline int strassen_crossover()
+{
+    return current_strassen_crossover();
+}
+
+// Lets operator* on this thread recurse with Strassen-Winograd while every dimension exceeds
+// crossover; 0 disables it again
+inline int set_strassen_crossover(int crossover)
+{
+    int previous = current_strassen_crossover();
+    current_strassen_crossover() = std::max(crossover, 0);
+    return previous;
+}
+
+// Opts this thread into Strassen-Winograd until the end of the scope
+class ScopedStrassen
+{
+    private:
+        int previous_;
+
+    public:
+        explicit ScopedStrassen(int crossover = default_strassen_crossover)
+        : previous_(set_strassen_crossover(crossover)) {}
+
+        ScopedStrassen(const ScopedStrassen&) = delete;
+        ScopedStrassen& operator=(const ScopedStrassen&) = delete;
+
+        ~ScopedStrassen()
+        {
+            set_strassen_crossover(previous_);
+        }
+};
+
+// Rows of a matrix or of a block of one, a constant stride apart
+template <typename T>
+struct MatrixView
+{
+    T* data;
+    std::ptrdiff_t stride;
+
+    T* row(int index) const
     {
-        answer(index) = dot(A(index), x);
+        return data + index*stride;
     }
-    return answer;
+
+    MatrixView block(int row_offset, int column_offset) const
+    {
+        return {row(row_offset) + column_offset, stride};
+    }
+
+    operator MatrixView<const T>() const
+    {
+        return {data, stride};
+    }
+};
+
+// Views the rows of matrix in place when they are evenly spaced, as allocated matrices are,
+// and a copy in storage otherwise
+template <typename T, typename Element>
+MatrixView<Element> view_rows(const DynamicMatrix<T>& matrix, int columns, std::vector<T>& storage)
+{
+    int rows = matrix.length();
+    std::ptrdiff_t stride = rows > 1 ? matrix(1).data() - matrix(0).data() : columns;
+    bool even = stride >= columns;
+    for(int row = 0; even && row < rows; ++row)
+    {
+        even = matrix(row).data() == matrix(0).data() + row*stride;
+    }
+    if(even)
+    {
+        return {const_cast<Element*>(matrix(0).data()), stride};
+    }
+    storage.resize(static_cast<std::size_t>(rows)*columns);
+    for(int row = 0; row < rows; ++row)
+    {
+        std::copy(matrix(row).data(), matrix(row).data() + columns, storage.data() + static_cast<std::size_t>(row)*columns);
+    }
+    return {storage.data(), columns};
+}
+
+// C = A op B element by element over a rows by columns block
+template <typename T, typename Operation>
+void combine_blocks(int rows, int columns, MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C, Operation operation)
+{
+    parallel_for(0, rows, grain_size(columns), [&](int begin, int end)
+    {
+        for(int row = begin; row < end; ++row)
+        {
+            const T* a = A.row(row);
+            const T* b = B.row(row);
+            T* c = C.row(row);
+            for(int column = 0; column < columns; ++column)
+            {
+                c[column] = operation(a[column], b[column]);
+            }
+        }
+    });
+}
+
+// C = A*B with the blocked row kernel of gemm
+template <typename T>
+void classical_multiply(int m, int k, int n, MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C)
+{
+    parallel_for(0, m, grain_size(static_cast<long long>(k)*n), [&](int row_begin, int row_end)
+    {
+        for(int row = row_begin; row < row_end; ++row)
+        {
+            std::fill(C.row(row), C.row(row) + n, static_cast<T>(0));
+        }
+        for(int inner_start = 0; inner_start < k; inner_start += gemm_block_inner)
+        {
+            int inner_end = std::min(k, inner_start + gemm_block_inner);
+            for(int column_start = 0; column_start < n; column_start += gemm_block_columns)
+            {
+                int width = std::min(n, column_start + gemm_block_columns) - column_start;
+                for(int row = row_begin; row < row_end; ++row)
+                {
+                    T* c = C.row(row) + column_start;
+                    for(int inner = inner_start; inner < inner_end; ++inner)
+                    {
+                        axpy(width, A.row(row)[inner], B.row(inner) + column_start, c);
+                    }
+                }
+            }
+        }
+    });
+}
+
+// C = A*B for an m by k A and a k by n B, recursing on the even leading part of each operand
+// and peeling an odd last row, column or inner index off with classical updates. Follows the
+// schedule of Douglas et al. (1994) that overwrites C: besides C, each level needs one
+// temporary of (m/2)*max(k/2, n/2) and one of (k/2)*(n/2) elements, about a third of the size
+// of the operands over all levels. Threads split every addition and every classical product.
+template <typename T>
+void strassen_winograd(int m, int k, int n, MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C, int crossover)
+{
+    if(std::min({m, k, n}) <= crossover)
+    {
+        classical_multiply<T>(m, k, n, A, B, C);
+        return;
+    }
+    int m2 = m/2;
+    int k2 = k/2;
+    int n2 = n/2;
+    auto plus = [](T left, T right)
+    {
+        return left + right;
+    };
+    auto minus = [](T left, T right)
+    {
+        return left - right;
+    };
+    MatrixView<const T> A11 = A;
+    MatrixView<const T> A12 = A.block(0, k2);
+    MatrixView<const T> A21 = A.block(m2, 0);
+    MatrixView<const T> A22 = A.block(m2, k2);
+    MatrixView<const T> B11 = B;
+    MatrixView<const T> B12 = B.block(0, n2);
+    MatrixView<const T> B21 = B.block(k2, 0);
+    MatrixView<const T> B22 = B.block(k2, n2);
+    MatrixView<T> C11 = C;
+    MatrixView<T> C12 = C.block(0, n2);
+    MatrixView<T> C21 = C.block(m2, 0);
+    MatrixView<T> C22 = C.block(m2, n2);
+    std::vector<T> x_storage(static_cast<std::size_t>(m2)*std::max(k2, n2));
+    std::vector<T> y_storage(static_cast<std::size_t>(k2)*n2);
+    MatrixView<T> X{x_storage.data(), std::max(k2, n2)};
+    MatrixView<T> Y{y_storage.data(), n2};
+
+    combine_blocks<T>(m2, k2, A11, A21, X, minus);
+    combine_blocks<T>(k2, n2, B22, B12, Y, minus);
+    strassen_winograd<T>(m2, k2, n2, X, Y, C21, crossover);
+    combine_blocks<T>(m2, k2, A21, A22, X, plus);
+    combine_blocks<T>(k2, n2, B12, B11, Y, minus);
+    strassen_winograd<T>(m2, k2, n2, X, Y, C22, crossover);
+    combine_blocks<T>(m2, k2, X, A11, X, minus);
+    combine_blocks<T>(k2, n2, B22, Y, Y, minus);
+    strassen_winograd<T>(m2, k2, n2, X, Y, C12, crossover);
+    combine_blocks<T>(m2, k2, A12, X, X, minus);
+    strassen_winograd<T>(m2, k2, n2, X, B22, C11, crossover);
+    strassen_winograd<T>(m2, k2, n2, A11, B11, X, crossover);
+    combine_blocks<T>(m2, n2, X, C12, C12, plus);
+    combine_blocks<T>(m2, n2, C12, C21, C21, plus);
+    combine_blocks<T>(m2, n2, C12, C22, C12, plus);
+    combine_blocks<T>(m2, n2, C21, C22, C22, plus);
+    combine_blocks<T>(m2, n2, C12, C11, C12, plus);
+    combine_blocks<T>(k2, n2, Y, B21, Y, minus);
+    strassen_winograd<T>(m2, k2, n2, A22, Y, C11, crossover);
+    combine_blocks<T>(m2, n2, C21, C11, C21, minus);
+    strassen_winograd<T>(m2, k2, n2, A12, B21, C11, crossover);
+    combine_blocks<T>(m2, n2, X, C11, C11, plus);
+
+    int even_m = 2*m2;
+    int even_n = 2*n2;
+    if(k % 2 != 0)
+    {
+        parallel_for(0, even_m, grain_size(even_n), [&](int begin, int end)
+        {
+            for(int row = begin; row < end; ++row)
+            {
+                axpy(even_n, A.row(row)[k-1], B.row(k-1), C.row(row));
+            }
+        });
+    }
+    if(n % 2 != 0)
+    {
+        parallel_for(0, m, grain_size(k), [&](int begin, int end)
+        {
+            for(int row = begin; row < end; ++row)
+            {
+                T sum = static_cast<T>(0);
+                for(int inner = 0; inner < k; ++inner)
+                {
+                    sum = multiply_add(sum, A.row(row)[inner], B.row(inner)[n-1]);
+                }
+                C.row(row)[n-1] = sum;
+            }
+        });
+    }
+    if(m % 2 != 0)
+    {
+        T* c = C.row(m-1);
+        std::fill(c, c + even_n, static_cast<T>(0));
+        for(int inner = 0; inner < k; ++inner)
+        {
+            axpy(even_n, A.row(m-1)[inner], B.row(inner), c);
+        }
+    }
+}
+
+// C = A*B by Strassen-Winograd down to crossover, overwriting the caller's C
+template <typename T>
+DynamicMatrix<T>& strassen_multiply(const DynamicMatrix<T>& A, const DynamicMatrix<T>& B, DynamicMatrix<T>& C, int crossover = default_strassen_crossover)
+{
+    int m = A.length();
+    int k = B.length();
+    int n = k == 0 ? 0 : B(0).length();
+    if(m > 0 && A(0).length() != k)
+    {
+        throw MismatchedLength(A(0).length(), k);
+    }
+    if(C.length() != m)
+    {
+        throw MismatchedLength(C.length(), m);
+    }
+    for(int row = 0; row < m; ++row)
+    {
+        if(C(row).length() != n)
+        {
+            throw MismatchedLength(C(row).length(), n);
+        }
+    }
+    if(m == 0 || n == 0)
+    {
+        return C;
+    }
+    std::vector<T> a_storage;
+    std::vector<T> b_storage;
+    std::vector<T> c_storage;
+    MatrixView<const T> a = view_rows<T, const T>(A, k, a_storage);
+    MatrixView<const T> b = view_rows<T, const T>(B, n, b_storage);
+    MatrixView<T> c = view_rows<T, T>(C, n, c_storage);
+    strassen_winograd<T>(m, k, n, a, b, c, std::max(crossover, 1));
+    if(c.data == c_storage.data())
+    {
+        for(int row = 0; row < m; ++row)
+        {
+            std::copy(c.row(row), c.row(row) + n, C(row).data());
+        }
+    }
+    return C;
 }
 
 template <typename T>
@@ -164,17 +789,16 @@ DynamicMatrix<T> operator*(const DynamicMatrix<T>& left, const DynamicMatrix<T>&
     }
     int p = right(0).length();
     DynamicMatrix<T> result(m,p);
-    for(int row = 0; row < m; ++row)
+    if constexpr(!Narrow<T>)
     {
-        for(int column = 0; column < p; ++column)
+        int crossover = strassen_crossover();
+        if(crossover > 0 && std::min({m, n, p}) > crossover)
         {
-            result(row,column) = static_cast<T>(0);
-            for(int index = 0; index < n; ++index)
-            {
-                result(row,column) += left(row,index)*right(index,column);
-            }
+            strassen_multiply(left, right, result, crossover);
+            return result;
         }
     }
+    gemm(static_cast<T>(1), left, right, static_cast<T>(0), result);
     return result;
 }
 
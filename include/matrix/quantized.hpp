@@ -0,0 +1,334 @@
+#pragma once
+
+#include "base.hpp"
+#include "dynamic.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__AVX512VNNI__)
+#include <immintrin.h>
+#endif
+
+namespace math
+{
+
+template <typename Q>
+concept Quantized = std::is_same_v<Q, std::int8_t> || std::is_same_v<Q, std::uint8_t>;
+
+#if defined(__AVX2__)
+template <Quantized Q>
+__m256i widen_16(const Q* values)
+{
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+    if constexpr(std::is_signed_v<Q>)
+    {
+        return _mm256_cvtepi8_epi16(bytes);
+    }
+    else
+    {
+        return _mm256_cvtepu8_epi16(bytes);
+    }
+}
+
+inline std::int32_t horizontal_sum(__m256i values)
+{
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+// Exact dot product of 8-bit vectors in 32-bit integers. An unsigned by signed product uses
+// VNNI, 64 products per instruction, where the target has it; otherwise AVX2 widens both
+// operands to 16 bits and multiplies pairs into 32-bit sums, which never saturates.
+template <Quantized L, Quantized R>
+std::int32_t integer_dot(int length, const L* x, const R* y)
+{
+    int index = 0;
+    std::int32_t result = 0;
+#if defined(__AVX512VNNI__)
+    if constexpr(std::is_unsigned_v<L> != std::is_unsigned_v<R>)
+    {
+        const auto* unsigned_values = reinterpret_cast<const std::uint8_t*>(std::is_unsigned_v<L> ? static_cast<const void*>(x) : static_cast<const void*>(y));
+        const auto* signed_values = reinterpret_cast<const std::int8_t*>(std::is_unsigned_v<L> ? static_cast<const void*>(y) : static_cast<const void*>(x));
+        __m512i sums = _mm512_setzero_si512();
+        for(; index + 64 <= length; index += 64)
+        {
+            sums = _mm512_dpbusd_epi32(sums, _mm512_loadu_si512(unsigned_values + index), _mm512_loadu_si512(signed_values + index));
+        }
+        result += _mm512_reduce_add_epi32(sums);
+    }
+#endif
+#if defined(__AVX2__)
+    __m256i sums = _mm256_setzero_si256();
+    for(; index + 16 <= length; index += 16)
+    {
+        sums = _mm256_add_epi32(sums, _mm256_madd_epi16(widen_16(x + index), widen_16(y + index)));
+    }
+    result += horizontal_sum(sums);
+#endif
+    for(; index < length; ++index)
+    {
+        result += static_cast<std::int32_t>(x[index])*static_cast<std::int32_t>(y[index]);
+    }
+    return result;
+}
+
+// Rows of B that stay in cache while a block of rows of A sweeps over them
+constexpr int integer_gemm_block_bytes = 1 << 18;
+
+// C = A B^T for 8-bit A (m by k) and B (n by k), accumulated exactly in 32-bit integers. B
+// holds the rows of the right operand's transpose, the usual layout of weights, so both
+// operands are read along contiguous rows.
+template <Quantized L, Quantized R>
+DynamicMatrixi& integer_gemm(const DynamicMatrix<L>& A, const DynamicMatrix<R>& B, DynamicMatrixi& C)
+{
+    int m = A.length();
+    int n = B.length();
+    int k = m == 0 ? 0 : A(0).length();
+    if(n > 0 && B(0).length() != k)
+    {
+        throw MismatchedLength(k, B(0).length());
+    }
+    ensure_shape(C, m, n);
+    int block = std::max(1, integer_gemm_block_bytes/std::max(1, k));
+    parallel_for(0, m, grain_size(static_cast<long long>(k)*n), [&](int row_begin, int row_end)
+    {
+        for(int column_start = 0; column_start < n; column_start += block)
+        {
+            int column_end = std::min(n, column_start + block);
+            for(int row = row_begin; row < row_end; ++row)
+            {
+                const L* a = A(row).data();
+                std::int32_t* c = C(row).data();
+                for(int column = column_start; column < column_end; ++column)
+                {
+                    c[column] = integer_dot(k, a, B(column).data());
+                }
+            }
+        }
+    });
+    return C;
+}
+
+// y = A x for 8-bit A and x, accumulated exactly in 32-bit integers
+template <Quantized L, Quantized R>
+DynamicVectori& integer_gemv(const DynamicMatrix<L>& A, const DynamicVector<R>& x, DynamicVectori& y)
+{
+    int m = A.length();
+    int n = x.length();
+    if(m > 0 && A(0).length() != n)
+    {
+        throw MismatchedLength(A(0).length(), n);
+    }
+    ensure_shape(y, m);
+    parallel_for(0, m, grain_size(n), [&](int begin, int end)
+    {
+        for(int row = begin; row < end; ++row)
+        {
+            y(row) = integer_dot(n, A(row).data(), x.data());
+        }
+    });
+    return y;
+}
+
+enum class Granularity
+{
+    // One scale and zero point for the whole matrix
+    PerTensor,
+    // One scale and zero point for each row
+    PerRow
+};
+
+// 8-bit approximation of a float matrix: row r holds round(value/scale(r)) + zero_point(r).
+// int8 values are symmetric, zero point 0 and range [-127, 127], the operand VNNI expects for
+// weights; uint8 values are affine over [0, 255] with the zero point placed so that 0 is exact.
+template <Quantized Q>
+struct QuantizedMatrix
+{
+    DynamicMatrix<Q> values;
+    DynamicVectorf scales;
+    DynamicVectori zero_points;
+    // Sums of the stored values of each row, which fold the zero points out of products
+    DynamicVectori row_sums;
+
+    float scale(int row) const
+    {
+        return scales.length() == 1 ? scales(0) : scales(row);
+    }
+
+    int zero_point(int row) const
+    {
+        return zero_points.length() == 1 ? zero_points(0) : zero_points(row);
+    }
+};
+
+template <Quantized Q>
+void quantization_parameters(float low, float high, float& scale, int& zero_point)
+{
+    low = std::min(low, 0.0f);
+    high = std::max(high, 0.0f);
+    if constexpr(std::is_signed_v<Q>)
+    {
+        scale = std::max(-low, high)/127;
+        zero_point = 0;
+    }
+    else
+    {
+        scale = (high - low)/255;
+        zero_point = scale > 0 ? static_cast<int>(std::clamp(std::nearbyint(-low/scale), 0.0f, 255.0f)) : 0;
+    }
+    if(!(scale > 0))
+    {
+        scale = 1;
+    }
+}
+
+template <Quantized Q>
+void quantize_values(const float* values, int length, float scale, int zero_point, Q* target)
+{
+    constexpr float lowest = std::is_signed_v<Q> ? -127.0f : 0.0f;
+    constexpr float highest = std::is_signed_v<Q> ? 127.0f : 255.0f;
+    float inverse = 1/scale;
+    for(int index = 0; index < length; ++index)
+    {
+        target[index] = static_cast<Q>(std::clamp(std::nearbyint(values[index]*inverse) + zero_point, lowest, highest));
+    }
+}
+
+template <Quantized Q>
+QuantizedMatrix<Q> quantize(const DynamicMatrixf& matrix, Granularity granularity = Granularity::PerRow)
+{
+    int m = matrix.length();
+    int n = m == 0 ? 0 : matrix(0).length();
+    int num_parameters = granularity == Granularity::PerRow ? m : 1;
+    QuantizedMatrix<Q> quantized;
+    ensure_shape(quantized.values, m, n);
+    ensure_shape(quantized.scales, num_parameters);
+    ensure_shape(quantized.zero_points, num_parameters);
+    ensure_shape(quantized.row_sums, m);
+    auto range = [&](int row)
+    {
+        const float* values = matrix(row).data();
+        auto [low, high] = std::minmax_element(values, values + n);
+        return n == 0 ? std::pair<float, float>{0.0f, 0.0f} : std::pair<float, float>{*low, *high};
+    };
+    if(granularity == Granularity::PerTensor)
+    {
+        float low = 0;
+        float high = 0;
+        for(int row = 0; row < m; ++row)
+        {
+            auto [row_low, row_high] = range(row);
+            low = std::min(low, row_low);
+            high = std::max(high, row_high);
+        }
+        quantization_parameters<Q>(low, high, quantized.scales(0), quantized.zero_points(0));
+    }
+    parallel_for(0, m, grain_size(n), [&](int begin, int end)
+    {
+        for(int row = begin; row < end; ++row)
+        {
+            if(granularity == Granularity::PerRow)
+            {
+                auto [low, high] = range(row);
+                quantization_parameters<Q>(low, high, quantized.scales(row), quantized.zero_points(row));
+            }
+            Q* values = quantized.values(row).data();
+            quantize_values(matrix(row).data(), n, quantized.scale(row), quantized.zero_point(row), values);
+            std::int32_t sum = 0;
+            for(int column = 0; column < n; ++column)
+            {
+                sum += values[column];
+            }
+            quantized.row_sums(row) = sum;
+        }
+    });
+    return quantized;
+}
+
+template <Quantized Q>
+DynamicMatrixf dequantize(const QuantizedMatrix<Q>& quantized)
+{
+    int m = quantized.values.length();
+    int n = m == 0 ? 0 : quantized.values(0).length();
+    DynamicMatrixf matrix(m, n);
+    for(int row = 0; row < m; ++row)
+    {
+        float scale = quantized.scale(row);
+        int zero_point = quantized.zero_point(row);
+        const Q* values = quantized.values(row).data();
+        for(int column = 0; column < n; ++column)
+        {
+            matrix(row, column) = scale*(static_cast<int>(values[column]) - zero_point);
+        }
+    }
+    return matrix;
+}
+
+// A W^T from the integer product of the stored values, with the zero points folded out
+// through the row sums and one scale per output:
+// sum (a - za)(w - zw) = sum aw - zw sum a - za sum w + k za zw
+template <Quantized L, Quantized R>
+DynamicMatrixf quantized_gemm(const QuantizedMatrix<L>& A, const QuantizedMatrix<R>& W)
+{
+    DynamicMatrixi products;
+    integer_gemm(A.values, W.values, products);
+    int m = products.length();
+    int n = W.values.length();
+    int k = m == 0 ? 0 : A.values(0).length();
+    DynamicMatrixf result(m, n);
+    for(int row = 0; row < m; ++row)
+    {
+        int a_zero = A.zero_point(row);
+        for(int column = 0; column < n; ++column)
+        {
+            int w_zero = W.zero_point(column);
+            std::int64_t exact = static_cast<std::int64_t>(products(row, column)) - static_cast<std::int64_t>(w_zero)*A.row_sums(row)
+                - static_cast<std::int64_t>(a_zero)*W.row_sums(column) + static_cast<std::int64_t>(k)*a_zero*w_zero;
+            result(row, column) = A.scale(row)*W.scale(column)*static_cast<float>(exact);
+        }
+    }
+    return result;
+}
+
+// W x for quantized weights: x is quantized to uint8 on the fly, so int8 weights meet it in
+// the unsigned by signed form of VNNI
+template <Quantized R>
+DynamicVectorf quantized_gemv(const QuantizedMatrix<R>& W, const DynamicVectorf& x)
+{
+    int n = x.length();
+    auto [low, high] = n == 0 ? std::pair<const float*, const float*>{nullptr, nullptr} : std::minmax_element(x.data(), x.data() + n);
+    float x_scale;
+    int x_zero;
+    quantization_parameters<std::uint8_t>(n == 0 ? 0.0f : *low, n == 0 ? 0.0f : *high, x_scale, x_zero);
+    DynamicVector<std::uint8_t> quantized_x(n);
+    quantize_values(x.data(), n, x_scale, x_zero, quantized_x.data());
+    std::int32_t x_sum = 0;
+    for(int index = 0; index < n; ++index)
+    {
+        x_sum += quantized_x(index);
+    }
+
+    DynamicVectori products;
+    integer_gemv(W.values, quantized_x, products);
+    int m = products.length();
+    DynamicVectorf result(m);
+    for(int row = 0; row < m; ++row)
+    {
+        int w_zero = W.zero_point(row);
+        std::int64_t exact = static_cast<std::int64_t>(products(row)) - static_cast<std::int64_t>(x_zero)*W.row_sums(row)
+            - static_cast<std::int64_t>(w_zero)*x_sum + static_cast<std::int64_t>(n)*x_zero*w_zero;
+        result(row) = W.scale(row)*x_scale*static_cast<float>(exact);
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,475 @@
+#pragma once
+
+#include "base.hpp"
+#include "static.hpp"
+#include "dynamic.hpp"
+
+#include <cmath>
+
+namespace math
+{
+
+constexpr int pairwise_block_length = 128;
+constexpr int pairwise_lanes = 8;
+
+struct Unchanged
+{
+    template <typename T>
+    T operator()(T value) const
+    {
+        return value;
+    }
+};
+
+struct Absolute
+{
+    template <typename T>
+    auto operator()(T value) const
+    {
+        return std::abs(value);
+    }
+};
+
+struct Less
+{
+    template <typename T>
+    bool operator()(T left, T right) const
+    {
+        return left < right;
+    }
+};
+
+struct Greater
+{
+    template <typename T>
+    bool operator()(T left, T right) const
+    {
+        return left > right;
+    }
+};
+
+// Pairwise summation of transform(values[i]). The rounding error grows with log(length)
+// rather than length, and the independent lanes of each block vectorize.
+template <typename R, typename T, typename Transform>
+R pairwise_sum(const T* values, int length, Transform transform)
+{
+    if(length <= pairwise_block_length)
+    {
+        R lanes[pairwise_lanes];
+        for(int lane = 0; lane < pairwise_lanes; ++lane)
+        {
+            lanes[lane] = static_cast<R>(0);
+        }
+        int index = 0;
+        for(; index + pairwise_lanes <= length; index += pairwise_lanes)
+        {
+            for(int lane = 0; lane < pairwise_lanes; ++lane)
+            {
+                lanes[lane] += static_cast<R>(transform(values[index+lane]));
+            }
+        }
+        R summation = ((lanes[0]+lanes[1])+(lanes[2]+lanes[3]))+((lanes[4]+lanes[5])+(lanes[6]+lanes[7]));
+        for(; index < length; ++index)
+        {
+            summation += static_cast<R>(transform(values[index]));
+        }
+        return summation;
+    }
+    int half = (length/(2*pairwise_lanes))*pairwise_lanes;
+    if(length <= parallel_grain)
+    {
+        return pairwise_sum<R>(values, half, transform) + pairwise_sum<R>(values+half, length-half, transform);
+    }
+    // Large halves are summed concurrently; the tree, and so the result, stays the same
+    R low, high;
+    parallel_invoke([&]{ low = pairwise_sum<R>(values, half, transform); },
+        [&]{ high = pairwise_sum<R>(values+half, length-half, transform); });
+    return low + high;
+}
+
+template <typename R, typename ArrayType, typename Function>
+R pairwise_rows(const ArrayType& array, int low, int high, int row_size, Function reduce_row)
+{
+    if(high - low == 1)
+    {
+        return reduce_row(array(low));
+    }
+    int middle = low + (high-low)/2;
+    if(static_cast<long long>(high - low)*row_size <= parallel_grain)
+    {
+        return pairwise_rows<R>(array, low, middle, row_size, reduce_row) + pairwise_rows<R>(array, middle, high, row_size, reduce_row);
+    }
+    R left, right;
+    parallel_invoke([&]{ left = pairwise_rows<R>(array, low, middle, row_size, reduce_row); },
+        [&]{ right = pairwise_rows<R>(array, middle, high, row_size, reduce_row); });
+    return left + right;
+}
+
+template <typename R, typename T, bool IsStatic, int ... Shape, typename Transform>
+R transformed_sum(const Array<T, IsStatic, Shape...>& array, Transform transform)
+{
+    if constexpr(array_rank<Array<T, IsStatic, Shape...>>::value == 1)
+    {
+        return pairwise_sum<R>(array.data(), array.length(), transform);
+    }
+    else
+    {
+        if(array.length() == 0)
+        {
+            return static_cast<R>(0);
+        }
+        return pairwise_rows<R>(array, 0, array.length(), size(array(0)), [&](const auto& row)
+        {
+            return transformed_sum<R>(row, transform);
+        });
+    }
+}
+
+template <typename T, int NumDims>
+int axis_length(const DynamicArray<T, NumDims>& array, int axis)
+{
+    if constexpr(NumDims > 1)
+    {
+        if(axis > 0)
+        {
+            return array.length() == 0 ? 0 : axis_length(array(0), axis-1);
+        }
+    }
+    return array.length();
+}
+
+template <typename T>
+struct Extremum
+{
+    T value;
+    int index;
+};
+
+// First extremum of transform(element) under better, with its row-major flat index. Chunks of
+// elements or rows are searched concurrently and merged in order, keeping the earlier of equals.
+template <typename R, typename T, bool IsStatic, int ... Shape, typename Better, typename Transform>
+Extremum<R> find_extremum(const Array<T, IsStatic, Shape...>& array, Better better, Transform transform)
+{
+    struct Partial
+    {
+        Extremum<R> extremum;
+        int count;
+    };
+    auto search = [&](Partial& partial, const T* values, int length)
+    {
+        for(int index = 0; index < length; ++index)
+        {
+            R value = static_cast<R>(transform(values[index]));
+            if(partial.extremum.index < 0 || better(value, partial.extremum.value))
+            {
+                partial.extremum.value = value;
+                partial.extremum.index = partial.count + index;
+            }
+        }
+        partial.count += length;
+    };
+    auto merge = [&](Partial left, const Partial& right)
+    {
+        if(right.extremum.index >= 0 && (left.extremum.index < 0 || better(right.extremum.value, left.extremum.value)))
+        {
+            left.extremum.value = right.extremum.value;
+            left.extremum.index = left.count + right.extremum.index;
+        }
+        left.count += right.count;
+        return left;
+    };
+    Partial none{{static_cast<R>(0), -1}, 0};
+    Partial found;
+    if constexpr(array_rank<Array<T, IsStatic, Shape...>>::value == 1)
+    {
+        found = parallel_reduce(0, array.length(), parallel_grain, none, [&](int begin, int end)
+        {
+            Partial partial = none;
+            search(partial, array.data() + begin, end - begin);
+            return partial;
+        }, merge);
+    }
+    else
+    {
+        int grain = array.length() == 0 ? 1 : grain_size(size(array(0)));
+        found = parallel_reduce(0, array.length(), grain, none, [&](int begin, int end)
+        {
+            Partial partial = none;
+            for(int row = begin; row < end; ++row)
+            {
+                for_each_leaf([&](const auto& vector)
+                {
+                    search(partial, vector.data(), vector.length());
+                }, array(row));
+            }
+            return partial;
+        }, merge);
+    }
+    if(found.extremum.index < 0)
+    {
+        throw OutOfRange(0, 0);
+    }
+    return found.extremum;
+}
+
+template <typename T, bool IsStatic, int ... Shape>
+T sum(const Array<T, IsStatic, Shape...>& array)
+{
+    return static_cast<T>(transformed_sum<accumulator_type<T>>(array, Unchanged()));
+}
+
+template <typename T, bool IsStatic, int ... Shape>
+real_type<T> mean(const Array<T, IsStatic, Shape...>& array)
+{
+    return transformed_sum<real_type<T>>(array, Unchanged())/size(array);
+}
+
+template <typename T, bool IsStatic, int ... Shape>
+T min(const Array<T, IsStatic, Shape...>& array)
+{
+    return find_extremum<T>(array, Less(), Unchanged()).value;
+}
+
+template <typename T, bool IsStatic, int ... Shape>
+T max(const Array<T, IsStatic, Shape...>& array)
+{
+    return find_extremum<T>(array, Greater(), Unchanged()).value;
+}
+
+template <typename T, bool IsStatic, int ... Shape>
+int argmin(const Array<T, IsStatic, Shape...>& array)
+{
+    return find_extremum<T>(array, Less(), Unchanged()).index;
+}
+
+template <typename T, bool IsStatic, int ... Shape>
+int argmax(const Array<T, IsStatic, Shape...>& array)
+{
+    return find_extremum<T>(array, Greater(), Unchanged()).index;
+}
+
+// Reduces a dynamic array along axis. Along axis 0 the rows are folded elementwise into an
+// accumulator, so every output element streams through contiguous memory; along the last
+// axis each vector is reduced directly with reduce_vector.
+template <typename R, typename T, int NumDims, typename Init, typename Fold, typename Finish, typename ReduceVector>
+requires(NumDims > 1)
+DynamicArray<R, NumDims-1> reduce_axis(const DynamicArray<T, NumDims>& array, int axis, Init init, Fold fold, Finish finish, ReduceVector reduce_vector)
+{
+    check_axis(axis, NumDims);
+    if(array.length() == 0)
+    {
+        throw OutOfRange(0, 0);
+    }
+    if(axis == 0)
+    {
+        auto accumulator = init(array(0));
+        for(int row = 1; row < array.length(); ++row)
+        {
+            fold(accumulator, array(row), row);
+        }
+        return finish(accumulator);
+    }
+    DynamicArray<R, NumDims-1> reduced;
+    reduced.allocate(array.length());
+    if constexpr(NumDims == 2)
+    {
+        // Rows reduce to scalars independently, so blocks of them go to different threads
+        parallel_for(0, array.length(), grain_size(array(0).length()), [&](int begin, int end)
+        {
+            for(int row = begin; row < end; ++row)
+            {
+                reduced(row) = reduce_vector(array(row));
+            }
+        });
+    }
+    else
+    {
+        for(int row = 0; row < array.length(); ++row)
+        {
+            reduced(row) = reduce_axis<R>(array(row), axis-1, init, fold, finish, reduce_vector);
+        }
+    }
+    return reduced;
+}
+
+template <typename Values, typename Other>
+struct AxisAccumulator
+{
+    Values values;
+    Other other;
+};
+
+// Neumaier compensated sum of transform(element) along axis
+template <typename R, typename T, int NumDims, typename Transform>
+requires(NumDims > 1)
+DynamicArray<R, NumDims-1> sum_axis(const DynamicArray<T, NumDims>& array, int axis, Transform transform)
+{
+    auto init = [&](const auto& row)
+    {
+        AxisAccumulator accumulator{empty_like<T, R>(row), empty_like<T, R>(row)};
+        for_each_leaf([&](auto& total, auto& compensation, const auto& vector)
+        {
+            for(int index = 0; index < vector.length(); ++index)
+            {
+                total.data()[index] = static_cast<R>(transform(vector.data()[index]));
+                compensation.data()[index] = static_cast<R>(0);
+            }
+        }, accumulator.values, accumulator.other, row);
+        return accumulator;
+    };
+    auto fold = [&](auto& accumulator, const auto& row, int)
+    {
+        for_each_leaf([&](auto& total, auto& compensation, const auto& vector)
+        {
+            R* totals = total.data();
+            R* compensations = compensation.data();
+            const T* values = vector.data();
+            for(int index = 0; index < vector.length(); ++index)
+            {
+                R value = static_cast<R>(transform(values[index]));
+                R updated = totals[index] + value;
+                compensations[index] += (std::abs(totals[index]) >= std::abs(value)) ? (totals[index] - updated) + value : (value - updated) + totals[index];
+                totals[index] = updated;
+            }
+        }, accumulator.values, accumulator.other, row);
+    };
+    auto finish = [](auto& accumulator)
+    {
+        for_each_leaf([](auto& total, const auto& compensation)
+        {
+            for(int index = 0; index < total.length(); ++index)
+            {
+                total.data()[index] += compensation.data()[index];
+            }
+        }, accumulator.values, accumulator.other);
+        return accumulator.values;
+    };
+    auto reduce_vector = [&](const auto& vector)
+    {
+        return pairwise_sum<R>(vector.data(), vector.length(), transform);
+    };
+    return reduce_axis<R>(array, axis, init, fold, finish, reduce_vector);
+}
+
+// Extremum of transform(element) along axis; with Index=true yields the position along axis instead
+template <typename R, bool Index, typename T, int NumDims, typename Better, typename Transform>
+requires(NumDims > 1)
+auto extremum_axis(const DynamicArray<T, NumDims>& array, int axis, Better better, Transform transform)
+{
+    using Result = std::conditional_t<Index, int, R>;
+    auto init = [&](const auto& row)
+    {
+        AxisAccumulator accumulator{empty_like<T, R>(row), empty_like<T, int>(row)};
+        for_each_leaf([&](auto& extremum, auto& position, const auto& vector)
+        {
+            for(int index = 0; index < vector.length(); ++index)
+            {
+                extremum.data()[index] = static_cast<R>(transform(vector.data()[index]));
+                position.data()[index] = 0;
+            }
+        }, accumulator.values, accumulator.other, row);
+        return accumulator;
+    };
+    auto fold = [&](auto& accumulator, const auto& row, int row_index)
+    {
+        for_each_leaf([&](auto& extremum, auto& position, const auto& vector)
+        {
+            R* extrema = extremum.data();
+            int* positions = position.data();
+            const T* values = vector.data();
+            for(int index = 0; index < vector.length(); ++index)
+            {
+                R value = static_cast<R>(transform(values[index]));
+                if(better(value, extrema[index]))
+                {
+                    extrema[index] = value;
+                    positions[index] = row_index;
+                }
+            }
+        }, accumulator.values, accumulator.other, row);
+    };
+    auto finish = [](auto& accumulator)
+    {
+        if constexpr(Index)
+        {
+            return accumulator.other;
+        }
+        else
+        {
+            return accumulator.values;
+        }
+    };
+    auto reduce_vector = [&](const auto& vector)
+    {
+        auto extremum = find_extremum<R>(vector, better, transform);
+        if constexpr(Index)
+        {
+            return extremum.index;
+        }
+        else
+        {
+            return extremum.value;
+        }
+    };
+    return reduce_axis<Result>(array, axis, init, fold, finish, reduce_vector);
+}
+
+template <typename T, int NumDims>
+requires(NumDims > 1)
+DynamicArray<T, NumDims-1> sum(const DynamicArray<T, NumDims>& array, int axis)
+{
+    if constexpr(std::is_same_v<accumulator_type<T>, T>)
+    {
+        return sum_axis<T>(array, axis, Unchanged());
+    }
+    else
+    {
+        return cast<T>(sum_axis<accumulator_type<T>>(array, axis, Unchanged()));
+    }
+}
+
+template <typename T, int NumDims>
+requires(NumDims > 1)
+DynamicArray<real_type<T>, NumDims-1> mean(const DynamicArray<T, NumDims>& array, int axis)
+{
+    auto averaged = sum_axis<real_type<T>>(array, axis, Unchanged());
+    int count = axis_length(array, axis);
+    for_each_leaf([&](auto& vector)
+    {
+        for(int index = 0; index < vector.length(); ++index)
+        {
+            vector.data()[index] /= count;
+        }
+    }, averaged);
+    return averaged;
+}
+
+template <typename T, int NumDims>
+requires(NumDims > 1)
+DynamicArray<T, NumDims-1> min(const DynamicArray<T, NumDims>& array, int axis)
+{
+    return extremum_axis<T, false>(array, axis, Less(), Unchanged());
+}
+
+template <typename T, int NumDims>
+requires(NumDims > 1)
+DynamicArray<T, NumDims-1> max(const DynamicArray<T, NumDims>& array, int axis)
+{
+    return extremum_axis<T, false>(array, axis, Greater(), Unchanged());
+}
+
+template <typename T, int NumDims>
+requires(NumDims > 1)
+DynamicArray<int, NumDims-1> argmin(const DynamicArray<T, NumDims>& array, int axis)
+{
+    return extremum_axis<T, true>(array, axis, Less(), Unchanged());
+}
+
+template <typename T, int NumDims>
+requires(NumDims > 1)
+DynamicArray<int, NumDims-1> argmax(const DynamicArray<T, NumDims>& array, int axis)
+{
+    return extremum_axis<T, true>(array, axis, Greater(), Unchanged());
+}
+
+}
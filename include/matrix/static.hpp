@@ -33,6 +33,7 @@ class Array<T, true, Dim>
         }
 
     public:
+        using ValueType = T;
         using InitializerList = std::initializer_list<T>;
 
         Array()
@@ -115,6 +116,16 @@ class Array<T, true, Dim>
         {
             return Dim;
         }
+
+        T* data()
+        {
+            return data_;
+        }
+
+        const T* data() const
+        {
+            return data_;
+        }
 };
 
 template <typename T, int FirstDim, int ... OtherDim>
@@ -145,6 +156,7 @@ class Array<T, true, FirstDim, OtherDim...>
         }
 
     public:
+        using ValueType = T;
         using InitializerList = std::initializer_list<typename SubArray::InitializerList>;
 
         Array() {};
@@ -195,7 +207,7 @@ class Array<T, true, FirstDim, OtherDim...>
             return data_[index];
         }
 
-        SubArray operator()(int index) const
+        const SubArray& operator()(int index) const
         {
             index = transform_index(index);
             check_input(index);
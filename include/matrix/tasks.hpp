@@ -0,0 +1,210 @@
+#pragma once
+
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace math
+{
+
+enum class Access {Read, Write};
+
+// A task's use of one piece of data, usually a tile, named by the caller's integer id
+struct DataAccess
+{
+    int data;
+    Access access;
+};
+
+// Data-flow task graph. Each task names the data it reads and writes. It runs after every
+// earlier task that writes what it reads, or reads or writes what it writes, as in sequential
+// program order. Independent tasks run out of order. Among ready tasks, those with the highest
+// priority start first, which lets a factorization start the next panel early (lookahead).
+class TaskGraph
+{
+    private:
+        struct Task
+        {
+            std::function<void()> work;
+            std::vector<int> successors;
+            int num_predecessors;
+            int priority;
+        };
+
+        struct DataState
+        {
+            int last_writer = -1;
+            std::vector<int> readers;
+        };
+
+        std::vector<Task> tasks_;
+        std::vector<DataState> data_;
+
+        // Number of graph tasks running on this thread. A worker started inside one, which an
+        // executor may do while the task waits for its own parallel loop, must not block: the
+        // task below it could be the one it would wait for.
+        static int& task_depth()
+        {
+            thread_local int depth = 0;
+            return depth;
+        }
+
+        void add_edge(int from, int to)
+        {
+            std::vector<int>& successors = tasks_[from].successors;
+            if(successors.empty() || successors.back() != to)
+            {
+                successors.push_back(to);
+                ++tasks_[to].num_predecessors;
+            }
+        }
+
+    public:
+        int add(std::function<void()> work, std::initializer_list<DataAccess> accesses, int priority = 0)
+        {
+            int id = tasks_.size();
+            tasks_.push_back(Task{std::move(work), {}, 0, priority});
+            for(const DataAccess& access : accesses)
+            {
+                if(access.data >= static_cast<int>(data_.size()))
+                {
+                    data_.resize(access.data+1);
+                }
+                DataState& state = data_[access.data];
+                if(state.last_writer >= 0 && state.last_writer != id)
+                {
+                    add_edge(state.last_writer, id);
+                }
+                if(access.access == Access::Write)
+                {
+                    for(int reader : state.readers)
+                    {
+                        if(reader != id)
+                        {
+                            add_edge(reader, id);
+                        }
+                    }
+                    state.readers.clear();
+                    state.last_writer = id;
+                }
+                else
+                {
+                    state.readers.push_back(id);
+                }
+            }
+            return id;
+        }
+
+        int size() const
+        {
+            return tasks_.size();
+        }
+
+        // Runs every task on at most num_threads threads of current_executor(), the calling
+        // thread being one of them, and rethrows the first exception a task threw once the
+        // running tasks have finished. Tasks that had not started by then are skipped.
+        void run(int num_threads = default_num_threads())
+        {
+            int num_tasks = tasks_.size();
+            std::vector<int> remaining(num_tasks);
+            auto later = [this](int left, int right)
+            {
+                return tasks_[left].priority != tasks_[right].priority ? tasks_[left].priority < tasks_[right].priority : left > right;
+            };
+            std::priority_queue<int, std::vector<int>, decltype(later)> ready(later);
+            for(int id = 0; id < num_tasks; ++id)
+            {
+                remaining[id] = tasks_[id].num_predecessors;
+                if(tasks_[id].num_predecessors == 0)
+                {
+                    ready.push(id);
+                }
+            }
+
+            std::mutex mutex;
+            std::condition_variable ready_or_done;
+            int num_finished = 0;
+            bool failed = false;
+            std::exception_ptr error;
+
+            auto worker = [&]()
+            {
+                bool nested = task_depth() > 0;
+                std::unique_lock<std::mutex> lock(mutex);
+                while(true)
+                {
+                    if(nested && ready.empty())
+                    {
+                        return;
+                    }
+                    ready_or_done.wait(lock, [&]{ return !ready.empty() || num_finished == num_tasks || failed; });
+                    if(num_finished == num_tasks || failed)
+                    {
+                        return;
+                    }
+                    int id = ready.top();
+                    ready.pop();
+                    lock.unlock();
+                    try
+                    {
+                        ++task_depth();
+                        tasks_[id].work();
+                        --task_depth();
+                    }
+                    catch(...)
+                    {
+                        --task_depth();
+                        lock.lock();
+                        if(!failed)
+                        {
+                            failed = true;
+                            error = std::current_exception();
+                        }
+                        ready_or_done.notify_all();
+                        return;
+                    }
+                    lock.lock();
+                    for(int successor : tasks_[id].successors)
+                    {
+                        if(--remaining[successor] == 0)
+                        {
+                            ready.push(successor);
+                            ready_or_done.notify_one();
+                        }
+                    }
+                    if(++num_finished == num_tasks)
+                    {
+                        ready_or_done.notify_all();
+                    }
+                }
+            };
+
+            Executor& executor = current_executor();
+            int num_workers = std::min({num_threads, executor.concurrency(), num_tasks});
+            if(num_workers <= 1)
+            {
+                worker();
+            }
+            else
+            {
+                executor.run(num_workers, [&](int)
+                {
+                    worker();
+                });
+            }
+            if(error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+};
+
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include "decompositions.hpp"
+#include "products.hpp"
+#include "tasks.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace math
+{
+
+constexpr int default_tile_size = 128;
+
+// Tile kernels work in place on square blocks of a row-major DynamicMatrix, given by the
+// first row or column of each block and its size.
+
+// Upper Cholesky factor of the diagonal block at k0
+template <typename T>
+void tile_cholesky(DynamicMatrix<T>& U, int k0, int size)
+{
+    int end = k0 + size;
+    for(int i = k0; i < end; ++i)
+    {
+        T* pivot_row = U(i).data();
+        if(!(pivot_row[i] > 0))
+        {
+            throw NotPositiveDefinite(i);
+        }
+        for(int j = i+1; j < end; ++j)
+        {
+            axpy(end-j, -pivot_row[j]/pivot_row[i], pivot_row + j, U(j).data() + j);
+        }
+        T inverse_sqrt = 1/std::sqrt(pivot_row[i]);
+        for(int column = i; column < end; ++column)
+        {
+            pivot_row[column] *= inverse_sqrt;
+        }
+    }
+}
+
+// Solves U_kk^T X = A_kj for the block in rows k0.. and columns j0..
+template <typename T>
+void tile_transposed_solve(DynamicMatrix<T>& U, int k0, int k_size, int j0, int j_size)
+{
+    for(int r = k0; r < k0 + k_size; ++r)
+    {
+        T* row = U(r).data() + j0;
+        for(int s = k0; s < r; ++s)
+        {
+            axpy(j_size, -U(s,r), U(s).data() + j0, row);
+        }
+        T inverse_pivot = 1/U(r,r);
+        for(int column = 0; column < j_size; ++column)
+        {
+            row[column] *= inverse_pivot;
+        }
+    }
+}
+
+// A_ij -= A_ki^T A_kj, only on and above the diagonal when the block is diagonal (i0 == j0)
+template <typename T>
+void tile_symmetric_update(DynamicMatrix<T>& U, int k0, int k_size, int i0, int i_size, int j0, int j_size)
+{
+    int j_end = j0 + j_size;
+    for(int s = k0; s < k0 + k_size; ++s)
+    {
+        const T* k_row = U(s).data();
+        for(int r = i0; r < i0 + i_size; ++r)
+        {
+            int first = i0 == j0 ? r : j0;
+            axpy(j_end - first, -k_row[r], k_row + first, U(r).data() + first);
+        }
+    }
+}
+
+// Cholesky factorization run as a task graph over tiles of the upper triangle. Per step k:
+// factor the diagonal tile, solve the tiles right of it, and update the trailing tiles.
+// Tasks on the next tile row get higher priority, so the next diagonal tile is factored as
+// soon as its inputs are ready while the rest of the current update is still running.
+template <typename T>
+DynamicCholeskyDecomposition<T> tiled_cholesky(const DynamicMatrix<T>& A, int tile_size = default_tile_size, int num_threads = default_num_threads())
+{
+    check_square(A);
+    int N = A.length();
+    DynamicCholeskyDecomposition<T> decomposition;
+    decomposition.cholesky = A;
+    DynamicMatrix<T>& U = decomposition.cholesky;
+
+    int num_tiles = (N + tile_size - 1)/tile_size;
+    auto tile = [num_tiles](int row, int column)
+    {
+        return row*num_tiles + column;
+    };
+    auto length = [=](int index)
+    {
+        return std::min(tile_size, N - index*tile_size);
+    };
+    auto priority = [num_tiles](int row, bool on_panel)
+    {
+        return 2*(num_tiles - row) + (on_panel ? 1 : 0);
+    };
+
+    TaskGraph graph;
+    for(int k = 0; k < num_tiles; ++k)
+    {
+        int k0 = k*tile_size;
+        graph.add([&U, k0, k_size = length(k)]{ tile_cholesky(U, k0, k_size); },
+            {{tile(k,k), Access::Write}}, priority(k, true));
+        for(int j = k+1; j < num_tiles; ++j)
+        {
+            graph.add([&U, k0, k_size = length(k), j0 = j*tile_size, j_size = length(j)]{ tile_transposed_solve(U, k0, k_size, j0, j_size); },
+                {{tile(k,k), Access::Read}, {tile(k,j), Access::Write}}, priority(k, true));
+        }
+        for(int i = k+1; i < num_tiles; ++i)
+        {
+            for(int j = i; j < num_tiles; ++j)
+            {
+                graph.add([&U, k0, k_size = length(k), i0 = i*tile_size, i_size = length(i), j0 = j*tile_size, j_size = length(j)]
+                    {
+                        tile_symmetric_update(U, k0, k_size, i0, i_size, j0, j_size);
+                    },
+                    {{tile(k,i), Access::Read}, {tile(k,j), Access::Read}, {tile(i,j), Access::Write}}, priority(i, false));
+            }
+        }
+    }
+    graph.run(num_threads);
+
+    for(int row = 0; row < N; ++row)
+    {
+        std::fill(U(row).data(), U(row).data() + row, static_cast<T>(0));
+    }
+    return decomposition;
+}
+
+// Partial pivoting LU of the column panel k0..k0+size over rows k0..; ipiv[c] is the row
+// swapped with row c
+template <typename T>
+void tile_lu_panel(DynamicMatrix<T>& A, int k0, int size, std::vector<int>& ipiv)
+{
+    int N = A.length();
+    int end = k0 + size;
+    for(int c = k0; c < end; ++c)
+    {
+        int pivot = c;
+        for(int row = c+1; row < N; ++row)
+        {
+            if(std::abs(A(row,c)) > std::abs(A(pivot,c)))
+            {
+                pivot = row;
+            }
+        }
+        ipiv[c] = pivot;
+        if(pivot != c)
+        {
+            std::swap_ranges(A(c).data() + k0, A(c).data() + end, A(pivot).data() + k0);
+        }
+        const T* pivot_row = A(c).data();
+        if(pivot_row[c] == static_cast<T>(0))
+        {
+            continue;
+        }
+        for(int row = c+1; row < N; ++row)
+        {
+            T* values = A(row).data();
+            values[c] /= pivot_row[c];
+            axpy(end - (c+1), -values[c], pivot_row + c+1, values + c+1);
+        }
+    }
+}
+
+// Brings column block j0 up to date with panel k0: applies the panel's row swaps, solves
+// with its unit lower triangle and subtracts L_ik U_kj from every row below the panel
+template <typename T>
+void tile_lu_update(DynamicMatrix<T>& A, int k0, int k_size, int j0, int j_size, const std::vector<int>& ipiv)
+{
+    int N = A.length();
+    int k_end = k0 + k_size;
+    for(int c = k0; c < k_end; ++c)
+    {
+        if(ipiv[c] != c)
+        {
+            std::swap_ranges(A(c).data() + j0, A(c).data() + j0 + j_size, A(ipiv[c]).data() + j0);
+        }
+    }
+    for(int row = k0; row < N; ++row)
+    {
+        T* values = A(row).data();
+        for(int s = k0; s < std::min(row, k_end); ++s)
+        {
+            axpy(j_size, -values[s], A(s).data() + j0, values + j0);
+        }
+    }
+}
+
+// LU factorization with partial pivoting run as a task graph over column blocks: a panel
+// task per block column, then one update task per later block column. The update of the
+// next block column and the next panel get the highest priority (lookahead), so panels
+// overlap with the trailing updates instead of waiting at a barrier.
+template <typename T>
+DynamicLUDecomposition<T> tiled_lu(const DynamicMatrix<T>& A, int tile_size = default_tile_size, int num_threads = default_num_threads())
+{
+    check_square(A);
+    int N = A.length();
+    DynamicMatrix<T> packed(A);
+    std::vector<int> ipiv(N);
+
+    int num_tiles = (N + tile_size - 1)/tile_size;
+    auto length = [=](int index)
+    {
+        return std::min(tile_size, N - index*tile_size);
+    };
+    auto priority = [num_tiles](int column, bool is_panel)
+    {
+        return 2*(num_tiles - column) + (is_panel ? 1 : 0);
+    };
+
+    TaskGraph graph;
+    for(int k = 0; k < num_tiles; ++k)
+    {
+        int k0 = k*tile_size;
+        graph.add([&packed, &ipiv, k0, k_size = length(k)]{ tile_lu_panel(packed, k0, k_size, ipiv); },
+            {{k, Access::Write}}, priority(k, true));
+        for(int j = k+1; j < num_tiles; ++j)
+        {
+            graph.add([&packed, &ipiv, k0, k_size = length(k), j0 = j*tile_size, j_size = length(j)]
+                {
+                    tile_lu_update(packed, k0, k_size, j0, j_size, ipiv);
+                },
+                {{k, Access::Read}, {j, Access::Write}}, priority(j, false));
+        }
+    }
+    graph.run(num_threads);
+
+    // Later panels' swaps still have to reach the columns of L to their left
+    for(int k = 1; k < num_tiles; ++k)
+    {
+        int k0 = k*tile_size;
+        for(int c = k0; c < k0 + length(k); ++c)
+        {
+            if(ipiv[c] != c)
+            {
+                std::swap_ranges(packed(c).data(), packed(c).data() + k0, packed(ipiv[c]).data());
+            }
+        }
+    }
+
+    DynamicLUDecomposition<T> decomposition;
+    ensure_shape(decomposition.L, N, N);
+    ensure_shape(decomposition.U, N, N);
+    ensure_shape(decomposition.P, N);
+    for(int row = 0; row < N; ++row)
+    {
+        decomposition.P(row) = row;
+    }
+    decomposition.permutation_sign = 1;
+    for(int row = 0; row < N; ++row)
+    {
+        if(ipiv[row] != row)
+        {
+            swap(decomposition.P(row), decomposition.P(ipiv[row]));
+            decomposition.permutation_sign = -decomposition.permutation_sign;
+        }
+        for(int column = 0; column < N; ++column)
+        {
+            T value = packed(row,column);
+            decomposition.L(row,column) = column < row ? value : (column == row ? static_cast<T>(1) : static_cast<T>(0));
+            decomposition.U(row,column) = column >= row ? value : static_cast<T>(0);
+        }
+    }
+    return decomposition;
+}
+
+}
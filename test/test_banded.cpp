@@ -0,0 +1,174 @@
+#include "matrix/banded.hpp"
+#include "matrix/decompositions.hpp"
+#include "matrix/products.hpp"
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using test_helpers::random_entry;
+using test_helpers::random_vector;
+
+class BandedFixture: public test_helpers::PooledFixture
+{
+    protected:
+        // Random band matrix with diagonal_shift added on the diagonal
+        static math::BandMatrix<double> random_band(int n, int lower, int upper, double diagonal_shift, unsigned seed)
+        {
+            math::BandMatrix<double> band(n, lower, upper);
+            for(int row = 0; row < n; ++row)
+            {
+                for(int column = band.first_column(row); column <= band.last_column(row); ++column)
+                {
+                    band(row, column) = random_entry(seed) + (row == column ? diagonal_shift : 0.0);
+                }
+            }
+            return band;
+        }
+
+        // Diagonally dominant tridiagonal matrix, like a discretized diffusion operator
+        static math::TridiagonalMatrix<double> random_tridiagonal(int n, unsigned seed)
+        {
+            math::TridiagonalMatrix<double> A(n);
+            for(int index = 0; index < n; ++index)
+            {
+                A.diagonal(index) = 4.0 + random_entry(seed);
+                if(index + 1 < n)
+                {
+                    A.lower(index) = -1.0 + random_entry(seed);
+                    A.upper(index) = -1.0 + random_entry(seed);
+                }
+            }
+            return A;
+        }
+};
+
+TEST_F(BandedFixture, BandGemvMatchesDense)
+{
+    int n = 2000;
+    math::BandMatrix<double> band = random_band(n, 3, 5, 0.0, 1);
+    math::DynamicMatrix<double> dense = math::unpack(band);
+    math::DynamicVector<double> x = random_vector(n, 2);
+    math::DynamicVector<double> y0 = random_vector(n, 3);
+    for(math::Transpose transpose : {math::Transpose::No, math::Transpose::Yes})
+    {
+        math::DynamicVector<double> expected(y0);
+        math::DynamicVector<double> y(y0);
+        math::gemv(2.0, dense, transpose, x, 0.5, expected);
+        math::gemv(2.0, band, transpose, x, 0.5, y);
+        for(int index = 0; index < n; ++index)
+        {
+            ASSERT_NEAR(y(index), expected(index), 1e-12);
+        }
+    }
+}
+
+TEST_F(BandedFixture, PackBandReadsOnlyTheBand)
+{
+    math::DynamicMatrix<double> A(5, 5);
+    A.fill(7.0);
+    math::DynamicMatrix<double> band = math::unpack(math::pack_band(A, 1, 2));
+    for(int row = 0; row < 5; ++row)
+    {
+        for(int column = 0; column < 5; ++column)
+        {
+            bool inside = column >= row - 1 && column <= row + 2;
+            ASSERT_EQ(band(row, column), inside ? 7.0 : 0.0);
+        }
+    }
+}
+
+TEST_F(BandedFixture, BandLUSolvesWithPivoting)
+{
+    int n = 300;
+    // No diagonal shift, so partial pivoting has to swap rows
+    math::BandMatrix<double> A = random_band(n, 2, 3, 0.0, 4);
+    math::DynamicVector<double> b = random_vector(n, 5);
+    math::BandLUDecomposition<double> lu(A);
+    math::DynamicVector<double> x = math::solve(lu, b);
+    math::DynamicVector<double> expected = math::solve(math::DynamicLUDecomposition<double>(math::unpack(A)), b);
+    for(int index = 0; index < n; ++index)
+    {
+        ASSERT_NEAR(x(index), expected(index), 1e-8*(1.0 + std::abs(expected(index))));
+    }
+}
+
+TEST_F(BandedFixture, BandCholeskyMatchesDenseFactor)
+{
+    int n = 400;
+    int bandwidth = 40;
+    math::BandMatrix<double> A = random_band(n, bandwidth, bandwidth, 2.0*bandwidth, 6);
+    for(int row = 0; row < n; ++row)
+    {
+        for(int column = A.first_column(row); column < row; ++column)
+        {
+            A(row, column) = A(column, row);
+        }
+    }
+    math::DynamicVector<double> b = random_vector(n, 7);
+    math::BandCholeskyDecomposition<double> band(A);
+    math::DynamicCholeskyDecomposition<double> dense(math::unpack(A));
+    for(int row = 0; row < n; ++row)
+    {
+        for(int column = row; column <= band.last_column(row); ++column)
+        {
+            ASSERT_NEAR(band.cholesky(row, column - row), dense.cholesky(row, column), 1e-12);
+        }
+    }
+    math::DynamicVector<double> x = math::solve(band, b);
+    math::DynamicVector<double> residual = A*x;
+    for(int index = 0; index < n; ++index)
+    {
+        ASSERT_NEAR(residual(index), b(index), 1e-12);
+    }
+}
+
+TEST_F(BandedFixture, BandCholeskyRejectsIndefinite)
+{
+    math::BandMatrix<double> A(4, 1, 1);
+    for(int index = 0; index < 4; ++index)
+    {
+        A(index, index) = index == 2 ? -1.0 : 2.0;
+    }
+    ASSERT_THROW(math::BandCholeskyDecomposition<double>{A}, math::NotPositiveDefinite);
+}
+
+TEST_F(BandedFixture, ThomasSolve)
+{
+    int n = 1000;
+    math::TridiagonalMatrix<double> A = random_tridiagonal(n, 8);
+    math::DynamicVector<double> b = random_vector(n, 9);
+    math::DynamicVector<double> x = math::thomas_solve(A, b);
+    math::DynamicVector<double> residual = A*x;
+    math::DynamicVector<double> dense_residual = math::unpack(A)*x;
+    for(int index = 0; index < n; ++index)
+    {
+        ASSERT_NEAR(residual(index), b(index), 1e-12);
+        ASSERT_NEAR(dense_residual(index), b(index), 1e-12);
+    }
+}
+
+TEST_F(BandedFixture, ThomasRejectsZeroPivot)
+{
+    math::TridiagonalMatrix<double> A(3);
+    A.diagonal.fill(0.0);
+    math::DynamicVector<double> b(3);
+    b.fill(1.0);
+    ASSERT_THROW(math::thomas_solve(A, b), math::SingularMatrix);
+}
+
+TEST_F(BandedFixture, CyclicReductionMatchesThomas)
+{
+    for(int n : {1, 2, 3, 7, 8, 9, 100, 1023, 1024, 1025, 100000})
+    {
+        math::TridiagonalMatrix<double> A = random_tridiagonal(n, 10 + n);
+        math::DynamicVector<double> b = random_vector(n, 11 + n);
+        math::DynamicVector<double> expected = math::thomas_solve(A, b);
+        math::DynamicVector<double> x = math::cyclic_reduction_solve(A, b);
+        for(int index = 0; index < n; ++index)
+        {
+            ASSERT_NEAR(x(index), expected(index), 1e-12) << "n = " << n << ", index = " << index;
+        }
+    }
+}
@@ -0,0 +1,171 @@
+#include "matrix/batched.hpp"
+#include "matrix/decompositions.hpp"
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using test_helpers::random_entry;
+using test_helpers::random_matrix;
+
+class BatchedFixture: public test_helpers::PooledFixture
+{
+    protected:
+        // num_matrices general n by n matrices, made positive definite by adding n on the diagonal
+        // to their symmetric part when spd is set
+        static math::DynamicArray<double, 3> random_batch(int num_matrices, int n, bool spd, unsigned seed)
+        {
+            math::DynamicArray<double, 3> matrices(num_matrices, n, n);
+            for(int matrix = 0; matrix < num_matrices; ++matrix)
+            {
+                for(int row = 0; row < n; ++row)
+                {
+                    for(int column = 0; column < n; ++column)
+                    {
+                        matrices(matrix)(row, column) = random_entry(seed);
+                    }
+                }
+                if(spd)
+                {
+                    for(int row = 0; row < n; ++row)
+                    {
+                        for(int column = 0; column < row; ++column)
+                        {
+                            matrices(matrix)(row, column) = matrices(matrix)(column, row);
+                        }
+                        matrices(matrix)(row, row) += n;
+                    }
+                }
+            }
+            return matrices;
+        }
+
+        static math::DynamicMatrix<double> copy(const math::DynamicArray<double, 3>& matrices, int matrix)
+        {
+            int n = matrices(0).length();
+            math::DynamicMatrix<double> result(n, n);
+            for(int row = 0; row < n; ++row)
+            {
+                for(int column = 0; column < n; ++column)
+                {
+                    result(row, column) = matrices(matrix)(row, column);
+                }
+            }
+            return result;
+        }
+};
+
+TEST_F(BatchedFixture, CholeskyMatchesSingleDecompositions)
+{
+    auto matrices = random_batch(101, 16, true, 1);
+    auto original = matrices;
+    auto B = random_matrix(101, 16, 2);
+    auto X = B;
+    math::batched_cholesky(matrices);
+    math::batched_cholesky_solve(matrices, X);
+    for(int matrix = 0; matrix < 101; ++matrix)
+    {
+        math::DynamicCholeskyDecomposition<double> single(copy(original, matrix));
+        math::DynamicVector<double> b(16);
+        for(int index = 0; index < 16; ++index)
+        {
+            b(index) = B(matrix, index);
+        }
+        auto x = math::solve(single, b);
+        for(int row = 0; row < 16; ++row)
+        {
+            for(int column = 0; column < 16; ++column)
+            {
+                ASSERT_NEAR(matrices(matrix)(row, column), single.cholesky(row, column), 1e-12);
+            }
+            ASSERT_NEAR(X(matrix, row), x(row), 1e-12);
+        }
+    }
+}
+
+TEST_F(BatchedFixture, CholeskyReportsFirstFailure)
+{
+    auto matrices = random_batch(20, 5, true, 3);
+    matrices(13)(2, 2) = -1.0;
+    matrices(17)(0, 0) = 0.0;
+    auto original = matrices;
+    try
+    {
+        math::batched_cholesky(matrices);
+        FAIL();
+    }
+    catch(const math::BatchNotPositiveDefinite& error)
+    {
+        ASSERT_EQ(error.matrix(), 13);
+        ASSERT_EQ(error.pivot(), 2);
+    }
+    math::DynamicCholeskyDecomposition<double> single(copy(original, 19));
+    for(int row = 0; row < 5; ++row)
+    {
+        for(int column = 0; column < 5; ++column)
+        {
+            ASSERT_NEAR(matrices(19)(row, column), single.cholesky(row, column), 1e-12);
+        }
+    }
+}
+
+TEST_F(BatchedFixture, LUSolvesGeneralMatrices)
+{
+    auto matrices = random_batch(70, 33, false, 4);
+    auto original = matrices;
+    auto B = random_matrix(70, 33, 5);
+    auto X = B;
+    auto pivots = math::batched_lu(matrices);
+    math::batched_lu_solve(matrices, pivots, X);
+    ASSERT_EQ(pivots.length(), 70);
+    for(int matrix = 0; matrix < 70; ++matrix)
+    {
+        math::DynamicLUDecomposition<double> single(copy(original, matrix));
+        for(int row = 0; row < 33; ++row)
+        {
+            for(int column = row; column < 33; ++column)
+            {
+                ASSERT_NEAR(matrices(matrix)(row, column), single.U(row, column), 1e-10);
+            }
+            double residual = -B(matrix, row);
+            for(int column = 0; column < 33; ++column)
+            {
+                residual += original(matrix)(row, column)*X(matrix, column);
+            }
+            ASSERT_NEAR(residual, 0.0, 1e-9);
+        }
+    }
+}
+
+TEST_F(BatchedFixture, FloatBatch)
+{
+    math::DynamicArray<float, 3> matrices(3, 2, 2);
+    for(int matrix = 0; matrix < 3; ++matrix)
+    {
+        matrices(matrix)(0, 0) = 4.0f;
+        matrices(matrix)(0, 1) = 2.0f;
+        matrices(matrix)(1, 0) = 2.0f;
+        matrices(matrix)(1, 1) = 2.0f + matrix;
+    }
+    math::DynamicMatrix<float> B(3, 2);
+    B.fill(1.0f);
+    math::batched_cholesky(matrices);
+    math::batched_cholesky_solve(matrices, B);
+    for(int matrix = 0; matrix < 3; ++matrix)
+    {
+        ASSERT_FLOAT_EQ(matrices(matrix)(0, 0), 2.0f);
+        ASSERT_FLOAT_EQ(matrices(matrix)(1, 0), 0.0f);
+        ASSERT_NEAR(4.0f*B(matrix, 0) + 2.0f*B(matrix, 1), 1.0f, 1e-5f);
+        ASSERT_NEAR(2.0f*B(matrix, 0) + (2.0f + matrix)*B(matrix, 1), 1.0f, 1e-5f);
+    }
+}
+
+TEST_F(BatchedFixture, MismatchedShapes)
+{
+    math::DynamicArray<double, 3> rectangular(4, 3, 2);
+    ASSERT_THROW(math::batched_cholesky(rectangular), math::MismatchedLength);
+    auto matrices = random_batch(4, 3, true, 6);
+    math::DynamicMatrix<double> B(5, 3);
+    ASSERT_THROW(math::batched_cholesky_solve(matrices, B), math::MismatchedLength);
+}
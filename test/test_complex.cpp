@@ -0,0 +1,195 @@
+#include "matrix/decompositions.hpp"
+#include "matrix/metrics.hpp"
+#include "matrix/products.hpp"
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <complex>
+
+using complexd = std::complex<double>;
+using test_helpers::random_matrix;
+
+class ComplexFixture: public test_helpers::PooledFixture
+{
+    protected:
+        static complexd element(const math::DynamicMatrix<complexd>& matrix, math::Transpose transpose, int row, int column)
+        {
+            switch(transpose)
+            {
+                case math::Transpose::No:
+                    return matrix(row, column);
+                case math::Transpose::Yes:
+                    return matrix(column, row);
+                default:
+                    return std::conj(matrix(column, row));
+            }
+        }
+
+        static void expect_near(const math::DynamicMatrix<complexd>& left, const math::DynamicMatrix<complexd>& right, double tolerance)
+        {
+            ASSERT_EQ(left.length(), right.length());
+            for(int row = 0; row < left.length(); ++row)
+            {
+                for(int column = 0; column < left(row).length(); ++column)
+                {
+                    ASSERT_LE(std::abs(left(row, column) - right(row, column)), tolerance);
+                }
+            }
+        }
+};
+
+TEST_F(ComplexFixture, GemmAllTransposes)
+{
+    const math::Transpose transposes[] = {math::Transpose::No, math::Transpose::Yes, math::Transpose::ConjugateTranspose};
+    int m = 13;
+    int k = 22;
+    int n = 9;
+    complexd alpha(0.5, -1.5);
+    complexd beta(2.0, 0.25);
+    for(auto transpose_A : transposes)
+    {
+        for(auto transpose_B : transposes)
+        {
+            auto A = transpose_A == math::Transpose::No ? random_matrix<complexd>(m, k, 1) : random_matrix<complexd>(k, m, 1);
+            auto B = transpose_B == math::Transpose::No ? random_matrix<complexd>(k, n, 2) : random_matrix<complexd>(n, k, 2);
+            auto C = random_matrix<complexd>(m, n, 3);
+            math::DynamicMatrix<complexd> expected(m, n);
+            for(int row = 0; row < m; ++row)
+            {
+                for(int column = 0; column < n; ++column)
+                {
+                    complexd sum = 0;
+                    for(int inner = 0; inner < k; ++inner)
+                    {
+                        sum += element(A, transpose_A, row, inner)*element(B, transpose_B, inner, column);
+                    }
+                    expected(row, column) = alpha*sum + beta*C(row, column);
+                }
+            }
+            math::gemm(alpha, A, transpose_A, B, transpose_B, beta, C);
+            expect_near(C, expected, 1e-12);
+        }
+    }
+}
+
+TEST_F(ComplexFixture, GemvAndDots)
+{
+    auto A = random_matrix<complexd>(7, 11, 4);
+    auto X = random_matrix<complexd>(1, 11, 5);
+    auto W = random_matrix<complexd>(1, 7, 6);
+    math::DynamicVector<complexd> x(11);
+    math::DynamicVector<complexd> w(7);
+    for(int index = 0; index < 11; ++index)
+    {
+        x(index) = X(0, index);
+    }
+    for(int index = 0; index < 7; ++index)
+    {
+        w(index) = W(0, index);
+    }
+
+    math::DynamicVector<complexd> y(7);
+    math::gemv(complexd(1), A, x, complexd(0), y);
+    math::DynamicVector<complexd> z(11);
+    math::gemv(complexd(1), A, math::Transpose::ConjugateTranspose, w, complexd(0), z);
+    for(int row = 0; row < 7; ++row)
+    {
+        complexd expected = 0;
+        for(int column = 0; column < 11; ++column)
+        {
+            expected += A(row, column)*x(column);
+        }
+        ASSERT_LE(std::abs(y(row) - expected), 1e-12);
+    }
+    for(int column = 0; column < 11; ++column)
+    {
+        complexd expected = 0;
+        for(int row = 0; row < 7; ++row)
+        {
+            expected += std::conj(A(row, column))*w(row);
+        }
+        ASSERT_LE(std::abs(z(column) - expected), 1e-12);
+    }
+
+    complexd inner = math::dotc(11, x.data(), x.data());
+    ASSERT_NEAR(inner.imag(), 0.0, 1e-15);
+    ASSERT_NEAR(std::sqrt(inner.real()), math::norm(x), 1e-14);
+}
+
+TEST_F(ComplexFixture, Norm)
+{
+    math::DynamicVector<complexd> vector(2);
+    vector(0) = complexd(3e200, 4e200);
+    vector(1) = complexd(0, 0);
+    ASSERT_NEAR(math::norm(vector)/5e200, 1.0, 1e-15);
+    ASSERT_NEAR(math::norm1(vector)/5e200, 1.0, 1e-15);
+}
+
+TEST_F(ComplexFixture, LUSolve)
+{
+    auto A = random_matrix<complexd>(12, 12, 7);
+    auto B = random_matrix<complexd>(1, 12, 8);
+    math::DynamicVector<complexd> b(12);
+    for(int index = 0; index < 12; ++index)
+    {
+        b(index) = B(0, index);
+    }
+    math::DynamicLUDecomposition<complexd> lu(A);
+    auto x = math::solve(lu, b);
+    auto residual = A*x;
+    for(int index = 0; index < 12; ++index)
+    {
+        ASSERT_LE(std::abs(residual(index) - b(index)), 1e-12);
+    }
+
+    math::DynamicMatrix<complexd> diagonal(2, 2);
+    diagonal.fill(complexd(0));
+    diagonal(0, 1) = complexd(0, 2);
+    diagonal(1, 0) = complexd(3, 0);
+    ASSERT_LE(std::abs(math::det(math::DynamicLUDecomposition<complexd>(diagonal)) - complexd(0, -6)), 1e-15);
+}
+
+TEST_F(ComplexFixture, HermitianCholesky)
+{
+    auto B = random_matrix<complexd>(10, 10, 9);
+    math::DynamicMatrix<complexd> A(10, 10);
+    math::gemm(complexd(1), B, math::Transpose::ConjugateTranspose, B, math::Transpose::No, complexd(0), A);
+    for(int index = 0; index < 10; ++index)
+    {
+        A(index, index) += 1.0;
+    }
+    math::DynamicCholeskyDecomposition<complexd> cholesky(A);
+    math::DynamicMatrix<complexd> product(10, 10);
+    math::gemm(complexd(1), cholesky.cholesky, math::Transpose::ConjugateTranspose, cholesky.cholesky, math::Transpose::No, complexd(0), product);
+    expect_near(product, A, 1e-12);
+
+    math::DynamicVector<complexd> b(10);
+    for(int index = 0; index < 10; ++index)
+    {
+        b(index) = complexd(index, 1);
+    }
+    auto x = math::solve(cholesky, b);
+    auto residual = A*x;
+    for(int index = 0; index < 10; ++index)
+    {
+        ASSERT_LE(std::abs(residual(index) - b(index)), 1e-12);
+    }
+}
+
+TEST(ComplexReal, ConjugateTransposeOfRealIsTranspose)
+{
+    math::DynamicMatrix<double> A(3, 2);
+    for(int row = 0; row < 3; ++row)
+    {
+        for(int column = 0; column < 2; ++column)
+        {
+            A(row, column) = row - 2.0*column;
+        }
+    }
+    math::DynamicMatrix<double> transposed(2, 2);
+    math::DynamicMatrix<double> conjugated(2, 2);
+    math::gemm(1.0, A, math::Transpose::Yes, A, math::Transpose::No, 0.0, transposed);
+    math::gemm(1.0, A, math::Transpose::ConjugateTranspose, A, math::Transpose::No, 0.0, conjugated);
+    ASSERT_TRUE(math::all_equal(transposed, conjugated));
+}
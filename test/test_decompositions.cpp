@@ -4,6 +4,66 @@
 #include <gtest/gtest.h>
 
 #include <cmath>
+#include <cstdlib>
+#include <new>
+
+// Counts every global allocation, plain and over-aligned, while counting is switched on
+namespace
+{
+    bool count_allocations = false;
+    int num_allocations = 0;
+
+    void* counted_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if(count_allocations)
+        {
+            ++num_allocations;
+        }
+        bytes = (bytes + alignment - 1)/alignment*alignment;
+        void* pointer = std::aligned_alloc(alignment, bytes == 0 ? alignment : bytes);
+        if(pointer == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return pointer;
+    }
+
+    // Out of line, so the compiler cannot pair std::free with the operator new it inlined
+    [[gnu::noinline]] void counted_free(void* pointer)
+    {
+        std::free(pointer);
+    }
+}
+
+void* operator new(std::size_t bytes)
+{
+    return counted_allocate(bytes, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t bytes, std::align_val_t alignment)
+{
+    return counted_allocate(bytes, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept
+{
+    counted_free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    counted_free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    counted_free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    counted_free(pointer);
+}
 
 TEST(DynamicForwardSubstitution, Test1)
 {
@@ -127,6 +187,25 @@ TEST(DynamicLUDecomposition, Test1)
     ASSERT_TRUE(math::all_equal(A*solution, b));
 }
 
+TEST(DynamicLUDecomposition, SolveInPlace)
+{
+    // Pivoting gives P = {3, 2, 1, 0}, so a plain gather into b would read overwritten entries
+    math::DynamicMatrixd A = {
+        {1.0, 2.0, 0.0, 1.0},
+        {2.0, 1.0, 3.0, 0.0},
+        {3.0, 8.0, 1.0, 2.0},
+        {9.0, 1.0, 2.0, 1.0}
+    };
+    math::DynamicVectord b = {1.0, 2.0, 3.0, 4.0};
+    math::DynamicLUDecomposition lu(A);
+    auto expected = math::solve(lu, b);
+    math::solve(lu, b, b);
+    for(int index = 0; index < 4; ++index)
+    {
+        ASSERT_NEAR(b(index), expected(index), 1e-12);
+    }
+}
+
 TEST(LUDecomposition, Test1)
 {
     math::StaticArrayd<3,3> A = {
@@ -147,6 +226,24 @@ TEST(LUDecomposition, Test1)
     ASSERT_TRUE(math::all_equal(A*solution, b));
 }
 
+TEST(LUDecomposition, TallPivotsBelowLastColumn)
+{
+    // The first pivot is in row 2, past the last column
+    math::StaticArrayd<3,2> A = {
+        {1.0, 2.0},
+        {2.0, 1.0},
+        {5.0, 3.0}
+    };
+    math::LUDecomposition lu(A);
+    ASSERT_EQ(lu.P(0), 2);
+    auto product = lu.L*lu.U;
+    for(int row = 0; row < 3; ++row)
+    {
+        ASSERT_NEAR(product(row,0), A(lu.P(row),0), 1e-12);
+        ASSERT_NEAR(product(row,1), A(lu.P(row),1), 1e-12);
+    }
+}
+
 TEST(QRDecomposition, Static)
 {
     auto A = math::Identity<double,3>();
@@ -178,4 +275,735 @@ TEST(SwapElements, Vector)
     math::swap(x(0), x(1));
     ASSERT_EQ(x(0), 2);
     ASSERT_EQ(x(1), 1);
-}
\ No newline at end of file
+}
+
+TEST(MixedPrecisionSolve, WellConditionedConverges)
+{
+    math::DynamicMatrixd A = {
+        {10.0, 1.0, 2.0, 0.5},
+        {1.0, 12.0, 0.3, 1.0},
+        {2.0, 0.3, 9.0, 1.5},
+        {0.5, 1.0, 1.5, 11.0}
+    };
+    math::DynamicVectord x_correct = {
+        1.0/3.0, -2.0/7.0, 5.0/11.0, 0.1
+    };
+    math::DynamicVectord b = A*x_correct;
+    auto solution = math::mixed_precision_solve(A, b);
+    ASSERT_FALSE(solution.used_fallback);
+    ASSERT_GT(solution.iterations, 0);
+    ASSERT_LE(solution.backward_error, 2*std::numeric_limits<double>::epsilon());
+    for(int index = 0; index < x_correct.length(); ++index)
+    {
+        ASSERT_NEAR(solution.x(index), x_correct(index), 1e-14);
+    }
+}
+
+TEST(MixedPrecisionSolve, IllConditionedFallsBack)
+{
+    int N = 10;
+    math::DynamicMatrixd hilbert(N, N);
+    math::DynamicVectord b(N);
+    for(int row = 0; row < N; ++row)
+    {
+        for(int column = 0; column < N; ++column)
+        {
+            hilbert(row,column) = 1.0/(row+column+1);
+        }
+        b(row) = 1.0;
+    }
+    auto solution = math::mixed_precision_solve(hilbert, b);
+    ASSERT_TRUE(solution.used_fallback);
+    ASSERT_LE(solution.backward_error, 1e-14);
+}
+
+class CountingResource: public std::pmr::memory_resource
+{
+    public:
+        int allocations = 0;
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            ++allocations;
+            return math::aligned_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override
+        {
+            math::aligned_resource()->deallocate(pointer, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+};
+
+class RefactorFixture: public ::testing::Test
+{
+    protected:
+        math::DynamicMatrixd A = {
+            {4.0, 1.0, 2.0},
+            {1.0, 5.0, 0.5},
+            {2.0, 0.5, 6.0},
+            {1.0, 2.0, 3.0}
+        };
+        math::DynamicMatrixd square = {
+            {1.0, 1.0, 1.0},
+            {1.0, 4.0, 2.0},
+            {4.0, 7.0, 8.0}
+        };
+        math::DynamicVectord b = {1.0, 3.0, 9.0};
+};
+
+TEST_F(RefactorFixture, QRReconstructs)
+{
+    math::DynamicQRDecomposition qr(A);
+    ASSERT_EQ(qr.Q.length(), 4);
+    ASSERT_EQ(qr.Q(0).length(), 3);
+    ASSERT_EQ(qr.R.length(), 3);
+    auto product = qr.Q*qr.R;
+    math::DynamicMatrixd gram(3, 3);
+    math::gemm(1.0, qr.Q, math::Transpose::Yes, qr.Q, math::Transpose::No, 0.0, gram);
+    for(int row = 0; row < A.length(); ++row)
+    {
+        for(int column = 0; column < A(0).length(); ++column)
+        {
+            ASSERT_NEAR(product(row,column), A(row,column), 1e-12);
+        }
+    }
+    for(int row = 0; row < qr.R.length(); ++row)
+    {
+        for(int column = 0; column < qr.R.length(); ++column)
+        {
+            if(row > column)
+            {
+                ASSERT_NEAR(qr.R(row,column), 0.0, 1e-12);
+            }
+            ASSERT_NEAR(gram(row,column), row == column ? 1.0 : 0.0, 1e-12);
+        }
+    }
+}
+
+TEST_F(RefactorFixture, QRZeroColumn)
+{
+    math::DynamicMatrixd B = {
+        {0.0, 1.0},
+        {0.0, 2.0},
+        {0.0, 2.0}
+    };
+    math::DynamicQRDecomposition qr(B);
+    auto product = qr.Q*qr.R;
+    for(int row = 0; row < B.length(); ++row)
+    {
+        for(int column = 0; column < B(0).length(); ++column)
+        {
+            ASSERT_NEAR(product(row,column), B(row,column), 1e-12);
+        }
+    }
+    for(int row = 0; row < qr.R.length(); ++row)
+    {
+        for(int column = 0; column < qr.R(0).length(); ++column)
+        {
+            ASSERT_TRUE(std::isfinite(qr.R(row,column)));
+        }
+    }
+}
+
+TEST_F(RefactorFixture, QRExternalWorkspace)
+{
+    math::DynamicVectord workspace(math::DynamicQRDecomposition<double>::workspace_size(4, 3));
+    math::DynamicQRDecomposition qr(A, workspace);
+    math::DynamicVectord too_small(2);
+    ASSERT_THROW(qr.refactor(A, too_small), math::MismatchedLength);
+}
+
+TEST_F(RefactorFixture, ReusesStorage)
+{
+    math::DynamicLUDecomposition lu(square);
+    const double* storage = lu.U(0).data();
+    square(0,0) = 2.0;
+    lu.refactor(square);
+    ASSERT_EQ(lu.U(0).data(), storage);
+    ASSERT_TRUE(math::all_equal(square(lu.P), lu.L*lu.U));
+}
+
+TEST_F(RefactorFixture, SteadyStateDoesNotAllocate)
+{
+    // Built inside the scope, so any reallocation by refactor() would reach counting
+    CountingResource counting;
+    math::ScopedResource scope(&counting);
+    math::DynamicQRDecomposition<double> qr(A);
+    math::DynamicLUDecomposition<double> lu(square);
+    math::DynamicCholeskyDecomposition<double> cholesky(square);
+    math::DynamicVectord x(3);
+    math::DynamicVectord workspace(math::DynamicQRDecomposition<double>::workspace_size(4, 3));
+    int initial_allocations = counting.allocations;
+    ASSERT_GT(initial_allocations, 0);
+
+    num_allocations = 0;
+    count_allocations = true;
+    for(int repeat = 0; repeat < 10; ++repeat)
+    {
+        A(0,0) += 1.0;
+        square(0,0) += 1.0;
+        qr.refactor(A);
+        qr.refactor(A, workspace);
+        lu.refactor(square);
+        math::solve(lu, b, x);
+        cholesky.refactor(square);
+        math::solve(cholesky, b, x);
+    }
+    count_allocations = false;
+    ASSERT_EQ(counting.allocations, initial_allocations);
+    ASSERT_EQ(num_allocations, 0);
+    auto residual = square*math::solve(lu, b) - b;
+    ASSERT_LE(math::norm_inf(residual), 1e-12);
+}
+
+TEST(StaticDecompositions, NoHeapAllocation)
+{
+    math::StaticArrayd<3,3> A = {
+        {4.0, 1.0, 2.0},
+        {1.0, 5.0, 0.5},
+        {2.0, 0.5, 6.0}
+    };
+    math::StaticArrayd<3,2> tall = {
+        {1.0, 2.0},
+        {3.0, 4.0},
+        {5.0, 6.0}
+    };
+    math::StaticVectord<3> b = {1.0, 2.0, 3.0};
+
+    num_allocations = 0;
+    count_allocations = true;
+    math::QRDecomposition qr(tall);
+    math::LUDecomposition lu(A);
+    math::CholeskyDecomposition cholesky(A);
+    auto lu_x = math::solve(lu, b);
+    auto cholesky_x = math::solve(cholesky, b);
+    auto y = math::forward_substitution_solve(lu.L, b);
+    auto z = math::backward_substitution_solve(lu.U, y);
+    count_allocations = false;
+    ASSERT_EQ(num_allocations, 0);
+
+    auto product = qr.Q*qr.R;
+    for(int row = 0; row < 3; ++row)
+    {
+        ASSERT_NEAR(product(row,0), tall(row,0), 1e-12);
+        ASSERT_NEAR(product(row,1), tall(row,1), 1e-12);
+        ASSERT_NEAR((A*lu_x)(row), b(row), 1e-12);
+    }
+    ASSERT_NEAR(qr.R(2,0), 0.0, 1e-12);
+    ASSERT_NEAR(qr.R(1,0), 0.0, 1e-12);
+    ASSERT_NEAR(qr.R(2,1), 0.0, 1e-12);
+    (void)cholesky_x;
+    (void)z;
+}
+
+TEST(StaticDecompositions, CounterSeesHeapAllocation)
+{
+    num_allocations = 0;
+    count_allocations = true;
+    math::DynamicVectord vector(8);
+    count_allocations = false;
+    ASSERT_GT(num_allocations, 0);
+}
+
+class UpdateFixture: public ::testing::Test
+{
+    protected:
+        math::DynamicMatrixd A = {
+            {4.0, 1.0, 2.0},
+            {1.0, 5.0, 0.5},
+            {2.0, 0.5, 6.0}
+        };
+        math::DynamicVectord v = {0.5, -1.0, 2.0};
+        math::DynamicVectord b = {1.0, 2.0, 3.0};
+
+        math::DynamicMatrixd plus_outer(const math::DynamicMatrixd& matrix, const math::DynamicVectord& x, const math::DynamicVectord& y, double sign)
+        {
+            math::DynamicMatrixd result(matrix);
+            for(int row = 0; row < x.length(); ++row)
+            {
+                for(int column = 0; column < y.length(); ++column)
+                {
+                    result(row,column) += sign*x(row)*y(column);
+                }
+            }
+            return result;
+        }
+
+        void expect_near(const math::DynamicMatrixd& left, const math::DynamicMatrixd& right)
+        {
+            for(int row = 0; row < left.length(); ++row)
+            {
+                for(int column = 0; column < left(row).length(); ++column)
+                {
+                    ASSERT_NEAR(left(row,column), right(row,column), 1e-12);
+                }
+            }
+        }
+};
+
+TEST_F(UpdateFixture, CholeskySolve)
+{
+    math::DynamicCholeskyDecomposition cholesky(A);
+    auto x = math::solve(cholesky, b);
+    auto residual = A*x - b;
+    ASSERT_LE(math::norm_inf(residual), 1e-12);
+}
+
+TEST_F(UpdateFixture, CholeskyNotPositiveDefinite)
+{
+    math::DynamicMatrixd indefinite = {
+        {1.0, 2.0},
+        {2.0, 1.0}
+    };
+    ASSERT_THROW(math::DynamicCholeskyDecomposition<double>{indefinite}, math::NotPositiveDefinite);
+}
+
+TEST_F(UpdateFixture, CholeskyUpdate)
+{
+    math::DynamicCholeskyDecomposition cholesky(A);
+    cholesky.update(v);
+    math::DynamicCholeskyDecomposition expected(plus_outer(A, v, v, 1.0));
+    expect_near(cholesky.cholesky, expected.cholesky);
+}
+
+TEST_F(UpdateFixture, CholeskyDowndate)
+{
+    auto updated = plus_outer(A, v, v, 1.0);
+    math::DynamicCholeskyDecomposition cholesky(updated);
+    cholesky.downdate(v);
+    math::DynamicCholeskyDecomposition expected(A);
+    expect_near(cholesky.cholesky, expected.cholesky);
+    auto residual = A*math::solve(cholesky, b) - b;
+    ASSERT_LE(math::norm_inf(residual), 1e-12);
+}
+
+TEST_F(UpdateFixture, CholeskyDowndateRejected)
+{
+    math::DynamicCholeskyDecomposition cholesky(A);
+    math::DynamicMatrixd before(cholesky.cholesky);
+    math::DynamicVectord large = {10.0, 0.0, 0.0};
+    ASSERT_THROW(cholesky.downdate(large), math::NotPositiveDefinite);
+    ASSERT_TRUE(math::all_equal(before, cholesky.cholesky));
+}
+
+TEST_F(UpdateFixture, CholeskyRankK)
+{
+    math::DynamicMatrixd V = {
+        {0.5, -1.0, 2.0},
+        {1.0, 0.0, -0.5}
+    };
+    math::DynamicCholeskyDecomposition cholesky(A);
+    cholesky.update(V);
+    auto expected_matrix = plus_outer(plus_outer(A, V(0), V(0), 1.0), V(1), V(1), 1.0);
+    math::DynamicCholeskyDecomposition expected(expected_matrix);
+    expect_near(cholesky.cholesky, expected.cholesky);
+    cholesky.downdate(V);
+    math::DynamicCholeskyDecomposition original(A);
+    expect_near(cholesky.cholesky, original.cholesky);
+}
+
+TEST_F(UpdateFixture, StaticCholeskyUpdate)
+{
+    math::StaticArrayd<2,2> S = {
+        {4.0, 1.0},
+        {1.0, 3.0}
+    };
+    math::StaticArrayd<2,2> S_updated = {
+        {5.0, 3.0},
+        {3.0, 7.0}
+    };
+    math::StaticVectord<2> w = {1.0, 2.0};
+    math::CholeskyDecomposition cholesky(S);
+    cholesky.update(w);
+    math::CholeskyDecomposition expected(S_updated);
+    for(int row = 0; row < 2; ++row)
+    {
+        for(int column = 0; column < 2; ++column)
+        {
+            ASSERT_NEAR(cholesky.cholesky(row,column), expected.cholesky(row,column), 1e-12);
+        }
+    }
+    cholesky.downdate(w);
+    math::CholeskyDecomposition original(S);
+    ASSERT_NEAR(cholesky.cholesky(0,1), original.cholesky(0,1), 1e-12);
+    ASSERT_NEAR(cholesky.cholesky(1,1), original.cholesky(1,1), 1e-12);
+}
+
+TEST_F(UpdateFixture, LUUpdate)
+{
+    math::DynamicMatrixd square = {
+        {1.0, 1.0, 1.0},
+        {1.0, 4.0, 2.0},
+        {4.0, 7.0, 8.0}
+    };
+    math::DynamicVectord y = {1.0, -0.5, 0.25};
+    math::DynamicLUDecomposition lu(square);
+    lu.update(v, y);
+    auto updated = plus_outer(square, v, y, 1.0);
+    expect_near(updated(lu.P), lu.L*lu.U);
+    auto residual = updated*math::solve(lu, b) - b;
+    ASSERT_LE(math::norm_inf(residual), 1e-12);
+}
+
+class StreamingFixture: public ::testing::Test
+{
+    protected:
+        math::DynamicMatrixd A = {
+            {1.0, 0.0},
+            {1.0, 1.0},
+            {1.0, 2.0},
+            {1.0, 3.0},
+            {1.0, 4.0}
+        };
+        math::DynamicVectord b = {1.1, 2.9, 5.2, 6.8, 9.1};
+
+        // Normal equations solution of the rows in [first, last)
+        math::DynamicVectord batch_fit(int first, int last)
+        {
+            math::DynamicMatrixd normal = {{0.0, 0.0}, {0.0, 0.0}};
+            math::DynamicVectord rhs = {0.0, 0.0};
+            for(int row = first; row < last; ++row)
+            {
+                for(int i = 0; i < 2; ++i)
+                {
+                    for(int j = 0; j < 2; ++j)
+                    {
+                        normal(i,j) += A(row,i)*A(row,j);
+                    }
+                    rhs(i) += A(row,i)*b(row);
+                }
+            }
+            return math::solve(math::DynamicLUDecomposition<double>(normal), rhs);
+        }
+};
+
+TEST_F(StreamingFixture, MatchesBatchFit)
+{
+    math::StreamingLeastSquares<double> fit(2);
+    fit.add(A, b);
+    auto x = fit.solve();
+    auto expected = batch_fit(0, 5);
+    ASSERT_NEAR(x(0), expected(0), 1e-12);
+    ASSERT_NEAR(x(1), expected(1), 1e-12);
+    auto residual = A*x - b;
+    ASSERT_NEAR(fit.residual_norm(), math::norm(residual), 1e-12);
+}
+
+TEST_F(StreamingFixture, SlidingWindow)
+{
+    math::StreamingLeastSquares<double> fit(2);
+    fit.add(A, b);
+    fit.remove(A(0), b(0));
+    fit.remove(A(1), b(1));
+    auto x = fit.solve();
+    auto expected = batch_fit(2, 5);
+    ASSERT_NEAR(x(0), expected(0), 1e-12);
+    ASSERT_NEAR(x(1), expected(1), 1e-12);
+}
+
+TEST_F(StreamingFixture, RemoveFromExactFit)
+{
+    math::StreamingLeastSquares<double> fit(2);
+    for(int row = 0; row < 4; ++row)
+    {
+        fit.add(A(row), 1.0 + 2.0*A(row,1));
+    }
+    fit.remove(A(0), 1.0);
+    auto x = fit.solve();
+    ASSERT_NEAR(x(0), 1.0, 1e-12);
+    ASSERT_NEAR(x(1), 2.0, 1e-12);
+    ASSERT_NEAR(fit.residual_norm(), 0.0, 1e-12);
+}
+
+TEST_F(StreamingFixture, RemoveUpdatesResidualNorm)
+{
+    math::StreamingLeastSquares<double> fit(2);
+    fit.add(A, b);
+    fit.remove(A(0), b(0));
+    auto x = fit.solve();
+    double squared_residual = 0.0;
+    for(int row = 1; row < 5; ++row)
+    {
+        double r = A(row,0)*x(0) + A(row,1)*x(1) - b(row);
+        squared_residual += r*r;
+    }
+    ASSERT_NEAR(fit.residual_norm(), std::sqrt(squared_residual), 1e-12);
+}
+
+TEST_F(StreamingFixture, RemoveTooManyRows)
+{
+    math::StreamingLeastSquares<double> fit(2);
+    fit.add(A(0), b(0));
+    fit.add(A(1), b(1));
+    ASSERT_THROW(fit.remove(A(1), b(1)), math::NotPositiveDefinite);
+}
+
+TEST_F(StreamingFixture, ForgettingFactor)
+{
+    double lambda = 0.5;
+    math::StreamingLeastSquares<double> fit(2, lambda);
+    fit.add(A, b);
+    math::DynamicMatrixd weighted_A(A);
+    math::DynamicVectord weighted_b(b);
+    for(int row = 0; row < 5; ++row)
+    {
+        double weight = std::sqrt(std::pow(lambda, 4 - row));
+        weighted_A(row) *= weight;
+        weighted_b(row) *= weight;
+    }
+    math::StreamingLeastSquares<double> expected(2);
+    expected.add(weighted_A, weighted_b);
+    auto x = fit.solve();
+    auto x_expected = expected.solve();
+    ASSERT_NEAR(x(0), x_expected(0), 1e-12);
+    ASSERT_NEAR(x(1), x_expected(1), 1e-12);
+}
+
+class LeastSquaresFixture: public ::testing::Test
+{
+    protected:
+        math::DynamicMatrixd A = {
+            {1.0, 0.0},
+            {1.0, 1.0},
+            {1.0, 2.0},
+            {1.0, 3.0}
+        };
+        math::DynamicVectord b = {1.0, 2.9, 5.1, 7.0};
+
+        // Least squares solutions satisfy the normal equations A^T (Ax - b) = 0
+        double normal_residual(const math::DynamicVectord& x, const math::DynamicVectord& rhs)
+        {
+            auto residual = A*x - rhs;
+            return math::norm_inf(math::transpose(A)*residual);
+        }
+};
+
+TEST_F(LeastSquaresFixture, WithoutQ)
+{
+    math::DynamicQRDecomposition qr(A, math::FormQ::No);
+    ASSERT_EQ(qr.Q.length(), 0);
+    ASSERT_EQ(qr.R.length(), A(0).length());
+    ASSERT_EQ(qr.reflectors.length(), A(0).length());
+    ASSERT_EQ(qr.reflectors(0).length(), A.length());
+    auto x = math::lstsq(qr, b);
+    ASSERT_LE(normal_residual(x, b), 1e-12);
+}
+
+TEST_F(LeastSquaresFixture, RefactorWithoutQReleasesQ)
+{
+    math::DynamicQRDecomposition qr(A);
+    ASSERT_EQ(qr.Q.length(), 4);
+    qr.refactor(A, math::FormQ::No);
+    ASSERT_EQ(qr.Q.length(), 0);
+    auto x = math::lstsq(qr, b);
+    ASSERT_LE(normal_residual(x, b), 1e-12);
+    qr.refactor(A);
+    ASSERT_EQ(qr.Q.length(), 4);
+}
+
+TEST_F(LeastSquaresFixture, MatchesFormedQ)
+{
+    math::DynamicQRDecomposition with_q(A);
+    math::DynamicQRDecomposition without_q(A, math::FormQ::No);
+    ASSERT_TRUE(math::all_equal(with_q.R, without_q.R));
+    auto x = math::lstsq(with_q, b);
+    auto y = math::lstsq(without_q, b);
+    ASSERT_TRUE(math::all_equal(x, y));
+}
+
+TEST_F(LeastSquaresFixture, MultipleRightHandSides)
+{
+    math::DynamicMatrixd B = {
+        {1.0, 0.0},
+        {2.9, 1.0},
+        {5.1, 0.0},
+        {7.0, 1.0}
+    };
+    math::DynamicQRDecomposition qr(A, math::FormQ::No);
+    auto X = math::lstsq(qr, B);
+    ASSERT_EQ(X.length(), 2);
+    for(int rhs = 0; rhs < 2; ++rhs)
+    {
+        math::DynamicVectord column = {B(0,rhs), B(1,rhs), B(2,rhs), B(3,rhs)};
+        auto x = math::lstsq(qr, column);
+        ASSERT_NEAR(X(0,rhs), x(0), 1e-12);
+        ASSERT_NEAR(X(1,rhs), x(1), 1e-12);
+    }
+}
+
+TEST_F(LeastSquaresFixture, SquareSolve)
+{
+    math::DynamicMatrixd square = {
+        {1.0, 1.0, 1.0},
+        {1.0, 4.0, 2.0},
+        {4.0, 7.0, 8.0}
+    };
+    math::DynamicVectord rhs = {1.0, 3.0, 9.0};
+    auto x = math::solve(math::DynamicQRDecomposition<double>(square), rhs);
+    auto residual = square*x - rhs;
+    ASSERT_LE(math::norm_inf(residual), 1e-12);
+}
+
+TEST_F(LeastSquaresFixture, MinimumNorm)
+{
+    math::DynamicMatrixd wide = {
+        {1.0, 1.0, 0.0},
+        {0.0, 1.0, 1.0}
+    };
+    math::DynamicVectord rhs = {2.0, 2.0};
+    auto x = math::lstsq(wide, rhs);
+    auto residual = wide*x - rhs;
+    ASSERT_LE(math::norm_inf(residual), 1e-12);
+    // The minimum norm solution lies in the row space: x = (2/3, 4/3, 2/3)
+    ASSERT_NEAR(x(0), 2.0/3.0, 1e-12);
+    ASSERT_NEAR(x(1), 4.0/3.0, 1e-12);
+    ASSERT_NEAR(x(2), 2.0/3.0, 1e-12);
+}
+
+TEST_F(LeastSquaresFixture, Static)
+{
+    math::StaticArrayd<4,2> static_A = {
+        {1.0, 0.0},
+        {1.0, 1.0},
+        {1.0, 2.0},
+        {1.0, 3.0}
+    };
+    math::StaticVectord<4> static_b = {1.0, 2.9, 5.1, 7.0};
+    math::QRDecomposition qr(static_A);
+    auto x = math::lstsq(qr, static_b);
+    auto expected = math::lstsq(A, b);
+    ASSERT_NEAR(x(0), expected(0), 1e-12);
+    ASSERT_NEAR(x(1), expected(1), 1e-12);
+}
+
+class DeterminantFixture: public ::testing::Test
+{
+    protected:
+        math::DynamicMatrixd A = {
+            {1.0, 1.0, 1.0},
+            {1.0, 4.0, 2.0},
+            {4.0, 7.0, 8.0}
+        };
+        math::DynamicMatrixd S = {
+            {4.0, 1.0, 2.0},
+            {1.0, 5.0, 0.5},
+            {2.0, 0.5, 6.0}
+        };
+
+        void expect_identity(const math::DynamicMatrixd& product)
+        {
+            for(int row = 0; row < product.length(); ++row)
+            {
+                for(int column = 0; column < product.length(); ++column)
+                {
+                    ASSERT_NEAR(product(row,column), row == column ? 1.0 : 0.0, 1e-12);
+                }
+            }
+        }
+};
+
+TEST_F(DeterminantFixture, LU)
+{
+    // det A = 1(32-14) - 1(8-8) + 1(7-16) = 9
+    math::DynamicLUDecomposition lu(A);
+    ASSERT_NEAR(math::det(lu), 9.0, 1e-12);
+    auto log_determinant = math::logdet(lu);
+    ASSERT_EQ(log_determinant.sign, 1.0);
+    ASSERT_NEAR(log_determinant.log_abs, std::log(9.0), 1e-12);
+}
+
+TEST_F(DeterminantFixture, NegativeDeterminant)
+{
+    math::DynamicMatrixd swapped = {
+        {0.0, 1.0},
+        {1.0, 0.0}
+    };
+    math::DynamicLUDecomposition lu(swapped);
+    ASSERT_EQ(math::det(lu), -1.0);
+    ASSERT_EQ(math::logdet(lu).sign, -1.0);
+}
+
+TEST_F(DeterminantFixture, LogDeterminantDoesNotOverflow)
+{
+    int N = 400;
+    auto large = math::Identity<double>(N);
+    for(int index = 0; index < N; ++index)
+    {
+        large(index,index) = 1e10;
+    }
+    math::DynamicCholeskyDecomposition cholesky(large);
+    ASSERT_TRUE(std::isinf(math::det(cholesky)));
+    ASSERT_NEAR(math::logdet(cholesky), N*std::log(1e10), 1e-8);
+    math::DynamicLUDecomposition lu(large);
+    ASSERT_NEAR(math::logdet(lu).log_abs, N*std::log(1e10), 1e-8);
+}
+
+TEST_F(DeterminantFixture, Cholesky)
+{
+    math::DynamicCholeskyDecomposition cholesky(S);
+    math::DynamicLUDecomposition lu(S);
+    ASSERT_NEAR(math::det(cholesky), math::det(lu), 1e-10);
+    ASSERT_NEAR(math::logdet(cholesky), std::log(math::det(lu)), 1e-12);
+}
+
+TEST_F(DeterminantFixture, Inverse)
+{
+    math::DynamicLUDecomposition lu(A);
+    expect_identity(A*math::inverse(lu));
+    math::DynamicCholeskyDecomposition cholesky(S);
+    expect_identity(S*math::inverse(cholesky));
+}
+
+TEST_F(DeterminantFixture, InverseLarge)
+{
+    int N = 150;
+    math::DynamicMatrixd B(N, N);
+    for(int row = 0; row < N; ++row)
+    {
+        for(int column = 0; column < N; ++column)
+        {
+            B(row,column) = std::sin(row*7.0 + column*3.0) + (row == column ? N : 0.0);
+        }
+    }
+    math::DynamicLUDecomposition lu(B);
+    expect_identity(B*math::inverse(lu));
+}
+
+TEST_F(DeterminantFixture, ConditionEstimate)
+{
+    math::DynamicLUDecomposition lu(A);
+    double exact = math::norm1(A)*math::norm1(math::inverse(lu));
+    double estimate = math::condition_number_estimate(A, lu);
+    ASSERT_LE(estimate, exact*(1 + 1e-12));
+    ASSERT_GE(estimate, exact/3);
+
+    math::DynamicCholeskyDecomposition cholesky(S);
+    double exact_spd = math::norm1(S)*math::norm1(math::inverse(cholesky));
+    double estimate_spd = math::condition_number_estimate(S, cholesky);
+    ASSERT_LE(estimate_spd, exact_spd*(1 + 1e-12));
+    ASSERT_GE(estimate_spd, exact_spd/3);
+}
+
+TEST_F(DeterminantFixture, ConditionEstimateHilbert)
+{
+    int N = 8;
+    math::DynamicMatrixd hilbert(N, N);
+    for(int row = 0; row < N; ++row)
+    {
+        for(int column = 0; column < N; ++column)
+        {
+            hilbert(row,column) = 1.0/(row+column+1);
+        }
+    }
+    math::DynamicLUDecomposition lu(hilbert);
+    double exact = math::norm1(hilbert)*math::norm1(math::inverse(lu));
+    double estimate = math::condition_number_estimate(hilbert, lu);
+    ASSERT_GE(estimate, exact/3);
+    ASSERT_LE(estimate, exact*1.01);
+}
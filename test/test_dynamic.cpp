@@ -556,4 +556,26 @@ TEST(ARange, ARangeDynamic)
     };
 
     ASSERT_TRUE(math::all_equal(vector, answer));
-}
\ No newline at end of file
+}
+
+TEST(CastDynamicArray, Vector)
+{
+    math::DynamicVectord vector = {1.5, -2.25, 3.0};
+    math::DynamicVectorf converted = math::cast<float>(vector);
+    ASSERT_EQ(converted.length(), 3);
+    ASSERT_FLOAT_EQ(converted(1), -2.25f);
+}
+
+TEST(CastDynamicArray, Matrix)
+{
+    math::DynamicMatrixd matrix = {
+        {1.5, 2.0},
+        {3.0, 4.5}
+    };
+    math::DynamicMatrixi converted = math::cast<int>(matrix);
+    math::DynamicMatrixi answer = {
+        {1, 2},
+        {3, 4}
+    };
+    ASSERT_TRUE(math::all_equal(converted, answer));
+}
@@ -0,0 +1,155 @@
+#include "matrix/half.hpp"
+#include "matrix/dynamic.hpp"
+#include "matrix/static.hpp"
+#include "matrix/products.hpp"
+#include "matrix/reductions.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+TEST(Half, Float16Encoding)
+{
+    ASSERT_EQ(math::float16(1.0f).bits, 0x3c00);
+    ASSERT_EQ(math::float16(-2.0f).bits, 0xc000);
+    ASSERT_EQ(math::float16(65504.0f).bits, 0x7bff);
+    ASSERT_EQ(math::float16(65520.0f).bits, 0x7c00);
+    ASSERT_EQ(math::float16(std::ldexp(1.0f, -24)).bits, 0x0001);
+    ASSERT_EQ(math::float16(std::ldexp(1.0f, -26)).bits, 0x0000);
+    // 1 + 2^-11 lies halfway between 1 and the next half, and rounds to the even 1
+    ASSERT_EQ(math::float16(1.0f + std::ldexp(1.0f, -11)).bits, 0x3c00);
+    ASSERT_EQ(math::float16(1.0f + 3*std::ldexp(1.0f, -11)).bits, 0x3c02);
+    ASSERT_TRUE(std::isnan(static_cast<float>(math::float16(std::numeric_limits<float>::quiet_NaN()))));
+    ASSERT_TRUE(std::isinf(static_cast<float>(math::float16::from_bits(0xfc00))));
+}
+
+TEST(Half, Float16RoundTripsEveryValue)
+{
+    for(int bits = 0; bits < 0x10000; ++bits)
+    {
+        float value = math::float16::from_bits(bits);
+        if(!std::isnan(value))
+        {
+            ASSERT_EQ(math::float16(value).bits, bits);
+        }
+    }
+}
+
+TEST(Half, BFloat16Encoding)
+{
+    ASSERT_EQ(math::bfloat16(1.0f).bits, 0x3f80);
+    ASSERT_NEAR(static_cast<float>(math::bfloat16(3.0e38f))/3.0e38f, 1.0f, 1.0f/256);
+    // 1 + 2^-8 is a tie and rounds to the even 1; 1 + 3*2^-8 rounds up
+    ASSERT_EQ(math::bfloat16(1.0f + std::ldexp(1.0f, -8)).bits, 0x3f80);
+    ASSERT_EQ(math::bfloat16(1.0f + 3*std::ldexp(1.0f, -8)).bits, 0x3f82);
+    ASSERT_TRUE(std::isnan(static_cast<float>(math::bfloat16(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+TEST(Half, ConvertMatchesScalar)
+{
+    std::vector<float> values(1000);
+    for(int index = 0; index < 1000; ++index)
+    {
+        values[index] = std::sin(0.37f*index)*std::ldexp(1.0f, index % 40 - 20);
+    }
+    std::vector<math::float16> halves(1000);
+    std::vector<math::bfloat16> brains(1000);
+    math::convert(values.data(), halves.data(), 1000);
+    math::convert(values.data(), brains.data(), 1000);
+    std::vector<float> from_halves(1000);
+    std::vector<float> from_brains(1000);
+    math::convert(halves.data(), from_halves.data(), 1000);
+    math::convert(brains.data(), from_brains.data(), 1000);
+    for(int index = 0; index < 1000; ++index)
+    {
+        ASSERT_EQ(halves[index].bits, math::Binary16::encode(values[index]));
+        ASSERT_EQ(brains[index].bits, math::BrainFloat16::encode(values[index]));
+        ASSERT_EQ(from_halves[index], math::Binary16::decode(halves[index].bits));
+        ASSERT_EQ(from_brains[index], math::BrainFloat16::decode(brains[index].bits));
+    }
+}
+
+TEST(Half, ArraysHalveStorage)
+{
+    math::DynamicMatrixf matrix(3, 20);
+    for(int row = 0; row < 3; ++row)
+    {
+        for(int column = 0; column < 20; ++column)
+        {
+            matrix(row, column) = 0.25f*(row*20 + column);
+        }
+    }
+    auto halves = math::cast<math::float16>(matrix);
+    ASSERT_EQ(sizeof(halves(0, 0)), 2u);
+    ASSERT_TRUE(math::all_equal(math::cast<float>(halves), matrix));
+
+    math::StaticVector<math::bfloat16, 4> vector;
+    vector.fill(math::bfloat16(1.5f));
+    vector(2) += 1.0f;
+    ASSERT_EQ(static_cast<float>(vector(2)), 2.5f);
+    ASSERT_EQ(static_cast<float>(math::sum(vector)), 7.0f);
+}
+
+TEST(Half, ProductsAccumulateInFloat)
+{
+    // Summed in half precision, the ones would stop growing at 2048
+    int n = 4096;
+    math::DynamicMatrix<math::float16> A(2, n);
+    A.fill(math::float16(1.0f));
+    math::DynamicVector<math::float16> x(n);
+    x.fill(math::float16(1.0f));
+    math::DynamicVector<math::float16> y(2);
+    math::gemv(math::float16(1.0f), A, x, math::float16(0.0f), y);
+    ASSERT_EQ(static_cast<float>(y(0)), 4096.0f);
+    ASSERT_EQ(static_cast<float>(y(1)), 4096.0f);
+    ASSERT_EQ(static_cast<float>(math::sum(x)), 4096.0f);
+
+    math::DynamicVector<math::float16> z(n);
+    z.fill(math::float16(2.0f));
+    math::DynamicVector<math::float16> w(2);
+    w.fill(math::float16(3.0f));
+    math::gemv(math::float16(0.5f), A, math::Transpose::Yes, w, math::float16(1.0f), z);
+    ASSERT_EQ(static_cast<float>(z(0)), 5.0f);
+    ASSERT_EQ(static_cast<float>(z(n-1)), 5.0f);
+
+    math::DynamicMatrix<math::bfloat16> B(n, 3);
+    B.fill(math::bfloat16(1.0f));
+    math::DynamicMatrix<math::bfloat16> C(2, 3);
+    C.fill(math::bfloat16(1.0f));
+    math::DynamicMatrix<math::bfloat16> D = math::cast<math::bfloat16>(math::cast<float>(A));
+    math::gemm(math::bfloat16(1.0f), D, B, math::bfloat16(1.0f), C);
+    ASSERT_EQ(static_cast<float>(C(1, 2)), 4096.0f);
+}
+
+TEST(Half, WideningMatchesFloat)
+{
+    math::DynamicMatrixf A(17, 33);
+    math::DynamicMatrixf B(33, 9);
+    for(int row = 0; row < 33; ++row)
+    {
+        for(int column = 0; column < 33; ++column)
+        {
+            if(row < 17)
+            {
+                A(row, column) = static_cast<float>(math::float16(std::cos(0.1f*row*column)));
+            }
+            if(column < 9)
+            {
+                B(row, column) = static_cast<float>(math::float16(std::sin(0.2f*row + column)));
+            }
+        }
+    }
+    math::DynamicMatrixf expected(17, 9);
+    math::gemm(1.0f, A, B, 0.0f, expected);
+    math::DynamicMatrix<math::float16> C(17, 9);
+    math::gemm(math::float16(1.0f), math::cast<math::float16>(A), math::cast<math::float16>(B), math::float16(0.0f), C);
+    for(int row = 0; row < 17; ++row)
+    {
+        for(int column = 0; column < 9; ++column)
+        {
+            ASSERT_EQ(C(row, column).bits, math::float16(expected(row, column)).bits);
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "matrix/complex.hpp"
+#include "matrix/dynamic.hpp"
+#include "matrix/parallel.hpp"
+
+#include <gtest/gtest.h>
+
+namespace test_helpers
+{
+
+// Linear congruential generator, so fixtures get the same values on every platform
+inline unsigned next_random(unsigned& seed)
+{
+    seed = seed*1664525u + 1013904223u;
+    return seed;
+}
+
+// Uniform in [-0.5, 0.5)
+inline double random_entry(unsigned& seed)
+{
+    return static_cast<double>(next_random(seed) >> 8)/(1 << 24) - 0.5;
+}
+
+// Complex values draw their real part first, then their imaginary part
+template <typename T>
+T random_element(unsigned& seed)
+{
+    if constexpr(math::is_complex_v<T>)
+    {
+        using Real = typename T::value_type;
+        Real real = static_cast<Real>(random_entry(seed));
+        return T(real, static_cast<Real>(random_entry(seed)));
+    }
+    else
+    {
+        return static_cast<T>(random_entry(seed));
+    }
+}
+
+template <typename T = double>
+math::DynamicMatrix<T> random_matrix(int rows, int columns, unsigned seed)
+{
+    math::DynamicMatrix<T> matrix(rows, columns);
+    for(int row = 0; row < rows; ++row)
+    {
+        for(int column = 0; column < columns; ++column)
+        {
+            matrix(row, column) = random_element<T>(seed);
+        }
+    }
+    return matrix;
+}
+
+template <typename T = double>
+math::DynamicVector<T> random_vector(int length, unsigned seed)
+{
+    math::DynamicVector<T> vector(length);
+    for(int index = 0; index < length; ++index)
+    {
+        vector(index) = random_element<T>(seed);
+    }
+    return vector;
+}
+
+// Runs every test of a fixture with the library's parallel loops on a private pool of three
+// workers, so they split work the same way whatever the machine
+class PooledFixture: public ::testing::Test
+{
+    protected:
+        math::ThreadPool pool{3};
+        math::ScopedExecutor scoped{&pool};
+};
+
+}
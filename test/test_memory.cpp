@@ -0,0 +1,250 @@
+#include "matrix/memory.hpp"
+#include "matrix/dynamic.hpp"
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+
+namespace
+{
+
+bool is_aligned(const void* pointer)
+{
+    return reinterpret_cast<std::uintptr_t>(pointer)%math::default_alignment == 0;
+}
+
+}
+
+TEST(AlignedAllocation, Vector)
+{
+    math::DynamicVectord vector(13);
+    ASSERT_TRUE(is_aligned(vector.data()));
+}
+
+TEST(AlignedAllocation, MatrixRows)
+{
+    math::DynamicMatrixd matrix(5, 40);
+    for(int row = 0; row < matrix.length(); ++row)
+    {
+        ASSERT_TRUE(is_aligned(matrix(row).data()));
+    }
+}
+
+TEST(AlignedAllocation, MatrixContiguous)
+{
+    math::DynamicMatrixf matrix(4, 32);
+    ASSERT_EQ(matrix(1).data(), matrix(0).data() + 32);
+    ASSERT_EQ(matrix(3).data(), matrix(0).data() + 96);
+}
+
+TEST(AlignedAllocation, InitializerListMatrixIsContiguous)
+{
+    math::DynamicMatrixi matrix{{1, 2}, {3, 4}};
+    ASSERT_EQ(matrix(1).data(), matrix(0).data() + math::padded_length<int>(2));
+    ASSERT_EQ(matrix(1)(1), 4);
+}
+
+TEST(AlignedAllocation, PaddedLength)
+{
+    ASSERT_EQ(math::padded_length<double>(8), 8u);
+    ASSERT_EQ(math::padded_length<double>(100), 104u);
+    ASSERT_EQ(math::padded_length<double>(3), 3u);
+}
+
+TEST(ArenaResource, ServesArrays)
+{
+    math::ArenaResource arena(1 << 12);
+    {
+        math::ScopedResource scope(&arena);
+        math::DynamicMatrixd matrix(10, 16);
+        ASSERT_EQ(matrix.resource(), &arena);
+        ASSERT_EQ(matrix(3).resource(), &arena);
+        ASSERT_TRUE(is_aligned(matrix(3).data()));
+        matrix(3)(4) = 2.5;
+        ASSERT_EQ(matrix(3)(4), 2.5);
+    }
+    ASSERT_GT(arena.used_bytes(), 0u);
+    arena.release();
+    ASSERT_EQ(arena.used_bytes(), 0u);
+}
+
+TEST(ArenaResource, LargerThanBlock)
+{
+    math::ArenaResource arena(256);
+    math::DynamicVectord vector(&arena);
+    vector.allocate(1000);
+    vector.fill(1.0);
+    ASSERT_EQ(vector(999), 1.0);
+    ASSERT_TRUE(is_aligned(vector.data()));
+}
+
+TEST(ScopedResource, Restores)
+{
+    std::pmr::memory_resource* previous = math::array_resource();
+    {
+        math::ArenaResource arena;
+        math::ScopedResource scope(&arena);
+        ASSERT_EQ(math::array_resource(), &arena);
+    }
+    ASSERT_EQ(math::array_resource(), previous);
+}
+
+TEST(PoolResource, ReusesBlocks)
+{
+    math::PoolResource pool;
+    const double* first;
+    {
+        math::DynamicVectord vector(&pool);
+        vector.allocate(100);
+        first = vector.data();
+    }
+    math::DynamicVectord vector(&pool);
+    vector.allocate(100);
+    ASSERT_EQ(vector.data(), first);
+    ASSERT_TRUE(is_aligned(vector.data()));
+}
+
+TEST(PoolResource, LargeAllocation)
+{
+    math::PoolResource pool;
+    math::DynamicVectord vector(&pool);
+    vector.allocate(1 << 20);
+    vector(0) = 1.0;
+    vector((1 << 20) - 1) = 2.0;
+    ASSERT_EQ(vector((1 << 20) - 1), 2.0);
+}
+
+TEST(MoveSemantics, MatrixMoveKeepsStorage)
+{
+    math::DynamicMatrixd matrix(3, 8);
+    matrix.fill(1.0);
+    const double* elements = matrix(0).data();
+    math::DynamicMatrixd moved(std::move(matrix));
+    ASSERT_EQ(moved(0).data(), elements);
+    ASSERT_EQ(moved(2)(7), 1.0);
+    ASSERT_EQ(matrix.length(), 0);
+}
+
+TEST(MappedResource, LargeBlocksArePageAlignedAndZero)
+{
+    for(math::HugePages huge_pages : {math::HugePages::No, math::HugePages::Transparent, math::HugePages::Explicit})
+    {
+        math::MappedResource resource(huge_pages, 1 << 16);
+        math::DynamicMatrixd matrix(&resource);
+        matrix.allocate(300, 100);
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(matrix(0).data());
+        ASSERT_EQ(address % math::page_bytes(), 0u);
+        if(huge_pages == math::HugePages::Transparent)
+        {
+            ASSERT_EQ(address % math::huge_page_bytes, 0u);
+        }
+        ASSERT_TRUE(math::allocates_zeroed(&resource, 300*100*sizeof(double)));
+        ASSERT_FALSE(math::allocates_zeroed(&resource, 64));
+        for(int row = 0; row < 300; row += 37)
+        {
+            ASSERT_EQ(matrix(row, 99), 0.0);
+        }
+    }
+}
+
+TEST(MappedResource, DefaultForNewArrays)
+{
+    ASSERT_EQ(math::array_resource(), math::large_page_resource());
+    math::ArenaResource arena;
+    math::set_array_resource(&arena);
+    math::set_array_resource(nullptr);
+    ASSERT_EQ(math::array_resource(), math::large_page_resource());
+}
+
+TEST(ZeroInitialize, LargeAndSmall)
+{
+    math::MappedResource resource(math::HugePages::Transparent, 1 << 16);
+    math::ScopedResource scope(&resource);
+    math::DynamicMatrixd large(math::zero_initialize, 500, 70);
+    math::DynamicMatrixd small(math::zero_initialize, 3, 5);
+    math::DynamicVectord vector(math::zero_initialize, 20000);
+    for(int row = 0; row < 500; ++row)
+    {
+        for(int column = 0; column < 70; ++column)
+        {
+            ASSERT_EQ(large(row, column), 0.0);
+        }
+    }
+    for(int row = 0; row < 3; ++row)
+    {
+        for(int column = 0; column < 5; ++column)
+        {
+            ASSERT_EQ(small(row, column), 0.0);
+        }
+    }
+    for(int index = 0; index < 20000; ++index)
+    {
+        ASSERT_EQ(vector(index), 0.0);
+    }
+}
+
+TEST(ZeroInitialize, FillZeroAfterUse)
+{
+    math::MappedResource resource(math::HugePages::No, 1 << 16);
+    math::DynamicMatrixd matrix(&resource);
+    matrix.allocate(400, 333);
+    matrix.fill(3.0);
+    matrix.fill(0.0);
+    for(int row = 0; row < 400; ++row)
+    {
+        for(int column = 0; column < 333; ++column)
+        {
+            ASSERT_EQ(matrix(row, column), 0.0);
+        }
+    }
+
+    // A row reallocated on its own no longer lies in the block and is filled directly
+    matrix.fill(3.0);
+    matrix(5).allocate(10);
+    matrix(5).fill(4.0);
+    matrix.fill(0.0);
+    ASSERT_EQ(matrix(5, 9), 0.0);
+    ASSERT_EQ(matrix(399, 332), 0.0);
+
+    math::DynamicVectord vector(&resource);
+    vector.allocate(50000);
+    vector.fill(-1.0);
+    vector.fill(-0.0);
+    ASSERT_TRUE(std::signbit(vector(25000)));
+    vector.fill(0.0);
+    ASSERT_EQ(vector(0), 0.0);
+    ASSERT_FALSE(std::signbit(vector(49999)));
+}
+
+TEST(ZeroInitialize, Identity)
+{
+    auto identity = math::Identity<double>(700);
+    for(int row = 0; row < 700; row += 13)
+    {
+        for(int column = 0; column < 700; ++column)
+        {
+            ASSERT_EQ(identity(row, column), row == column ? 1.0 : 0.0);
+        }
+    }
+    math::DynamicMatrixd matrix(20, 20);
+    matrix.fill(5.0);
+    math::fill_identity(matrix);
+    ASSERT_EQ(matrix(3, 3), 1.0);
+    ASSERT_EQ(matrix(3, 4), 0.0);
+}
+
+TEST(Advice, KeepsContents)
+{
+    math::MappedResource resource(math::HugePages::No, 1 << 16);
+    math::DynamicMatrixd matrix(&resource);
+    matrix.allocate(200, 200);
+    matrix.fill(2.0);
+    matrix.advise(math::Advice::Sequential);
+    matrix.advise(math::Advice::WillNeed);
+    matrix.advise(math::Advice::Normal);
+    ASSERT_EQ(matrix(150, 150), 2.0);
+    math::DynamicVectord vector(100);
+    vector.fill(1.0);
+    vector.advise(math::Advice::Random);
+    ASSERT_EQ(vector(99), 1.0);
+}
@@ -27,4 +27,58 @@ TEST(Metric, Norm_OneVectorDynamic)
     math::DynamicVectori one_vector = {1, 1, 1};
     double norm_vector = math::norm(one_vector);
     ASSERT_DOUBLE_EQ(norm_vector, sqrt(3.0));
-}
\ No newline at end of file
+}
+
+TEST(Metric, Norm_DoesNotOverflow)
+{
+    math::DynamicVectord vector = {3e200, 4e200};
+    ASSERT_DOUBLE_EQ(math::norm(vector), 5e200);
+}
+
+TEST(Metric, Norm_DoesNotUnderflow)
+{
+    math::StaticVectord<2> vector = {3e-200, -4e-200};
+    ASSERT_DOUBLE_EQ(math::norm(vector), 5e-200);
+}
+
+TEST(Metric, Norm_Subnormal)
+{
+    math::DynamicVectord vector = {3e-320, 4e-320};
+    ASSERT_NEAR(math::norm(vector), 5e-320, 1e-322);
+}
+
+TEST(Metric, MatrixNorms)
+{
+    math::DynamicMatrixd matrix = {
+        {1.0, -2.0},
+        {-3.0, 4.0}
+    };
+    ASSERT_DOUBLE_EQ(math::norm1(matrix), 6.0);
+    ASSERT_DOUBLE_EQ(math::norm_inf(matrix), 7.0);
+    ASSERT_DOUBLE_EQ(math::frobenius_norm(matrix), sqrt(30.0));
+}
+
+TEST(Metric, VectorNorms)
+{
+    math::StaticVectori<3> vector = {1, -5, 2};
+    ASSERT_DOUBLE_EQ(math::norm1(vector), 8.0);
+    ASSERT_DOUBLE_EQ(math::norm_inf(vector), 5.0);
+}
+
+TEST(Metric, NormAxis)
+{
+    math::DynamicMatrixd matrix = {
+        {3e200, 0.0, 1.0},
+        {4e200, 0.0, -1.0}
+    };
+    auto columns = math::norm(matrix, 0);
+    ASSERT_DOUBLE_EQ(columns(0), 5e200);
+    ASSERT_DOUBLE_EQ(columns(1), 0.0);
+    ASSERT_DOUBLE_EQ(columns(2), sqrt(2.0));
+    auto rows = math::norm(matrix, 1);
+    ASSERT_DOUBLE_EQ(rows(1), 4e200);
+    math::DynamicVectord column_sums = {7e200, 0.0, 2.0};
+    ASSERT_TRUE(math::all_equal(math::norm1(matrix, 0), column_sums));
+    math::DynamicVectord row_maxima = {3e200, 4e200};
+    ASSERT_TRUE(math::all_equal(math::norm_inf(matrix, 1), row_maxima));
+}
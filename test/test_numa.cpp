@@ -0,0 +1,113 @@
+#include "matrix/numa.hpp"
+#include "matrix/dynamic.hpp"
+#include "matrix/reductions.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+TEST(Numa, ParsesIdLists)
+{
+    std::vector<int> expected{0, 1, 2, 3, 8, 10, 11};
+    ASSERT_EQ(math::parse_id_list("0-3,8,10-11\n"), expected);
+    ASSERT_EQ(math::parse_id_list("5"), std::vector<int>{5});
+    ASSERT_TRUE(math::parse_id_list("").empty());
+}
+
+TEST(Numa, TopologyHasAtLeastOneNode)
+{
+    ASSERT_GE(math::num_numa_nodes(), 1);
+    ASSERT_FALSE(math::numa_node_cpus(math::numa_nodes()[0]).empty());
+    const std::vector<int>& cpus = math::spread_cpus();
+    ASSERT_FALSE(cpus.empty());
+    std::vector<int> sorted(cpus);
+    std::sort(sorted.begin(), sorted.end());
+    ASSERT_TRUE(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+}
+
+TEST(Numa, PinsThread)
+{
+    bool pinned = false;
+    std::thread thread([&]{ pinned = math::pin_current_thread(math::spread_cpus()[0]); });
+    thread.join();
+    ASSERT_TRUE(pinned);
+    ASSERT_FALSE(math::pin_current_thread(-1));
+}
+
+class NumaFixture: public ::testing::TestWithParam<math::NumaPolicy>
+{
+};
+
+TEST_P(NumaFixture, LargeArraysStartZeroed)
+{
+    math::NumaResource resource(GetParam(), 1 << 16);
+    math::ThreadPool pool(3, math::ThreadPool::Pinning::Cores);
+    math::ScopedExecutor executor(&pool);
+    math::DynamicMatrix<double> matrix(&resource);
+    matrix.allocate(300, 200);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(&matrix(0,0)) % math::default_alignment, 0u);
+    ASSERT_EQ(math::sum(matrix), 0.0);
+    matrix.fill(1.5);
+    ASSERT_EQ(math::sum(matrix), 1.5*300*200);
+
+    math::DynamicVector<float> vector(&resource);
+    vector.allocate(100000);
+    ASSERT_EQ(math::max(vector), 0.0f);
+
+    math::DynamicMatrix<double> small(&resource);
+    small.allocate(4, 4);
+    small.fill(2.0);
+    ASSERT_EQ(math::sum(small), 32.0);
+}
+
+#ifdef __linux__
+// Whether every whole page of a block is resident
+static bool pages_resident(const void* block, std::size_t bytes)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    auto address = reinterpret_cast<std::uintptr_t>(block);
+    std::uintptr_t first = (address + page - 1)/page*page;
+    std::uintptr_t last = (address + bytes)/page*page;
+    std::vector<unsigned char> resident((last - first)/page);
+    if(mincore(reinterpret_cast<void*>(first), last - first, resident.data()) != 0)
+    {
+        return false;
+    }
+    return std::all_of(resident.begin(), resident.end(), [](unsigned char flags) { return flags & 1; });
+}
+
+TEST(Numa, FirstTouchWritesVectorPages)
+{
+    math::NumaResource resource(math::NumaPolicy::FirstTouch, 1 << 16);
+    math::DynamicVector<double> vector(&resource);
+    vector.allocate(1 << 16);
+    // Every whole page must be resident, placed by the thread that wrote it
+    ASSERT_TRUE(pages_resident(&vector(0), vector.length()*sizeof(double)));
+}
+
+TEST(Numa, FirstTouchZeroFillKeepsPages)
+{
+    math::NumaResource resource(math::NumaPolicy::FirstTouch, 1 << 16);
+    math::DynamicMatrix<double> matrix(&resource);
+    matrix.allocate(300, 200);
+    matrix.fill(1.5);
+    matrix.fill(0.0);
+    ASSERT_TRUE(pages_resident(&matrix(0,0), 300*200*sizeof(double)));
+    ASSERT_EQ(math::sum(matrix), 0.0);
+
+    math::DynamicVector<double> vector(&resource);
+    vector.allocate(1 << 16);
+    vector.fill(1.5);
+    vector.fill(0.0);
+    ASSERT_TRUE(pages_resident(&vector(0), vector.length()*sizeof(double)));
+    ASSERT_EQ(math::sum(vector), 0.0);
+}
+#endif
+
+INSTANTIATE_TEST_SUITE_P(Policies, NumaFixture, ::testing::Values(math::NumaPolicy::FirstTouch, math::NumaPolicy::Interleave));
@@ -244,4 +244,230 @@ TEST_F(DynamicOperatorFixture, InPlaceDivision)
     ASSERT_EQ(vector(0), a/a);
     ASSERT_EQ(vector(1), a/a);
     ASSERT_EQ(vector(2), a/a);
-}
\ No newline at end of file
+}
+
+class BroadcastFixture: public ::testing::Test
+{
+    protected:
+        math::DynamicMatrixi dynamic_matrix = {
+            {1, 2, 3},
+            {4, 5, 6}
+        };
+        math::DynamicVectori dynamic_bias = {10, 20, 30};
+        math::DynamicMatrixi dynamic_column = {
+            {100},
+            {200}
+        };
+        math::StaticArrayi<2,3> static_matrix = {
+            {1, 2, 3},
+            {4, 5, 6}
+        };
+        math::StaticVectori<3> static_bias = {10, 20, 30};
+        math::StaticArrayi<2,1> static_column = {
+            {100},
+            {200}
+        };
+};
+
+TEST_F(BroadcastFixture, DynamicMatrixPlusRowVector)
+{
+    math::DynamicMatrixi answer = {
+        {11, 22, 33},
+        {14, 25, 36}
+    };
+    ASSERT_TRUE(math::all_equal(dynamic_matrix + dynamic_bias, answer));
+    ASSERT_TRUE(math::all_equal(dynamic_bias + dynamic_matrix, answer));
+}
+
+TEST_F(BroadcastFixture, DynamicMatrixMinusColumn)
+{
+    math::DynamicMatrixi answer = {
+        {-99, -98, -97},
+        {-196, -195, -194}
+    };
+    ASSERT_TRUE(math::all_equal(dynamic_matrix - dynamic_column, answer));
+}
+
+TEST_F(BroadcastFixture, DynamicColumnTimesRow)
+{
+    math::DynamicMatrixi product = math::multiply(dynamic_column, dynamic_bias);
+    math::DynamicMatrixi answer = {
+        {1000, 2000, 3000},
+        {2000, 4000, 6000}
+    };
+    ASSERT_TRUE(math::all_equal(product, answer));
+}
+
+TEST_F(BroadcastFixture, DynamicMismatchThrows)
+{
+    math::DynamicVectori wrong_length = {1, 2};
+    ASSERT_THROW(dynamic_matrix + wrong_length, math::MismatchedLength);
+}
+
+TEST_F(BroadcastFixture, StaticMatrixPlusRowVector)
+{
+    auto summed = static_matrix + static_bias;
+    bool is_same = math::is_same<decltype(summed), math::StaticArrayi<2,3>>::value;
+    ASSERT_TRUE(is_same);
+    math::StaticArrayi<2,3> answer = {
+        {11, 22, 33},
+        {14, 25, 36}
+    };
+    ASSERT_TRUE(math::all_equal(summed, answer));
+}
+
+TEST_F(BroadcastFixture, StaticColumnDividedByRow)
+{
+    auto divided = static_column / static_bias;
+    bool is_same = math::is_same<decltype(divided), math::StaticArrayi<2,3>>::value;
+    ASSERT_TRUE(is_same);
+    math::StaticArrayi<2,3> answer = {
+        {10, 5, 3},
+        {20, 10, 6}
+    };
+    ASSERT_TRUE(math::all_equal(divided, answer));
+}
+
+TEST_F(BroadcastFixture, Comparisons)
+{
+    math::StaticVectori<3> threshold = {2, 5, 3};
+    math::StaticArray<bool,2,3> greater = static_matrix > threshold;
+    math::StaticArray<bool,2,3> answer = {
+        {false, false, false},
+        {true, false, true}
+    };
+    ASSERT_TRUE(math::all_equal(greater, answer));
+    ASSERT_TRUE(math::all(static_matrix <= static_matrix));
+    math::DynamicMatrix<bool> equal = (dynamic_matrix == dynamic_matrix(0));
+    ASSERT_TRUE(equal(0,2));
+    ASSERT_FALSE(equal(1,0));
+}
+
+class CompoundAssignmentFixture: public ::testing::Test
+{
+    protected:
+        math::DynamicMatrixd dynamic_matrix = {
+            {1.0, 2.0, 3.0},
+            {4.0, 5.0, 6.0}
+        };
+        math::DynamicVectord dynamic_row = {1.0, 2.0, 4.0};
+        math::StaticArrayd<2,3> static_matrix = {
+            {1.0, 2.0, 3.0},
+            {4.0, 5.0, 6.0}
+        };
+        math::StaticArrayd<2,1> static_column = {
+            {1.0},
+            {2.0}
+        };
+};
+
+TEST_F(CompoundAssignmentFixture, DynamicPlusEqualsMatrix)
+{
+    math::DynamicMatrixd answer = {
+        {2.0, 4.0, 6.0},
+        {8.0, 10.0, 12.0}
+    };
+    auto copy = dynamic_matrix;
+    dynamic_matrix += copy;
+    ASSERT_TRUE(math::all_equal(dynamic_matrix, answer));
+}
+
+TEST_F(CompoundAssignmentFixture, DynamicMinusEqualsBroadcastRow)
+{
+    math::DynamicMatrixd answer = {
+        {0.0, 0.0, -1.0},
+        {3.0, 3.0, 2.0}
+    };
+    dynamic_matrix -= dynamic_row;
+    ASSERT_TRUE(math::all_equal(dynamic_matrix, answer));
+}
+
+TEST_F(CompoundAssignmentFixture, DynamicDivideEqualsBroadcastRow)
+{
+    math::DynamicMatrixd answer = {
+        {1.0, 1.0, 0.75},
+        {4.0, 2.5, 1.5}
+    };
+    dynamic_matrix /= dynamic_row;
+    ASSERT_TRUE(math::all_equal(dynamic_matrix, answer));
+}
+
+TEST_F(CompoundAssignmentFixture, DynamicShapeMustNotGrow)
+{
+    math::DynamicMatrixd column = {
+        {1.0},
+        {2.0}
+    };
+    ASSERT_THROW(column += dynamic_matrix, math::MismatchedLength);
+}
+
+TEST_F(CompoundAssignmentFixture, OwnRowIsReadBeforeWrites)
+{
+    math::DynamicMatrixd matrix = {
+        {1.0, 1.0},
+        {2.0, 2.0},
+        {3.0, 3.0}
+    };
+    math::DynamicMatrixd added = {
+        {2.0, 2.0},
+        {3.0, 3.0},
+        {4.0, 4.0}
+    };
+    matrix += matrix(0);
+    ASSERT_TRUE(math::all_equal(matrix, added));
+    math::DynamicMatrixd subtracted = {
+        {0.0, 0.0},
+        {1.0, 1.0},
+        {2.0, 2.0}
+    };
+    matrix -= matrix(0);
+    ASSERT_TRUE(math::all_equal(matrix, subtracted));
+    math::StaticArrayd<2,3> static_answer = {
+        {0.0, 0.0, 0.0},
+        {3.0, 3.0, 3.0}
+    };
+    static_matrix -= static_matrix(0);
+    ASSERT_TRUE(math::all_equal(static_matrix, static_answer));
+}
+
+TEST_F(CompoundAssignmentFixture, StaticPlusEqualsColumn)
+{
+    math::StaticArrayd<2,3> answer = {
+        {2.0, 3.0, 4.0},
+        {6.0, 7.0, 8.0}
+    };
+    static_matrix += static_column;
+    ASSERT_TRUE(math::all_equal(static_matrix, answer));
+}
+
+TEST_F(CompoundAssignmentFixture, ScalarUpdates)
+{
+    math::StaticArrayd<2,3> answer = {
+        {3.0, 5.0, 7.0},
+        {9.0, 11.0, 13.0}
+    };
+    static_matrix *= 2.0;
+    static_matrix += 2.0;
+    static_matrix -= 1.0;
+    ASSERT_TRUE(math::all_equal(static_matrix, answer));
+    dynamic_matrix *= 2.0;
+    ASSERT_DOUBLE_EQ(dynamic_matrix(1,2), 12.0);
+}
+
+TEST_F(CompoundAssignmentFixture, MultiplyInPlace)
+{
+    math::DynamicMatrixd answer = {
+        {1.0, 4.0, 12.0},
+        {4.0, 10.0, 24.0}
+    };
+    math::multiply(dynamic_matrix, dynamic_row, dynamic_matrix);
+    ASSERT_TRUE(math::all_equal(dynamic_matrix, answer));
+}
+
+TEST_F(CompoundAssignmentFixture, ChainedReturnsReference)
+{
+    math::DynamicVectord vector = {2.0, 4.0};
+    (vector /= 2.0) *= 3.0;
+    ASSERT_DOUBLE_EQ(vector(0), 3.0);
+    ASSERT_DOUBLE_EQ(vector(1), 6.0);
+}
@@ -0,0 +1,173 @@
+#include "matrix/out_of_core.hpp"
+#include "matrix/decompositions.hpp"
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+using test_helpers::random_matrix;
+
+class OutOfCoreFixture: public ::testing::Test
+{
+    protected:
+        std::filesystem::path directory;
+
+        void SetUp() override
+        {
+            directory = std::filesystem::temp_directory_path() / ("matrix_out_of_core_" + std::to_string(getpid()));
+            std::filesystem::create_directories(directory);
+        }
+
+        void TearDown() override
+        {
+            std::filesystem::remove_all(directory);
+        }
+
+        std::string path(const std::string& name) const
+        {
+            return (directory / name).string();
+        }
+
+        static std::size_t tiles(int count, int tile_size)
+        {
+            return count*tile_size*math::padded_length<double>(tile_size)*sizeof(double);
+        }
+
+        static double max_difference(const math::DynamicMatrix<double>& left, const math::DynamicMatrix<double>& right)
+        {
+            double difference = 0;
+            for(int row = 0; row < left.length(); ++row)
+            {
+                for(int column = 0; column < left(row).length(); ++column)
+                {
+                    difference = std::max(difference, std::abs(left(row, column) - right(row, column)));
+                }
+            }
+            return difference;
+        }
+};
+
+TEST_F(OutOfCoreFixture, SaveAndLoad)
+{
+    auto matrix = random_matrix(5, 7, 1);
+    math::save(path("a.bin"), matrix);
+    ASSERT_EQ(std::filesystem::file_size(path("a.bin")), 5*7*sizeof(double));
+    ASSERT_TRUE(math::all_equal(math::load<double>(path("a.bin"), 5, 7), matrix));
+
+    math::MatrixFile<double> file(path("a.bin"), 5, 7);
+    math::DynamicMatrix<double> block(2, 3);
+    file.read(3, 4, block);
+    ASSERT_EQ(block(1, 2), matrix(4, 6));
+    math::DynamicMatrix<double> too_wide(2, 4);
+    ASSERT_THROW(file.read(3, 4, too_wide), math::OutOfRange);
+    ASSERT_THROW(math::MatrixFile<double>(path("missing.bin"), 1, 1, math::MatrixFile<double>::Mode::Read), math::FileError);
+}
+
+TEST_F(OutOfCoreFixture, MultiplyWithinBudget)
+{
+    auto A = random_matrix(37, 53, 2);
+    auto B = random_matrix(53, 29, 3);
+    math::save(path("a.bin"), A);
+    math::save(path("b.bin"), B);
+    {
+        math::MatrixFile<double> a(path("a.bin"), 37, 53, math::MatrixFile<double>::Mode::Read);
+        math::MatrixFile<double> b(path("b.bin"), 53, 29, math::MatrixFile<double>::Mode::Read);
+        math::MatrixFile<double> c(path("c.bin"), 37, 29, math::MatrixFile<double>::Mode::Create);
+        math::TileCache<double> cache(8, tiles(5, 8));
+        math::out_of_core_multiply(a, b, c, cache);
+        ASSERT_LE(cache.peak_bytes(), cache.budget_bytes());
+    }
+    ASSERT_LT(max_difference(math::load<double>(path("c.bin"), 37, 29), A*B), 1e-12);
+}
+
+TEST_F(OutOfCoreFixture, BudgetTooSmall)
+{
+    math::save(path("a.bin"), random_matrix(16, 16, 4));
+    math::MatrixFile<double> a(path("a.bin"), 16, 16);
+    math::MatrixFile<double> c(path("c.bin"), 16, 16, math::MatrixFile<double>::Mode::Create);
+    math::TileCache<double> cache(8, tiles(2, 8));
+    ASSERT_THROW(math::out_of_core_multiply(a, a, c, cache), math::InsufficientMemory);
+}
+
+TEST_F(OutOfCoreFixture, CacheOutlivesFiles)
+{
+    // The handles in the loop share an address, so a cache keyed by it would return the
+    // first file's tiles for the second
+    math::TileCache<double> cache(8, tiles(12, 8));
+    auto B = random_matrix(16, 16, 6);
+    math::save(path("b.bin"), B);
+    for(unsigned seed : {7u, 8u})
+    {
+        auto A = random_matrix(16, 16, seed);
+        math::save(path("a.bin"), A);
+        {
+            math::MatrixFile<double> a(path("a.bin"), 16, 16, math::MatrixFile<double>::Mode::Read);
+            math::MatrixFile<double> b(path("b.bin"), 16, 16, math::MatrixFile<double>::Mode::Read);
+            math::MatrixFile<double> c(path("c.bin"), 16, 16, math::MatrixFile<double>::Mode::Create);
+            math::out_of_core_multiply(a, b, c, cache);
+        }
+        ASSERT_LT(max_difference(math::load<double>(path("c.bin"), 16, 16), A*B), 1e-12);
+    }
+}
+
+TEST_F(OutOfCoreFixture, CholeskyMatchesInMemory)
+{
+    int N = 45;
+    auto R = random_matrix(N, N, 5);
+    math::DynamicMatrix<double> A(N, N);
+    math::gemm(1.0, R, math::Transpose::Yes, R, math::Transpose::No, 0.0, A);
+    for(int index = 0; index < N; ++index)
+    {
+        A(index, index) += N;
+    }
+    math::save(path("a.bin"), A);
+    {
+        math::MatrixFile<double> file(path("a.bin"), N, N);
+        math::TileCache<double> cache(8, tiles(4, 8));
+        math::out_of_core_cholesky(file, cache);
+        ASSERT_LE(cache.peak_bytes(), cache.budget_bytes());
+    }
+    math::DynamicCholeskyDecomposition<double> expected(A);
+    ASSERT_LT(max_difference(math::load<double>(path("a.bin"), N, N), expected.cholesky), 1e-10);
+}
+
+TEST_F(OutOfCoreFixture, LUReconstructsPermutedMatrix)
+{
+    int N = 41;
+    auto A = random_matrix(N, N, 6);
+    math::save(path("a.bin"), A);
+    std::vector<int> pivots;
+    {
+        math::MatrixFile<double> file(path("a.bin"), N, N);
+        math::TileCache<double> cache(8, tiles(8, 8));
+        pivots = math::out_of_core_lu(file, cache);
+        ASSERT_LE(cache.peak_bytes(), cache.budget_bytes());
+    }
+    auto packed = math::load<double>(path("a.bin"), N, N);
+    math::DynamicMatrix<double> L(N, N);
+    math::DynamicMatrix<double> U(N, N);
+    for(int row = 0; row < N; ++row)
+    {
+        for(int column = 0; column < N; ++column)
+        {
+            L(row, column) = column < row ? packed(row, column) : (column == row ? 1.0 : 0.0);
+            U(row, column) = column >= row ? packed(row, column) : 0.0;
+        }
+    }
+    auto permuted = A;
+    for(int row = 0; row < N; ++row)
+    {
+        for(int column = 0; column < N; ++column)
+        {
+            std::swap(permuted(row, column), permuted(pivots[row], column));
+        }
+    }
+    ASSERT_LT(max_difference(L*U, permuted), 1e-12);
+
+    auto in_memory = math::tiled_lu(A, 8, 1);
+    ASSERT_LT(max_difference(U, in_memory.U), 1e-12);
+}
@@ -0,0 +1,191 @@
+#include "matrix/decompositions.hpp"
+#include "matrix/packed.hpp"
+#include "matrix/products.hpp"
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <complex>
+
+using test_helpers::random_entry;
+using test_helpers::random_matrix;
+using test_helpers::random_vector;
+
+class PackedFixture: public test_helpers::PooledFixture
+{
+    protected:
+        // Symmetric, with n added on the diagonal to make it positive definite
+        static math::DynamicMatrix<double> random_spd(int n, unsigned seed)
+        {
+            math::DynamicMatrix<double> matrix = random_matrix(n, n, seed);
+            for(int row = 0; row < n; ++row)
+            {
+                for(int column = 0; column < row; ++column)
+                {
+                    matrix(row, column) = matrix(column, row);
+                }
+                matrix(row, row) += n;
+            }
+            return matrix;
+        }
+};
+
+TEST_F(PackedFixture, PackUnpackRoundTrip)
+{
+    int n = 7;
+    math::DynamicMatrix<double> A = random_matrix(n, n, 1);
+    math::PackedTriangular<double> upper = math::pack(A, math::Triangle::Upper);
+    math::PackedTriangular<double> lower = math::pack(A, math::Triangle::Lower);
+    ASSERT_EQ(upper.size(), 28u);
+    ASSERT_EQ(lower.size(), 28u);
+    math::DynamicMatrix<double> upper_full = math::unpack(upper);
+    math::DynamicMatrix<double> lower_full = math::unpack(lower);
+    math::DynamicMatrix<double> expected_upper = math::triu(A);
+    math::DynamicMatrix<double> expected_lower = math::tril(A);
+    math::DynamicMatrix<double> symmetric = math::unpack(math::pack_symmetric(A));
+    for(int row = 0; row < n; ++row)
+    {
+        for(int column = 0; column < n; ++column)
+        {
+            ASSERT_EQ(upper_full(row, column), expected_upper(row, column));
+            ASSERT_EQ(lower_full(row, column), expected_lower(row, column));
+            ASSERT_EQ(symmetric(row, column), column >= row ? A(row, column) : A(column, row));
+        }
+    }
+}
+
+TEST_F(PackedFixture, PackedSizeDoesNotOverflow)
+{
+    ASSERT_EQ(math::packed_size(50000), 1250025000u);
+    ASSERT_EQ(math::packed_size(100000), 5000050000u);
+}
+
+TEST_F(PackedFixture, TriangularGemvMatchesDense)
+{
+    int n = 300;
+    math::DynamicMatrix<double> A = random_matrix(n, n, 2);
+    math::DynamicVector<double> x = random_vector(n, 3);
+    math::DynamicVector<double> y0 = random_vector(n, 4);
+    for(math::Triangle triangle : {math::Triangle::Upper, math::Triangle::Lower})
+    {
+        math::PackedTriangular<double> packed = math::pack(A, triangle);
+        math::DynamicMatrix<double> dense = math::unpack(packed);
+        for(math::Transpose transpose : {math::Transpose::No, math::Transpose::Yes})
+        {
+            math::DynamicVector<double> expected(y0);
+            math::DynamicVector<double> y(y0);
+            math::gemv(2.0, dense, transpose, x, 0.5, expected);
+            math::gemv(2.0, packed, transpose, x, 0.5, y);
+            for(int index = 0; index < n; ++index)
+            {
+                ASSERT_NEAR(y(index), expected(index), 1e-12);
+            }
+        }
+    }
+}
+
+TEST_F(PackedFixture, SymmetricGemvMatchesDense)
+{
+    int n = 300;
+    math::DynamicMatrix<double> A = random_spd(n, 5);
+    math::DynamicVector<double> x = random_vector(n, 6);
+    math::DynamicVector<double> expected = A*x;
+    math::DynamicVector<double> y = math::pack_symmetric(A)*x;
+    for(int index = 0; index < n; ++index)
+    {
+        ASSERT_NEAR(y(index), expected(index), 1e-10);
+    }
+}
+
+TEST_F(PackedFixture, TriangularSolve)
+{
+    int n = 60;
+    math::DynamicMatrix<double> A = random_matrix(n, n, 7);
+    for(int index = 0; index < n; ++index)
+    {
+        A(index, index) += n;
+    }
+    math::DynamicVector<double> b = random_vector(n, 8);
+    for(math::Triangle triangle : {math::Triangle::Upper, math::Triangle::Lower})
+    {
+        math::PackedTriangular<double> packed = math::pack(A, triangle);
+        for(math::Transpose transpose : {math::Transpose::No, math::Transpose::Yes})
+        {
+            math::DynamicVector<double> x = math::triangular_solve(packed, transpose, b);
+            math::DynamicVector<double> residual(b);
+            math::gemv(1.0, packed, transpose, x, -1.0, residual);
+            for(int index = 0; index < n; ++index)
+            {
+                ASSERT_NEAR(residual(index), 0.0, 1e-12);
+            }
+        }
+    }
+}
+
+TEST_F(PackedFixture, CholeskyMatchesDenseFactor)
+{
+    int n = 200;
+    math::DynamicMatrix<double> A = random_spd(n, 9);
+    math::DynamicVector<double> b = random_vector(n, 10);
+    math::DynamicCholeskyDecomposition<double> dense(A);
+    math::PackedCholeskyDecomposition<double> packed(math::pack_symmetric(A));
+    for(int row = 0; row < n; ++row)
+    {
+        for(int column = row; column < n; ++column)
+        {
+            ASSERT_NEAR(packed.cholesky(row, column), dense.cholesky(row, column), 1e-12);
+        }
+    }
+    math::DynamicVector<double> x = math::solve(packed, b);
+    math::DynamicVector<double> expected = math::solve(dense, b);
+    for(int index = 0; index < n; ++index)
+    {
+        ASSERT_NEAR(x(index), expected(index), 1e-12);
+    }
+}
+
+TEST_F(PackedFixture, CholeskyRejectsIndefinite)
+{
+    math::DynamicMatrix<double> A = random_spd(5, 11);
+    A(3, 3) = -100.0;
+    try
+    {
+        math::PackedCholeskyDecomposition<double> packed(math::pack_symmetric(A));
+        FAIL();
+    }
+    catch(const math::NotPositiveDefinite&)
+    {
+    }
+}
+
+TEST_F(PackedFixture, HermitianCholeskySolves)
+{
+    using complexd = std::complex<double>;
+    int n = 40;
+    unsigned seed = 12;
+    math::DynamicMatrix<complexd> A(n, n);
+    for(int row = 0; row < n; ++row)
+    {
+        for(int column = row; column < n; ++column)
+        {
+            double real = random_entry(seed);
+            A(row, column) = row == column ? complexd(real + n, 0.0) : complexd(real, random_entry(seed));
+            A(column, row) = std::conj(A(row, column));
+        }
+    }
+    math::DynamicVector<complexd> b(n);
+    for(int index = 0; index < n; ++index)
+    {
+        double real = random_entry(seed);
+        b(index) = complexd(real, random_entry(seed));
+    }
+    math::PackedSymmetric<complexd> packed = math::pack_symmetric(A);
+    math::DynamicVector<complexd> x = math::solve(math::PackedCholeskyDecomposition<complexd>(packed), b);
+    math::DynamicVector<complexd> product = packed*x;
+    math::DynamicVector<complexd> dense_product = A*x;
+    for(int index = 0; index < n; ++index)
+    {
+        ASSERT_NEAR(std::abs(product(index) - b(index)), 0.0, 1e-12);
+        ASSERT_NEAR(std::abs(dense_product(index) - b(index)), 0.0, 1e-12);
+    }
+}
@@ -0,0 +1,231 @@
+#include "matrix/parallel.hpp"
+#include "matrix/dynamic.hpp"
+#include "matrix/indexing.hpp"
+#include "matrix/operators.hpp"
+#include "matrix/products.hpp"
+#include "matrix/reductions.hpp"
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using test_helpers::random_matrix;
+
+// Forwards to a pool and counts the parallel loops it was given
+class CountingExecutor: public math::Executor
+{
+    public:
+        math::ThreadPool pool{3};
+        std::atomic<int> num_runs{0};
+
+        int concurrency() const override
+        {
+            return pool.concurrency();
+        }
+
+        void run(int num_chunks, const std::function<void(int)>& chunk) override
+        {
+            ++num_runs;
+            pool.run(num_chunks, chunk);
+        }
+};
+
+class ParallelFixture: public ::testing::Test
+{
+    protected:
+        math::ThreadPool pool{3};
+        math::SerialExecutor serial;
+};
+
+TEST_F(ParallelFixture, ParallelForCoversRangeOnce)
+{
+    math::ScopedExecutor scoped(&pool);
+    std::vector<std::atomic<int>> visits(100003);
+    math::parallel_for(3, 100003, 1000, [&](int begin, int end)
+    {
+        ASSERT_LE(end - begin, 100000);
+        for(int index = begin; index < end; ++index)
+        {
+            ++visits[index];
+        }
+    });
+    for(int index = 0; index < 100003; ++index)
+    {
+        ASSERT_EQ(visits[index].load(), index < 3 ? 0 : 1);
+    }
+}
+
+TEST_F(ParallelFixture, NestedLoopsFinish)
+{
+    math::ScopedExecutor scoped(&pool);
+    std::atomic<long long> total{0};
+    math::parallel_for(0, 64, 1, [&](int begin, int end)
+    {
+        for(int outer = begin; outer < end; ++outer)
+        {
+            math::parallel_for(0, 1000, 10, [&](int inner_begin, int inner_end)
+            {
+                total += inner_end - inner_begin;
+            });
+        }
+    });
+    ASSERT_EQ(total.load(), 64000);
+}
+
+TEST_F(ParallelFixture, WaitingCallerSleeps)
+{
+    auto cpu_seconds = []
+    {
+        timespec time;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+        return time.tv_sec + time.tv_nsec*1e-9;
+    };
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<bool> helped{false};
+    double start = cpu_seconds();
+    pool.run(2, [&](int)
+    {
+        if(std::this_thread::get_id() != caller)
+        {
+            helped = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            return;
+        }
+        for(int attempt = 0; attempt < 100 && !helped; ++attempt)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+    ASSERT_TRUE(helped);
+    ASSERT_LT(cpu_seconds() - start, 0.1);
+}
+
+TEST_F(ParallelFixture, ExceptionReachesCaller)
+{
+    math::ScopedExecutor scoped(&pool);
+    ASSERT_THROW(math::parallel_for(0, 1000, 1, [](int begin, int)
+    {
+        if(begin >= 500)
+        {
+            throw std::runtime_error("chunk failed");
+        }
+    }), std::runtime_error);
+}
+
+TEST_F(ParallelFixture, ReduceIsDeterministic)
+{
+    std::vector<float> values(1000000);
+    for(int index = 0; index < static_cast<int>(values.size()); ++index)
+    {
+        values[index] = std::sin(0.001f*index);
+    }
+    auto reduce = [&]
+    {
+        return math::parallel_reduce(0, static_cast<int>(values.size()), 4096, 0.0f, [&](int begin, int end)
+        {
+            float partial = 0;
+            for(int index = begin; index < end; ++index)
+            {
+                partial += values[index];
+            }
+            return partial;
+        }, [](float left, float right) { return left + right; });
+    };
+    float parallel_result;
+    {
+        math::ScopedExecutor scoped(&pool);
+        parallel_result = reduce();
+    }
+    math::ScopedExecutor scoped(&serial);
+    ASSERT_EQ(parallel_result, reduce());
+}
+
+TEST_F(ParallelFixture, AdoptsCallerExecutor)
+{
+    CountingExecutor executor;
+    math::ScopedExecutor scoped(&executor);
+    math::DynamicMatrix<double> matrix(512, 512);
+    matrix.fill(2.0);
+    ASSERT_GT(executor.num_runs.load(), 0);
+    ASSERT_EQ(math::sum(matrix), 2.0*512*512);
+
+    math::DynamicMatrix<double> small(8, 8);
+    int runs = executor.num_runs.load();
+    small.fill(1.0);
+    ASSERT_EQ(executor.num_runs.load(), runs);
+}
+
+TEST_F(ParallelFixture, LargeOperationsMatchSerial)
+{
+    auto A = random_matrix(300, 400, 1);
+    auto B = random_matrix(400, 250, 2);
+    auto row = random_matrix(1, 400, 3);
+    math::DynamicVector<double> x(400);
+    for(int index = 0; index < 400; ++index)
+    {
+        x(index) = A(7, index);
+    }
+
+    auto compute = [&]
+    {
+        math::DynamicMatrix<double> C(300, 250);
+        C.fill(1.0);
+        math::gemm(0.5, A, B, 2.0, C);
+        math::DynamicMatrix<double> D(400, 400);
+        math::gemm(1.0, A, math::Transpose::Yes, A, math::Transpose::No, 0.0, D);
+        math::DynamicVector<double> y(300);
+        math::gemv(1.0, A, x, 0.0, y);
+        math::DynamicVector<double> z(400);
+        math::gemv(1.0, A, math::Transpose::Yes, y, 0.0, z);
+        auto shifted = A + row;
+        shifted *= 3.0;
+        auto upper = math::triu(D);
+        auto identity = math::Identity<double>(400);
+        return std::make_tuple(C, D, z, shifted, upper, identity, math::sum(A), math::argmax(D), math::sum(A, 1), math::max(D, 1));
+    };
+
+    decltype(compute()) parallel_results;
+    {
+        math::ScopedExecutor scoped(&pool);
+        parallel_results = compute();
+    }
+    math::ScopedExecutor scoped(&serial);
+    auto serial_results = compute();
+    ASSERT_TRUE(math::all_equal(std::get<0>(parallel_results), std::get<0>(serial_results)));
+    ASSERT_TRUE(math::all_equal(std::get<1>(parallel_results), std::get<1>(serial_results)));
+    ASSERT_TRUE(math::all_equal(std::get<2>(parallel_results), std::get<2>(serial_results)));
+    ASSERT_TRUE(math::all_equal(std::get<3>(parallel_results), std::get<3>(serial_results)));
+    ASSERT_TRUE(math::all_equal(std::get<4>(parallel_results), std::get<4>(serial_results)));
+    ASSERT_TRUE(math::all_equal(std::get<5>(parallel_results), std::get<5>(serial_results)));
+    ASSERT_EQ(std::get<6>(parallel_results), std::get<6>(serial_results));
+    ASSERT_EQ(std::get<7>(parallel_results), std::get<7>(serial_results));
+    ASSERT_TRUE(math::all_equal(std::get<8>(parallel_results), std::get<8>(serial_results)));
+    ASSERT_TRUE(math::all_equal(std::get<9>(parallel_results), std::get<9>(serial_results)));
+}
+
+TEST_F(ParallelFixture, LongVectorReductions)
+{
+    math::DynamicVector<double> values(200000);
+    for(int index = 0; index < values.length(); ++index)
+    {
+        values(index) = std::cos(0.01*index);
+    }
+    values(123456) = 5.0;
+    values(190000) = 5.0;
+    double serial_sum;
+    {
+        math::ScopedExecutor scoped(&serial);
+        serial_sum = math::sum(values);
+    }
+    math::ScopedExecutor scoped(&pool);
+    ASSERT_EQ(math::sum(values), serial_sum);
+    ASSERT_EQ(math::argmax(values), 123456);
+    ASSERT_EQ(math::max(values), 5.0);
+}
@@ -0,0 +1,181 @@
+#include "matrix/pipeline.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+class PipelineFixture: public ::testing::Test
+{
+    protected:
+        std::filesystem::path directory;
+        math::DynamicMatrix<double> W{5, 7};
+
+        void SetUp() override
+        {
+            directory = std::filesystem::temp_directory_path() / ("matrix_pipeline_" + std::to_string(getpid()));
+            std::filesystem::create_directories(directory);
+            for(int row = 0; row < 5; ++row)
+            {
+                for(int column = 0; column < 7; ++column)
+                {
+                    W(row, column) = std::sin(row + 0.3*column);
+                }
+            }
+        }
+
+        void TearDown() override
+        {
+            std::filesystem::remove_all(directory);
+        }
+
+        std::string path(const std::string& name) const
+        {
+            return (directory / name).string();
+        }
+
+        static double input(long long vector, int index)
+        {
+            return std::cos(0.01*vector + index);
+        }
+
+        // Writes num_vectors inputs of width 7 followed by extra_bytes stray bytes
+        void write_inputs(const std::string& name, int num_vectors, int extra_bytes = 0)
+        {
+            std::vector<double> values;
+            for(int vector = 0; vector < num_vectors; ++vector)
+            {
+                for(int index = 0; index < 7; ++index)
+                {
+                    values.push_back(input(vector, index));
+                }
+            }
+            int descriptor = ::open(path(name).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            ASSERT_GE(descriptor, 0);
+            ASSERT_EQ(::write(descriptor, values.data(), values.size()*sizeof(double)), static_cast<ssize_t>(values.size()*sizeof(double)));
+            std::vector<char> extra(extra_bytes);
+            ASSERT_EQ(::write(descriptor, extra.data(), extra.size()), extra_bytes);
+            ::close(descriptor);
+        }
+
+        double expected(long long vector, int row) const
+        {
+            double value = 0;
+            for(int index = 0; index < 7; ++index)
+            {
+                value += W(row, index)*input(vector, index);
+            }
+            return value;
+        }
+};
+
+TEST_F(PipelineFixture, StreamsBatchesInOrder)
+{
+    write_inputs("inputs", 1000);
+    int descriptor = ::open(path("inputs").c_str(), O_RDONLY);
+    ASSERT_GE(descriptor, 0);
+    std::vector<int> counts;
+    std::vector<std::vector<double>> outputs;
+    long long processed = math::apply_to_stream(W, descriptor, [&](const math::DynamicMatrix<double>& batch, int count)
+    {
+        counts.push_back(count);
+        for(int row = 0; row < count; ++row)
+        {
+            outputs.emplace_back(batch(row).data(), batch(row).data() + batch(row).length());
+        }
+    }, 64);
+    ::close(descriptor);
+
+    ASSERT_EQ(processed, 1000);
+    ASSERT_EQ(counts.size(), 16u);
+    ASSERT_EQ(counts.back(), 1000 - 15*64);
+    ASSERT_EQ(outputs.size(), 1000u);
+    for(int vector = 0; vector < 1000; ++vector)
+    {
+        ASSERT_EQ(outputs[vector].size(), 5u);
+        for(int row = 0; row < 5; ++row)
+        {
+            ASSERT_NEAR(outputs[vector][row], expected(vector, row), 1e-12);
+        }
+    }
+}
+
+TEST_F(PipelineFixture, DescriptorSinkWritesRawVectors)
+{
+    write_inputs("inputs", 300);
+    int input_descriptor = ::open(path("inputs").c_str(), O_RDONLY);
+    int output_descriptor = ::open(path("outputs").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(input_descriptor, 0);
+    ASSERT_GE(output_descriptor, 0);
+    ASSERT_EQ(math::apply_to_stream(W, input_descriptor, math::DescriptorSink<double>{output_descriptor}, 100), 300);
+    ::close(input_descriptor);
+    ::close(output_descriptor);
+
+    ASSERT_EQ(std::filesystem::file_size(path("outputs")), 300*5*sizeof(double));
+    std::vector<double> values(300*5);
+    int descriptor = ::open(path("outputs").c_str(), O_RDONLY);
+    ASSERT_EQ(::read(descriptor, values.data(), values.size()*sizeof(double)), static_cast<ssize_t>(values.size()*sizeof(double)));
+    ::close(descriptor);
+    for(int vector = 0; vector < 300; ++vector)
+    {
+        for(int row = 0; row < 5; ++row)
+        {
+            ASSERT_NEAR(values[5*vector + row], expected(vector, row), 1e-12);
+        }
+    }
+}
+
+TEST_F(PipelineFixture, EmptyStream)
+{
+    write_inputs("inputs", 0);
+    int descriptor = ::open(path("inputs").c_str(), O_RDONLY);
+    int calls = 0;
+    ASSERT_EQ(math::apply_to_stream(W, descriptor, [&](const math::DynamicMatrix<double>&, int) { ++calls; }), 0);
+    ::close(descriptor);
+    ASSERT_EQ(calls, 0);
+}
+
+TEST_F(PipelineFixture, TruncatedVectorThrows)
+{
+    write_inputs("inputs", 10, 3);
+    int descriptor = ::open(path("inputs").c_str(), O_RDONLY);
+    ASSERT_THROW(math::apply_to_stream(W, descriptor, [](const math::DynamicMatrix<double>&, int) {}, 4), math::FileError);
+    ::close(descriptor);
+}
+
+TEST_F(PipelineFixture, SinkErrorStopsPipeline)
+{
+    write_inputs("inputs", 1000);
+    int descriptor = ::open(path("inputs").c_str(), O_RDONLY);
+    int calls = 0;
+    ASSERT_THROW(math::apply_to_stream(W, descriptor, [&](const math::DynamicMatrix<double>&, int)
+    {
+        if(++calls == 2)
+        {
+            throw std::runtime_error("sink failed");
+        }
+    }, 16), std::runtime_error);
+    ::close(descriptor);
+    ASSERT_EQ(calls, 2);
+}
+
+TEST_F(PipelineFixture, SinkErrorStopsReaderWaitingOnPipe)
+{
+    // The write end stays open, so the reader is left waiting for more vectors
+    int descriptors[2];
+    ASSERT_EQ(::pipe(descriptors), 0);
+    std::vector<double> values(4*7, 0.5);
+    ASSERT_EQ(::write(descriptors[1], values.data(), values.size()*sizeof(double)), static_cast<ssize_t>(values.size()*sizeof(double)));
+    ASSERT_THROW(math::apply_to_stream(W, descriptors[0], [](const math::DynamicMatrix<double>&, int)
+    {
+        throw std::runtime_error("sink failed");
+    }, 4), std::runtime_error);
+    ::close(descriptors[0]);
+    ::close(descriptors[1]);
+}
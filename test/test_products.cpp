@@ -1,8 +1,13 @@
 #include "matrix/products.hpp"
 #include "matrix/dynamic.hpp"
+#include "test_helpers.hpp"
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+
 class ScalarProductVector: public ::testing::Test
 {
     protected:
@@ -98,6 +103,24 @@ TEST_F(ScalarProductMatrix, StaticMatrixScalar)
     ASSERT_TRUE(math::all_equal(static_matrix*factor, answer));
 }
 
+// multiply() stays the elementwise product with products.hpp, and so complex.hpp, included
+TEST_F(ScalarProductMatrix, ElementwiseMultiply)
+{
+    decltype(dynamic_matrix) dynamic_answer = {
+        {1, 4},
+        {9, 16}
+    };
+    ASSERT_TRUE(math::all_equal(math::multiply(dynamic_matrix, dynamic_matrix), dynamic_answer));
+    decltype(static_matrix) static_answer = {
+        {1, 4},
+        {9, 16}
+    };
+    ASSERT_TRUE(math::all_equal(math::multiply(static_matrix, static_matrix), static_answer));
+    math::DynamicVectori vector = {1, 2, 3};
+    math::DynamicVectori squares = {1, 4, 9};
+    ASSERT_TRUE(math::all_equal(math::multiply(vector, vector), squares));
+}
+
 class ScalarProductTensor: public ::testing::Test
 {
     protected:
@@ -461,4 +484,197 @@ TEST_F(OuterProductFixture, DynamicVectorVector)
         {dynamic_vector1(1)*dynamic_vector2(0), dynamic_vector1(1)*dynamic_vector2(1)}
     };
     ASSERT_TRUE(math::all_equal(result, answer));
-}
\ No newline at end of file
+}
+
+class GemmFixture: public ::testing::Test
+{
+    protected:
+        math::DynamicMatrixd A = {
+            {1.0, 2.0, 3.0},
+            {4.0, 5.0, 6.0}
+        };
+        math::DynamicMatrixd B = {
+            {7.0, 8.0},
+            {9.0, 10.0},
+            {11.0, 12.0}
+        };
+        math::DynamicMatrixd AB = {
+            {58.0, 64.0},
+            {139.0, 154.0}
+        };
+
+        math::DynamicMatrixd transpose(const math::DynamicMatrixd& matrix)
+        {
+            math::DynamicMatrixd transposed(matrix(0).length(), matrix.length());
+            for(int row = 0; row < matrix.length(); ++row)
+            {
+                for(int column = 0; column < matrix(0).length(); ++column)
+                {
+                    transposed(column,row) = matrix(row,column);
+                }
+            }
+            return transposed;
+        }
+};
+
+TEST_F(GemmFixture, NoTranspose)
+{
+    math::DynamicMatrixd C(2, 2);
+    math::gemm(1.0, A, B, 0.0, C);
+    ASSERT_TRUE(math::all_equal(C, AB));
+}
+
+TEST_F(GemmFixture, TransposedOperands)
+{
+    auto At = transpose(A);
+    auto Bt = transpose(B);
+    math::DynamicMatrixd C(2, 2);
+    math::gemm(1.0, At, math::Transpose::Yes, B, math::Transpose::No, 0.0, C);
+    ASSERT_TRUE(math::all_equal(C, AB));
+    math::gemm(1.0, A, math::Transpose::No, Bt, math::Transpose::Yes, 0.0, C);
+    ASSERT_TRUE(math::all_equal(C, AB));
+    math::gemm(1.0, At, math::Transpose::Yes, Bt, math::Transpose::Yes, 0.0, C);
+    ASSERT_TRUE(math::all_equal(C, AB));
+}
+
+TEST_F(GemmFixture, AlphaBetaAccumulate)
+{
+    math::DynamicMatrixd C = {
+        {1.0, 1.0},
+        {1.0, 1.0}
+    };
+    math::gemm(2.0, A, B, 3.0, C);
+    math::DynamicMatrixd answer = {
+        {119.0, 131.0},
+        {281.0, 311.0}
+    };
+    ASSERT_TRUE(math::all_equal(C, answer));
+}
+
+TEST_F(GemmFixture, BetaZeroIgnoresNaN)
+{
+    math::DynamicMatrixd C(2, 2);
+    C.fill(std::nan(""));
+    math::gemm(1.0, A, B, 0.0, C);
+    ASSERT_TRUE(math::all_equal(C, AB));
+}
+
+TEST_F(GemmFixture, MismatchedShapesThrow)
+{
+    math::DynamicMatrixd C(2, 2);
+    ASSERT_THROW(math::gemm(1.0, A, A, 0.0, C), math::MismatchedLength);
+    math::DynamicMatrixd wrong_output(3, 3);
+    ASSERT_THROW(math::gemm(1.0, A, B, 0.0, wrong_output), math::MismatchedLength);
+}
+
+TEST_F(GemmFixture, Gemv)
+{
+    math::DynamicVectord x = {1.0, -1.0, 2.0};
+    math::DynamicVectord y = {1.0, 2.0};
+    math::gemv(1.0, A, x, 2.0, y);
+    math::DynamicVectord answer = {7.0, 15.0};
+    ASSERT_TRUE(math::all_equal(y, answer));
+
+    math::DynamicVectord z = {1.0, 1.0};
+    math::DynamicVectord w(3);
+    math::gemv(1.0, A, math::Transpose::Yes, z, 0.0, w);
+    math::DynamicVectord column_sums = {5.0, 7.0, 9.0};
+    ASSERT_TRUE(math::all_equal(w, column_sums));
+}
+
+TEST(GemmLarge, MatchesNaiveProduct)
+{
+    int m = 37, k = 300, n = 45;
+    math::DynamicMatrixi A(m, k);
+    math::DynamicMatrixi B(k, n);
+    for(int row = 0; row < m; ++row)
+    {
+        for(int column = 0; column < k; ++column)
+        {
+            A(row,column) = (row*7 + column*3) % 11 - 5;
+        }
+    }
+    for(int row = 0; row < k; ++row)
+    {
+        for(int column = 0; column < n; ++column)
+        {
+            B(row,column) = (row*5 + column) % 13 - 6;
+        }
+    }
+    math::DynamicMatrixi C = A*B;
+    for(int row = 0; row < m; ++row)
+    {
+        for(int column = 0; column < n; ++column)
+        {
+            int expected = 0;
+            for(int inner = 0; inner < k; ++inner)
+            {
+                expected += A(row,inner)*B(inner,column);
+            }
+            ASSERT_EQ(C(row,column), expected);
+        }
+    }
+}
+
+class StrassenFixture: public test_helpers::PooledFixture
+{
+    protected:
+        template <typename T>
+        static math::DynamicMatrix<T> pattern(int rows, int columns, int seed)
+        {
+            math::DynamicMatrix<T> matrix(rows, columns);
+            for(int row = 0; row < rows; ++row)
+            {
+                for(int column = 0; column < columns; ++column)
+                {
+                    matrix(row,column) = static_cast<T>((row*7 + column*3 + seed) % 11 - 5);
+                }
+            }
+            return matrix;
+        }
+};
+
+TEST_F(StrassenFixture, DisabledByDefault)
+{
+    ASSERT_EQ(math::strassen_crossover(), 0);
+    {
+        math::ScopedStrassen strassen(8);
+        ASSERT_EQ(math::strassen_crossover(), 8);
+    }
+    ASSERT_EQ(math::strassen_crossover(), 0);
+}
+
+TEST_F(StrassenFixture, ExactOnIntegersWithOddDimensions)
+{
+    math::ScopedStrassen strassen(4);
+    for(auto [m, k, n] : {std::array<int, 3>{64, 64, 64}, {37, 53, 41}, {50, 33, 65}, {9, 9, 9}})
+    {
+        math::DynamicMatrixi A = pattern<int>(m, k, 1);
+        math::DynamicMatrixi B = pattern<int>(k, n, 2);
+        math::DynamicMatrixi expected(m, n);
+        math::gemm(1, A, B, 0, expected);
+        math::DynamicMatrixi C = A*B;
+        ASSERT_TRUE(math::all_equal(C, expected)) << m << " x " << k << " x " << n;
+    }
+}
+
+TEST_F(StrassenFixture, WithinNormwiseBound)
+{
+    int n = 257;
+    math::DynamicMatrixd A = test_helpers::random_matrix(n, n, 3);
+    math::DynamicMatrixd B = test_helpers::random_matrix(n, n, 4);
+    math::DynamicMatrixd expected(n, n);
+    math::gemm(1.0, A, B, 0.0, expected);
+    math::DynamicMatrixd C(n, n);
+    math::strassen_multiply(A, B, C, 16);
+    double max_error = 0.0;
+    for(int row = 0; row < n; ++row)
+    {
+        for(int column = 0; column < n; ++column)
+        {
+            max_error = std::max(max_error, std::abs(C(row,column) - expected(row,column)));
+        }
+    }
+    // ||A|| ||B|| is about n/12 in the max norm for these entries
+    ASSERT_LT(max_error, 1e-12*n);
+}
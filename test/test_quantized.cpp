@@ -0,0 +1,136 @@
+#include "matrix/quantized.hpp"
+#include "matrix/products.hpp"
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+
+class QuantizedFixture: public test_helpers::PooledFixture
+{
+    protected:
+        // Random float matrix with every entry shifted by offset
+        static math::DynamicMatrixf shifted_matrix(int rows, int columns, unsigned seed, float offset = 0.0f)
+        {
+            math::DynamicMatrixf matrix = test_helpers::random_matrix<float>(rows, columns, seed);
+            for(int row = 0; row < rows; ++row)
+            {
+                for(int column = 0; column < columns; ++column)
+                {
+                    matrix(row, column) += offset;
+                }
+            }
+            return matrix;
+        }
+
+        template <typename L, typename R>
+        static void check_integer_gemm(int m, int n, int k)
+        {
+            math::DynamicMatrix<L> A(m, k);
+            math::DynamicMatrix<R> B(n, k);
+            unsigned seed = 7;
+            auto next = [&seed]
+            {
+                return static_cast<int>(test_helpers::next_random(seed) >> 24);
+            };
+            for(int row = 0; row < m; ++row)
+            {
+                for(int inner = 0; inner < k; ++inner)
+                {
+                    A(row, inner) = static_cast<L>(next());
+                }
+            }
+            for(int row = 0; row < n; ++row)
+            {
+                for(int inner = 0; inner < k; ++inner)
+                {
+                    B(row, inner) = static_cast<R>(next());
+                }
+            }
+            // Extreme values that would saturate 16-bit pair sums
+            A(0, 0) = std::is_signed_v<L> ? -128 : 255;
+            A(0, 1) = std::is_signed_v<L> ? -128 : 255;
+            B(0, 0) = std::is_signed_v<R> ? -128 : 255;
+            B(0, 1) = std::is_signed_v<R> ? -128 : 255;
+            math::DynamicMatrixi C;
+            math::integer_gemm(A, B, C);
+            for(int row = 0; row < m; ++row)
+            {
+                for(int column = 0; column < n; ++column)
+                {
+                    int expected = 0;
+                    for(int inner = 0; inner < k; ++inner)
+                    {
+                        expected += static_cast<int>(A(row, inner))*static_cast<int>(B(column, inner));
+                    }
+                    ASSERT_EQ(C(row, column), expected);
+                }
+            }
+        }
+};
+
+TEST_F(QuantizedFixture, IntegerGemmIsExact)
+{
+    check_integer_gemm<std::uint8_t, std::int8_t>(9, 13, 200);
+    check_integer_gemm<std::int8_t, std::uint8_t>(5, 4, 77);
+    check_integer_gemm<std::int8_t, std::int8_t>(6, 70, 129);
+    check_integer_gemm<std::uint8_t, std::uint8_t>(3, 3, 3);
+}
+
+TEST_F(QuantizedFixture, RoundTripWithinHalfStep)
+{
+    auto matrix = shifted_matrix(8, 50, 1, 0.3f);
+    for(auto granularity : {math::Granularity::PerRow, math::Granularity::PerTensor})
+    {
+        auto weights = math::quantize<std::int8_t>(matrix, granularity);
+        auto activations = math::quantize<std::uint8_t>(matrix, granularity);
+        ASSERT_EQ(weights.scales.length(), granularity == math::Granularity::PerRow ? 8 : 1);
+        auto from_weights = math::dequantize(weights);
+        auto from_activations = math::dequantize(activations);
+        for(int row = 0; row < 8; ++row)
+        {
+            ASSERT_EQ(weights.zero_point(row), 0);
+            for(int column = 0; column < 50; ++column)
+            {
+                ASSERT_LE(std::abs(from_weights(row, column) - matrix(row, column)), 0.5001f*weights.scale(row));
+                ASSERT_LE(std::abs(from_activations(row, column) - matrix(row, column)), 0.5001f*activations.scale(row));
+            }
+        }
+    }
+    math::DynamicMatrixf zeros(2, 3);
+    zeros.fill(0.0f);
+    auto quantized = math::quantize<std::uint8_t>(zeros);
+    ASSERT_TRUE(math::all_equal(math::dequantize(quantized), zeros));
+}
+
+TEST_F(QuantizedFixture, ProductsMatchDequantized)
+{
+    auto inputs = math::quantize<std::uint8_t>(shifted_matrix(20, 300, 2, 0.2f), math::Granularity::PerTensor);
+    auto weights = math::quantize<std::int8_t>(shifted_matrix(40, 300, 3));
+    auto result = math::quantized_gemm(inputs, weights);
+
+    math::DynamicMatrixf expected(20, 40);
+    math::gemm(1.0f, math::dequantize(inputs), math::Transpose::No, math::dequantize(weights), math::Transpose::Yes, 0.0f, expected);
+    for(int row = 0; row < 20; ++row)
+    {
+        for(int column = 0; column < 40; ++column)
+        {
+            ASSERT_NEAR(result(row, column), expected(row, column), 1e-4f);
+        }
+    }
+
+    auto x = shifted_matrix(1, 300, 4, 0.1f);
+    math::DynamicVectorf vector(300);
+    for(int index = 0; index < 300; ++index)
+    {
+        vector(index) = x(0, index);
+    }
+    auto y = math::quantized_gemv(weights, vector);
+    auto exact = math::dequantize(weights)*vector;
+    for(int row = 0; row < 40; ++row)
+    {
+        // Only x's own quantization error remains, at most half a step per element
+        ASSERT_NEAR(y(row), exact(row), 0.05f);
+    }
+}
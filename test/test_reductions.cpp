@@ -0,0 +1,142 @@
+#include "matrix/reductions.hpp"
+
+#include <gtest/gtest.h>
+
+class ReductionFixture: public ::testing::Test
+{
+    protected:
+        math::DynamicVectord vector = {3.0, -1.0, 4.0, 1.0, -5.0, 9.0};
+        math::StaticVectori<4> static_vector = {2, 7, 1, 8};
+        math::DynamicMatrixd matrix = {
+            {1.0, 5.0, -2.0},
+            {4.0, -3.0, 6.0}
+        };
+        math::StaticArrayi<2,3> static_matrix = {
+            {1, 5, -2},
+            {4, -3, 6}
+        };
+};
+
+TEST_F(ReductionFixture, SumDynamicVector)
+{
+    ASSERT_DOUBLE_EQ(math::sum(vector), 11.0);
+}
+
+TEST_F(ReductionFixture, SumStaticVector)
+{
+    ASSERT_EQ(math::sum(static_vector), 18);
+}
+
+TEST_F(ReductionFixture, SumDynamicMatrix)
+{
+    ASSERT_DOUBLE_EQ(math::sum(matrix), 11.0);
+}
+
+TEST_F(ReductionFixture, SumStaticMatrix)
+{
+    ASSERT_EQ(math::sum(static_matrix), 11);
+}
+
+TEST_F(ReductionFixture, MeanStaticVector)
+{
+    ASSERT_DOUBLE_EQ(math::mean(static_vector), 4.5);
+}
+
+TEST_F(ReductionFixture, MinMax)
+{
+    ASSERT_DOUBLE_EQ(math::min(vector), -5.0);
+    ASSERT_DOUBLE_EQ(math::max(vector), 9.0);
+    ASSERT_EQ(math::min(static_matrix), -3);
+    ASSERT_EQ(math::max(static_matrix), 6);
+}
+
+TEST_F(ReductionFixture, ArgMinArgMaxFlattened)
+{
+    ASSERT_EQ(math::argmin(vector), 4);
+    ASSERT_EQ(math::argmax(vector), 5);
+    ASSERT_EQ(math::argmin(matrix), 4);
+    ASSERT_EQ(math::argmax(static_matrix), 5);
+}
+
+TEST_F(ReductionFixture, EmptyMinThrows)
+{
+    math::DynamicVectord empty;
+    ASSERT_THROW(math::min(empty), math::OutOfRange);
+}
+
+TEST_F(ReductionFixture, SumAxis0)
+{
+    math::DynamicVectord answer = {5.0, 2.0, 4.0};
+    ASSERT_TRUE(math::all_equal(math::sum(matrix, 0), answer));
+}
+
+TEST_F(ReductionFixture, SumAxis1)
+{
+    math::DynamicVectord answer = {4.0, 7.0};
+    ASSERT_TRUE(math::all_equal(math::sum(matrix, 1), answer));
+}
+
+TEST_F(ReductionFixture, MeanAxis)
+{
+    math::DynamicVectord answer0 = {2.5, 1.0, 2.0};
+    math::DynamicVectord answer1 = {4.0/3.0, 7.0/3.0};
+    ASSERT_TRUE(math::all_equal(math::mean(matrix, 0), answer0));
+    ASSERT_TRUE(math::all_equal(math::mean(matrix, 1), answer1));
+}
+
+TEST_F(ReductionFixture, MinMaxAxis)
+{
+    math::DynamicVectord min0 = {1.0, -3.0, -2.0};
+    math::DynamicVectord max1 = {5.0, 6.0};
+    ASSERT_TRUE(math::all_equal(math::min(matrix, 0), min0));
+    ASSERT_TRUE(math::all_equal(math::max(matrix, 1), max1));
+}
+
+TEST_F(ReductionFixture, ArgMinArgMaxAxis)
+{
+    math::DynamicVectori argmax0 = {1, 0, 1};
+    math::DynamicVectori argmin1 = {2, 1};
+    ASSERT_TRUE(math::all_equal(math::argmax(matrix, 0), argmax0));
+    ASSERT_TRUE(math::all_equal(math::argmin(matrix, 1), argmin1));
+}
+
+TEST_F(ReductionFixture, InvalidAxisThrows)
+{
+    ASSERT_THROW(math::sum(matrix, 2), math::InvalidAxis);
+    ASSERT_THROW(math::sum(matrix, -1), math::InvalidAxis);
+}
+
+TEST(ReductionThreeDimensional, SumEachAxis)
+{
+    math::DynamicArrayi<3> array = {
+        {{1, 2}, {3, 4}, {5, 6}},
+        {{7, 8}, {9, 10}, {11, 12}}
+    };
+    math::DynamicMatrixi sum0 = {{8, 10}, {12, 14}, {16, 18}};
+    math::DynamicMatrixi sum1 = {{9, 12}, {27, 30}};
+    math::DynamicMatrixi sum2 = {{3, 7, 11}, {15, 19, 23}};
+    ASSERT_TRUE(math::all_equal(math::sum(array, 0), sum0));
+    ASSERT_TRUE(math::all_equal(math::sum(array, 1), sum1));
+    ASSERT_TRUE(math::all_equal(math::sum(array, 2), sum2));
+    ASSERT_EQ(math::sum(array), 78);
+}
+
+TEST(ReductionAccuracy, PairwiseSumOfManyTerms)
+{
+    int length = 1000000;
+    math::DynamicVectorf values(length);
+    values.fill(0.1f);
+    double exact = length*static_cast<double>(0.1f);
+    ASSERT_NEAR(math::sum(values), exact, 1e-6*exact);
+}
+
+TEST(ReductionAccuracy, CompensatedAxisSum)
+{
+    int rows = 100000;
+    math::DynamicMatrixf values(rows, 2);
+    values.fill(0.1f);
+    auto column_sums = math::sum(values, 0);
+    double exact = rows*static_cast<double>(0.1f);
+    ASSERT_NEAR(column_sums(0), exact, 1e-6*exact);
+    ASSERT_NEAR(column_sums(1), exact, 1e-6*exact);
+}
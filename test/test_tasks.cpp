@@ -0,0 +1,185 @@
+#include "matrix/tasks.hpp"
+#include "matrix/tiled.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(TaskGraph, DataFlowOrder)
+{
+    for(int repeat = 0; repeat < 20; ++repeat)
+    {
+        math::TaskGraph graph;
+        int value = 0;
+        int first_read = -1;
+        int second_read = -1;
+        graph.add([&]{ value = 1; }, {{0, math::Access::Write}});
+        graph.add([&]{ first_read = value; }, {{0, math::Access::Read}});
+        graph.add([&]{ second_read = value; }, {{0, math::Access::Read}});
+        graph.add([&]{ value = 2; }, {{0, math::Access::Write}});
+        graph.run(4);
+        ASSERT_EQ(first_read, 1);
+        ASSERT_EQ(second_read, 1);
+        ASSERT_EQ(value, 2);
+    }
+}
+
+TEST(TaskGraph, IndependentTasksAllRun)
+{
+    math::TaskGraph graph;
+    std::atomic<int> count{0};
+    for(int index = 0; index < 100; ++index)
+    {
+        graph.add([&]{ ++count; }, {{index, math::Access::Write}});
+    }
+    ASSERT_EQ(graph.size(), 100);
+    graph.run(8);
+    ASSERT_EQ(count.load(), 100);
+}
+
+TEST(TaskGraph, PriorityOrdersReadyTasks)
+{
+    math::TaskGraph graph;
+    std::vector<int> order;
+    graph.add([&]{ order.push_back(0); }, {{0, math::Access::Write}}, 0);
+    graph.add([&]{ order.push_back(1); }, {{1, math::Access::Write}}, 5);
+    graph.add([&]{ order.push_back(2); }, {{2, math::Access::Write}}, 1);
+    graph.run(1);
+    std::vector<int> expected = {1, 2, 0};
+    ASSERT_EQ(order, expected);
+}
+
+TEST(TaskGraph, RethrowsTaskException)
+{
+    math::TaskGraph graph;
+    bool ran_after = false;
+    graph.add([]{ throw std::runtime_error("task failed"); }, {{0, math::Access::Write}});
+    graph.add([&]{ ran_after = true; }, {{0, math::Access::Read}});
+    ASSERT_THROW(graph.run(2), std::runtime_error);
+    ASSERT_FALSE(ran_after);
+}
+
+TEST(TaskGraph, Empty)
+{
+    math::TaskGraph graph;
+    graph.run(4);
+    ASSERT_EQ(graph.size(), 0);
+}
+
+TEST(TaskGraph, RunsOnCurrentExecutor)
+{
+    math::SerialExecutor serial;
+    math::ScopedExecutor scoped(&serial);
+    math::TaskGraph graph;
+    std::atomic<int> elsewhere{0};
+    std::thread::id caller = std::this_thread::get_id();
+    for(int index = 0; index < 20; ++index)
+    {
+        graph.add([&]{ elsewhere += std::this_thread::get_id() != caller; }, {{index, math::Access::Write}});
+    }
+    graph.run(8);
+    ASSERT_EQ(elsewhere.load(), 0);
+}
+
+TEST(TaskGraph, TasksRunParallelLoopsOnThePool)
+{
+    // Pool threads waiting for a task's loop pick up graph workers, which must not block
+    math::ThreadPool pool{3};
+    math::ScopedExecutor scoped(&pool);
+    for(int repeat = 0; repeat < 20; ++repeat)
+    {
+        math::TaskGraph graph;
+        std::vector<long long> sums(16, 0);
+        for(int index = 0; index < 16; ++index)
+        {
+            graph.add([&, index]
+            {
+                sums[index] = math::parallel_reduce(0, 1 << 16, 1 << 10, 0LL, [](int begin, int end)
+                {
+                    long long sum = 0;
+                    for(int value = begin; value < end; ++value)
+                    {
+                        sum += value;
+                    }
+                    return sum;
+                }, std::plus<long long>());
+            }, {{index % 4, math::Access::Write}});
+        }
+        graph.run();
+        for(long long sum : sums)
+        {
+            ASSERT_EQ(sum, (1LL << 16)*((1LL << 16) - 1)/2);
+        }
+    }
+}
+
+class TiledFixture: public ::testing::Test
+{
+    protected:
+        int N = 70;
+        math::DynamicMatrixd spd;
+        math::DynamicMatrixd general;
+
+        void SetUp() override
+        {
+            spd.allocate(N, N);
+            general.allocate(N, N);
+            for(int row = 0; row < N; ++row)
+            {
+                for(int column = 0; column < N; ++column)
+                {
+                    spd(row,column) = 1.0/(1 + std::abs(row - column)) + (row == column ? N : 0.0);
+                    general(row,column) = std::sin(row*3.0 + column*5.0);
+                }
+            }
+        }
+
+        void expect_near(const math::DynamicMatrixd& left, const math::DynamicMatrixd& right, double tolerance)
+        {
+            for(int row = 0; row < left.length(); ++row)
+            {
+                for(int column = 0; column < left(row).length(); ++column)
+                {
+                    ASSERT_NEAR(left(row,column), right(row,column), tolerance);
+                }
+            }
+        }
+};
+
+TEST_F(TiledFixture, CholeskyMatchesSerial)
+{
+    math::DynamicCholeskyDecomposition serial(spd);
+    math::ThreadPool pool{3};
+    math::ScopedExecutor scoped(&pool);
+    for(int threads : {1, 4})
+    {
+        auto tiled = math::tiled_cholesky(spd, 16, threads);
+        expect_near(tiled.cholesky, serial.cholesky, 1e-12);
+    }
+}
+
+TEST_F(TiledFixture, CholeskyNotPositiveDefinite)
+{
+    spd(40,40) = -1000.0;
+    ASSERT_THROW(math::tiled_cholesky(spd, 16, 4), math::NotPositiveDefinite);
+}
+
+TEST_F(TiledFixture, LUFactorsGeneralMatrix)
+{
+    math::DynamicLUDecomposition serial(general);
+    math::ThreadPool pool{3};
+    math::ScopedExecutor scoped(&pool);
+    for(int threads : {1, 4})
+    {
+        auto tiled = math::tiled_lu(general, 16, threads);
+        ASSERT_TRUE(math::all_equal(tiled.P, serial.P));
+        ASSERT_EQ(tiled.permutation_sign, serial.permutation_sign);
+        expect_near(tiled.L*tiled.U, general(tiled.P), 1e-12);
+        expect_near(tiled.U, serial.U, 1e-10);
+    }
+}